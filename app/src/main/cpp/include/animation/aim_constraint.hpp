@@ -0,0 +1,63 @@
+#pragma once
+#include "ik_chain.hpp"
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+namespace ve{
+    struct AimJoint{
+        int joint = -1;
+        //share of the rotation this joint takes, relative to the joints below it in the chain
+        float weight = 1.0f;
+        //largest rotation away from the animated pose, radians
+        float maxAngle = 3.14159265f;
+    };
+
+    // Rotates a chain (neck -> head) so a local axis of its last joint points at a world space target.
+    struct AimConstraint{
+        //root first, every joint down to the aim joint
+        std::vector<AimJoint> chain;
+        //axis of the last joint that points at the target, in that joint's model space frame
+        glm::vec3 forward{0.0f, 0.0f, 1.0f};
+        glm::vec3 target{0.0f};
+        //0 keeps the animated pose, 1 aims straight at the target
+        float weight = 1.0f;
+        bool enabled = true;
+    };
+
+    // Look-at and aim constraints of one skeleton, evaluated after sampling once the model matrices are
+    // current. Each joint takes its weight's share of the rotation still missing, clamped to its maximum
+    // angle, and the rest is left to the joints below it: one pass down the chain, no iteration. The
+    // rotations applied so far are tracked as one rigid transform instead of recomputing matrices, so a
+    // constraint costs O(chain length). Constraints run in skeleton order (roots first); a constraint
+    // below another one's chain refreshes the dirty matrices before it reads them. The joints are marked
+    // dirty, the caller runs updateDirty.
+    class AimConstraintSet{
+        public:
+            //chain from root to aimJoint with equal weights, index of the constraint or -1
+            int add(const Skeleton& skeleton, int root, int aimJoint, const glm::vec3& forward, float maxAngle);
+            int add(const Skeleton& skeleton, const std::string& root, const std::string& aimJoint, const glm::vec3& forward, float maxAngle);
+            bool setJoint(int constraint, int joint, float weight, float maxAngle);
+            AimConstraint& get(int constraint) {return constraints[constraint];}
+            size_t size() const {return constraints.size();}
+            bool empty() const {return constraints.empty();}
+            void clear();
+            //places the skeleton's model space in the world, targets are transformed with its inverse
+            void setObjectMatrix(const glm::mat4& objectMatrix);
+            //all enabled constraints, returns how many were evaluated
+            size_t apply(Skeleton& skeleton);
+
+            //also clamp with Skeleton::jointLimits when the skeleton has them
+            bool useLimits = true;
+        private:
+            void solve(Skeleton& skeleton, const AimConstraint& constraint, const glm::vec3& target, const JointLimit* limits) const;
+            void sortConstraints(const Skeleton& skeleton);
+
+            std::vector<AimConstraint> constraints;
+            //evaluation order and whether an earlier constraint moves a joint above the root
+            std::vector<int> order;
+            std::vector<bool> readsMoved;
+            glm::mat4 worldToModel{1.0f};
+    };
+}
@@ -1,10 +1,17 @@
 #pragma once
 #include "skeleton.hpp"
+#include "compressed_track.hpp"
+#include "pose.hpp"
+#include "sampler_store.hpp"
+#include <map>
 #include <string>
+#include <vector>
 #include <memory>
 
 namespace ve{
     
+    class SkeletonDefinition;
+
     class Animation{
         public:
             enum class PathType {
@@ -22,19 +29,146 @@ namespace ve{
                 int samplerIndex; 
                 int node;
             };
+            using SharedKeys = ve::SharedKeys;
             struct Sampler{
                 std::vector<float> timeStamps;
                 std::vector<glm::vec4> TRSoutputValues;
                 InterpolationMethod interpolationMethod;
+                //set when the keys are shared or stored quantized, timeStamps and TRSoutputValues are then empty
+                std::shared_ptr<const SharedKeys> shared;
+                std::shared_ptr<const CompressedTrack> compressed;
+                //keys are spaced 1/uniformRate apart from uniformStart (baked clips), 0 if irregular. Uniform float
+                //samplers store no timeStamps, key times follow from the index
+                float uniformRate = 0.0f;
+                float uniformStart = 0.0f;
+
+                bool isUniform() const{return uniformRate > 0.0f;}
+                size_t keyCount() const{return compressed ? compressed->keyCount() : isUniform() ? floatValues().size() : floatTimes().size();}
+                float keyTime(size_t i) const{
+                    return compressed ? compressed->keyTime(i) : isUniform() ? uniformStart + static_cast<float>(i) / uniformRate : floatTimes()[i];
+                }
+                glm::vec4 keyValue(size_t i) const{return compressed ? compressed->keyValue(i) : floatValues()[i];}
+                //float keys, owned or shared (empty when compressed, times empty when uniform)
+                const std::vector<float>& floatTimes() const{return shared ? shared->timeStamps : timeStamps;}
+                //every key time, generated for uniform samplers
+                std::vector<float> keyTimes() const;
+                //owned float keys with explicit times and no rate, before inserting keys that break the spacing
+                void makeIrregular();
+                const std::vector<glm::vec4>& floatValues() const{return shared ? shared->values : TRSoutputValues;}
+                //move owned float keys into shared storage (interned in SamplerStore::global) so copies of
+                //the sampler and identical samplers of other clips do not duplicate them, returns the bytes saved
+                size_t share();
+                size_t byteSize() const;
+            };
+            //rest pose compensation of a channel retargeted from another skeleton
+            struct ChannelRemap{
+                glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};   //pre-multiplied onto sampled rotations
+                glm::vec3 factor{1.0f};                       //scales sampled translations and scales
+                glm::vec3 offset{0.0f};                       //added to sampled translations
             };
+            //sentinel returned by findKeyframe when the time lies outside the sampler range
+            static constexpr size_t NO_KEYFRAME = static_cast<size_t>(-1);
+
             Animation(std::string const& name);
             void start();
             void stop();
             bool isRunning() const;
             bool willExpire(const float& deltaTime )const; 
             void update(const float& deltaTime, Skeleton& skeleton);
+            //move the clip time forward like update without sampling, returns the clip time advanced
+            float advance(const float& deltaTime);
+            //clip time a frame of deltaTime moves at the playback speed, with a minimum step for slow speeds
+            float playbackStep(float deltaTime) const;
+            //time past the last key of a repeating clip carried into the clip range, other times unchanged
+            float wrapTime(float time) const;
             void updatePose(Skeleton& skeleton);
+            //channel -> joint resolution against one skeleton, built once so the sampling loops do no
+            //node lookups. Targets are grouped by path type in flat arrays indexed by PathType.
+            struct Binding{
+                struct Target{
+                    uint32_t channel;
+                    uint32_t sampler;
+                    int32_t joint;
+                };
+                std::vector<Target> targets[3];
+                //channels whose node is not a joint of the skeleton, never sampled
+                std::vector<uint32_t> unboundChannels;
+                const Skeleton* skeleton = nullptr;
+                const SkeletonDefinition* definition = nullptr;
+                size_t channelCount = 0;
+                size_t jointCount = 0;
+
+                const std::vector<Target>& operator[](PathType path) const{return targets[static_cast<int>(path)];}
+            };
+            //resolve every channel against skeleton, logs the channels that cannot be bound
+            Binding bind(const Skeleton& skeleton) const;
+            //cached binding, rebuilt only when the skeleton or the channel list changed
+            const Binding& getBinding(const Skeleton& skeleton);
+            //same against a shared rig, for sampling into SkeletonInstance poses
+            Binding bind(const SkeletonDefinition& definition) const;
+            const Binding& getBinding(const SkeletonDefinition& definition);
+            //drop the cached bindings, e.g. on a copy that will be played on another skeleton
+            void unbind(){binding = Binding{}; definitionBinding = Binding{};}
+
+            //caller owned state for batch sampling: keyframe cursors and scratch lanes. Reusing it across
+            //frames keeps sampling allocation free, one state per thread keeps it free of shared writes
+            struct SamplingState{
+                std::vector<size_t> cursors;
+                std::vector<int> joints;
+                std::vector<float> lanes;
+            };
+            //batch path: evaluate every channel at time into the SoA pose with the simd kernels,
+            //joints without a channel keep whatever the pose already holds
+            void sample(float time, const Binding& binding, Pose& pose, SamplingState& state) const;
+            //same, using the clip's own binding and state (not for concurrent use)
+            void sample(float time, const Skeleton& skeleton, Pose& pose){sample(time, getBinding(skeleton), pose, batchState);}
             void setProgress(float progress);
+            //drop cached keyframe intervals so the next sample does a binary search (call after seeking)
+            void invalidateCursors();
+            //index i such that timeStamps[i] <= time < timeStamps[i+1], advancing from cursor when possible
+            static size_t findKeyframe(const Sampler& sampler, float time, size_t& cursor);
+            struct BakeReport{
+                size_t bytesBefore = 0;
+                size_t bytesAfter = 0;
+                int bakedSamplers = 0;
+                //samplers left with their authored keys because the baked curve exceeded the error limit
+                int rejectedSamplers = 0;
+                float maxRotationError = 0.0f;
+                float maxLinearError = 0.0f;
+            };
+            //resample every channel sampler onto a fixed rate so keyframe lookup is a single index computation
+            BakeReport bake(float rate, float maxRotationError, float maxLinearError);
+            struct ReductionSettings{
+                float maxAngularError = 0.0005f;    //radians
+                float maxDistanceError = 0.0005f;   //units, for translations and for the motion of descendants
+                float maxScaleError = 0.001f;
+                //upper bound on the keys a single kept segment may span, keeps the fit linear in key count
+                size_t maxSegmentKeys = 128;
+            };
+            struct ReductionReport{
+                size_t keysBefore = 0;
+                size_t keysAfter = 0;
+                size_t bytesBefore = 0;
+                size_t bytesAfter = 0;
+            };
+            //drop keys the curve can reproduce by interpolating its neighbours within tolerance. Rotation and
+            //scale tolerances shrink with the joint's reach into its subtree so that no single channel moves a
+            //descendant by more than maxDistanceError (errors of a chain add up, at most depth * maxDistanceError).
+            //skeleton must be in rest pose, uniformly baked samplers are left alone
+            ReductionReport reduceKeys(const Skeleton& skeleton, const ReductionSettings& settings);
+            //value of the sampler curve at time, rotations are returned as x,y,z,w
+            static glm::vec4 evaluate(const Sampler& sampler, PathType pathType, float time, size_t& cursor);
+            //quantize every sampler referenced by a channel, frameRate <= 0 keeps the finest time resolution.
+            //Saves memory, not time: sampling decodes the keys and is slower than with float keys
+            void compress(float frameRate = 0.0f);
+            //make every sampler own plain float keys again, needed before editing keyframes: quantized keys are
+            //decoded (with the error baked in), shared keys are copied and channel remaps are baked into them
+            //(once per sampler, channels sharing a sampler with a different remap get a copy of their own)
+            void decompress();
+            bool isCompressed() const;
+            //error bound of the channel's sampler: radians for rotations, units otherwise, 0 if uncompressed
+            float getChannelError(size_t channelIndex) const;
+            size_t getMemoryUsage() const;
             void setPlayBackSpeed(float speed){playbackSpeed = speed;}
             void setRepeat(){isRepeat = !isRepeat;}
             void setFirstKeyFrameTime(float frameTime){firstKeyFrameTime = frameTime;}
@@ -51,14 +185,27 @@ namespace ve{
 
             std::vector<Channel> channels;
             std::vector<Sampler> samplers;
+            //parallel to channels for clips retargeted from another skeleton, empty otherwise
+            std::vector<ChannelRemap> channelRemaps;
             float currentKeyFrameTime = 0.0f;
             float playbackSpeed = 1.0f;
         private:
+            void sampleChannels(Skeleton& skeleton, bool logMissingKeyframes);
+            template<PathType PATH>
+            void sampleTargets(const std::vector<Binding::Target>& targets, Skeleton& skeleton, bool logMissingKeyframes);
+
             std::string name;
             bool isRepeat;
             bool isPaused{false};
             float firstKeyFrameTime;
             float lastKeyFrameTime;
+            //last keyframe interval hit by each channel, parallel to channels
+            std::vector<size_t> channelCursors;
+            void prepareState(SamplingState& state) const;
+            Binding bind(const std::map<int, int>& nodeJointMap, size_t jointCount, const std::string& skeletonName) const;
+            SamplingState batchState;
+            Binding binding;
+            Binding definitionBinding;
 
     };
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include "animation.hpp"
+#include "pose.hpp"
+#include "skeleton.hpp"
+#include "skeleton_definition.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace ve{
+    struct AnimationLodLevel{
+        //smallest screen size (bounding sphere diameter / viewport height) that still uses this level
+        float minScreenSize = 0.0f;
+        //poses evaluated per second, frames in between blend the last two poses. 0 evaluates every frame
+        float updateRate = 0.0f;
+        //leave the joints in Skeleton::lodMask at their last pose
+        bool skipMaskedJoints = false;
+    };
+
+    // Picks an LOD level per instance from its screen size. Levels go from the most to the least detailed,
+    // the last level is used below every threshold. Instances outside the view frustum are frozen.
+    struct AnimationLodPolicy{
+        static constexpr int FROZEN = -1;
+        //30 Hz still errs by up to 0.16 rad on fast motion, keep it to instances under 15% of the screen height
+        std::vector<AnimationLodLevel> levels{
+            {0.15f, 0.0f, false},
+            {0.06f, 30.0f, true},
+            {0.0f, 15.0f, true},
+        };
+        //relative margin an instance has to clear before moving to a more detailed level, avoids flicker
+        float hysteresis = 0.15f;
+        bool freezeOffscreen = true;
+
+        int select(float screenSize, int currentLevel) const;
+        //nullptr for FROZEN
+        const AnimationLodLevel* get(int level) const;
+    };
+
+    //bounding sphere diameter over viewport height, 0 when the sphere lies outside the view frustum
+    float computeScreenSize(const glm::vec3& center, float radius, const glm::mat4& view, const glm::mat4& projection);
+
+    // Per object state for reduced LOD playback. update() samples the clip only at the level's rate: it
+    // evaluates the pose one interval ahead and blends towards it every frame, so motion stays smooth while
+    // the key search and interpolation run a fraction of the frames. The clip time comes from the caller,
+    // objects playing one clip each keep a state and a pose of their own.
+    class AnimationLodState{
+        public:
+            //pose of skeleton's joints at time, advanced clip seconds after the previous update. Joints the
+            //level skips and joints without channels keep what pose holds, level nullptr freezes it. A paused
+            //clip leaves pose alone. Returns whether pose changed
+            bool update(float deltaTime, Animation& animation, float time, float advanced, const Skeleton& skeleton,
+                        Pose& pose, const AnimationLodLevel* level);
+            //same for a SkeletonInstance pose of definition
+            bool update(float deltaTime, Animation& animation, float time, float advanced, const SkeletonDefinition& definition,
+                        Pose& pose, const AnimationLodLevel* level);
+            //evaluate a fresh pose on the next update, e.g. after seeking
+            void reset(){primed = false;}
+        private:
+            bool update(float deltaTime, const Animation& animation, float time, float advanced, const Animation::Binding& source,
+                        const std::vector<uint8_t>& lodMask, uint32_t lodMaskVersion, Pose& pose, const AnimationLodLevel* level);
+            void rebind(const Animation& animation, const Animation::Binding& source, const std::vector<uint8_t>& lodMask,
+                        uint32_t lodMaskVersion, bool masked);
+            bool isBoundTo(const Animation& animation, const Animation::Binding& source) const;
+            float lookAhead(const Animation& animation, float time) const;
+
+            const Animation* boundAnimation = nullptr;
+            uint32_t boundMaskVersion = 0;
+            bool boundMasked = false;
+            //the clip's binding without the masked joints
+            Animation::Binding binding;
+            Animation::SamplingState state;
+
+            PoseBuffer previous;
+            PoseBuffer next;
+            std::vector<float> weights;
+            bool primed = false;
+            float interval = 0.0f;
+            float elapsed = 0.0f;
+            //clip time after the last update
+            float clipTime = 0.0f;
+            //clip seconds per real second, measured from the last advance
+            float timeScale = 1.0f;
+    };
+}
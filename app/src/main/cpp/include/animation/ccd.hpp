@@ -0,0 +1,37 @@
+#pragma once
+#include "ik_chain.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace ve{
+    struct CCDSettings{
+        int maxIterations = 32;
+        //stop once the effector is this close to the target, checked after every joint
+        float tolerance = 1e-3f;
+        //clamp and damp with Skeleton::jointLimits when the skeleton has them
+        bool useLimits = true;
+    };
+
+    // Cyclic coordinate descent: from the joint above the effector up to the root, rotate each joint so
+    // the effector points at the target. Every step is damped and clamped by the joint's entry in
+    // Skeleton::jointLimits, which keeps legs and spines inside what a dog can do. Forward kinematics
+    // during the solve only touch the chain, the skeleton is marked dirty for the next updateDirty.
+    class CCDSolver{
+        public:
+            bool init(const Skeleton& skeleton, int root, int effector);
+            //target in model space, the skeleton's model matrices have to be current
+            const IKSolveStats& solve(Skeleton& skeleton, const glm::vec3& target, const CCDSettings& settings = {});
+            const IKSolveStats& getLastStats() const {return stats;}
+            const IKChain& getChain() const {return chain;}
+        private:
+            void updateFrom(Skeleton& skeleton, size_t first);
+
+            IKChain chain;
+            //model matrices of the chain joints during the solve
+            std::vector<glm::mat4> matrices;
+            glm::mat4 parentMatrix{1.0f};
+            bool hasNodeMatrices = false;
+            IKSolveStats stats;
+    };
+}
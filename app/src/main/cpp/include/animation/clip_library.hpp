@@ -0,0 +1,52 @@
+#pragma once
+#include "animation.hpp"
+#include "skeleton.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ve{
+    // Clips shared between models. The first model that loads a clip registers it together with
+    // the joint names and rest pose of its skeleton; every other model gets a playback copy whose
+    // channels are remapped by joint name and compensated for the difference in rest pose.
+    // The keys themselves are stored once (Sampler::shared / Sampler::compressed).
+    // Clips are looked up by clip set and name. A clip set names the motion source the models were animated
+    // from (AnimationImportSettings::clipSet), so a "walk" of one set is loaded once and retargeted to every
+    // model of that set, while a "walk" (or an unnamed "animation0") of another set stays apart.
+    class ClipLibrary{
+        public:
+            //share at least this fraction of a clip's channels or load the clip from the file instead
+            static constexpr float DEFAULT_MIN_BOUND_RATIO = 0.9f;
+
+            //register clip of clipSet as animated on sourceSkeleton (in rest pose), its float keys move to shared storage
+            void add(const std::string& clipSet, const std::shared_ptr<Animation>& clip, const Skeleton& sourceSkeleton);
+            //playback copy of a registered clip bound to target (in rest pose), nullptr if unknown or incompatible
+            std::shared_ptr<Animation> instantiate(const std::string& clipSet, const std::string& name, const Skeleton& target,
+                                                   float minBoundRatio = DEFAULT_MIN_BOUND_RATIO) const;
+            bool contains(const std::string& clipSet, const std::string& name) const;
+            void clear();
+
+            size_t getClipCount() const;
+            //bytes of the registered clips, paid once however many models play them
+            size_t getMemoryUsage() const;
+
+        private:
+            struct ChannelSource{
+                std::string jointName;   //empty when the channel does not target a joint
+                glm::vec3 restTranslation{0.0f};
+                glm::quat restRotation{1.0f, 0.0f, 0.0f, 0.0f};
+                glm::vec3 restScale{1.0f};
+            };
+            struct Entry{
+                std::shared_ptr<const Animation> clip;
+                std::vector<ChannelSource> sources;  //parallel to clip->channels
+            };
+            mutable std::mutex mutex;
+            //(clip set, clip name)
+            std::map<std::pair<std::string, std::string>, Entry> clips;
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace ve{
+    // Quantized key storage for a single animation sampler.
+    // Key times are 16 bit frame indices and every value takes 48 bits:
+    //  - rotations use the smallest-three encoding (2 bit index of the dropped component, 3 x 15 bit)
+    //  - translations and scales are quantized to 16 bits per component inside the track's range
+    // Compared to float time + vec4 value (20 bytes per key) this is 8 bytes per key.
+    class CompressedTrack{
+        public:
+            enum class Encoding{
+                SMALLEST_THREE_QUATERNION,
+                RANGE_QUANTIZED_VEC3
+            };
+            static constexpr size_t VALUES_PER_KEY = 3;
+
+            //frameRate <= 0 spreads the 16 bit frame range over the track duration (highest time precision)
+            CompressedTrack(const std::vector<float>& timeStamps, const std::vector<glm::vec4>& values,
+                            Encoding encoding, float frameRate = 0.0f);
+
+            size_t keyCount() const {return frames.size();}
+            float keyTime(size_t i) const {return startTime + static_cast<float>(frames[i]) * timeStep;}
+            glm::vec4 keyValue(size_t i) const;
+            //converts a clip time to the (fractional) frame space used by frameData(), times up to the true
+            //end of the track stay on the last frame even where float rounding puts them a fraction past it
+            float toFrame(float time) const{
+                float frame = (time - startTime) * inverseTimeStep;
+                return time <= endTime ? std::min(frame, lastFrame) : frame;
+            }
+            const uint16_t* frameData() const {return frames.data();}
+
+            Encoding getEncoding() const {return encoding;}
+            //largest decode error over all keys: radians for rotations, units for translation/scale
+            float getValueError() const {return valueError;}
+            //largest difference between the original and the quantized key times, in seconds
+            float getTimeError() const {return timeError;}
+            //false when keys closer than the finest frame step collapsed onto the same frame
+            bool hasDistinctFrames() const {return distinctFrames;}
+            size_t byteSize() const;
+
+            std::vector<float> decodeTimes() const;
+            std::vector<glm::vec4> decodeValues() const;
+
+        private:
+            void quantizeTimes(const std::vector<float>& timeStamps, float frameRate);
+            void encodeQuaternion(const glm::vec4& q, uint16_t* out) const;
+            glm::vec4 decodeQuaternion(const uint16_t* in) const;
+            void encodeRange(const glm::vec4& v, uint16_t* out) const;
+            glm::vec4 decodeRange(const uint16_t* in) const;
+
+            Encoding encoding;
+            float startTime{0.0f};
+            float endTime{0.0f};
+            float lastFrame{0.0f};
+            float timeStep{1.0f};
+            float inverseTimeStep{1.0f};
+            glm::vec3 rangeMin{0.0f};
+            glm::vec3 rangeExtent{0.0f};
+            float valueError{0.0f};
+            float timeError{0.0f};
+            bool distinctFrames{true};
+            std::vector<uint16_t> frames;
+            std::vector<uint16_t> values;
+    };
+}
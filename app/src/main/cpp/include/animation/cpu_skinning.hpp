@@ -0,0 +1,156 @@
+#pragma once
+#include "dual_quaternion.hpp"
+#include "vertex_packing.hpp"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ve{
+    // Byte offsets of the attributes skinning reads and writes in one vertex. Source and destination may use
+    // different layouts, the attributes skinning does not touch are left as they are in the destination.
+    // Packed layouts (PackedVertex) hold the attributes in the encodings of vertex_packing.hpp.
+    struct SkinningLayout{
+        size_t stride = 0;
+        size_t position = 0;  //vec3
+        size_t normal = 0;    //vec3, packed: octahedral snorm16x2
+        size_t tangent = 0;   //vec3, packed: octahedral snorm16x2
+        size_t joints = 0;    //4 x int32, packed: 4 x uint8
+        size_t weights = 0;   //vec4, packed: 4 x unorm16
+        bool packed = false;
+
+        //VeModel::Vertex, PackedVertex, or any vertex with the same member names
+        template<typename Vertex>
+        static SkinningLayout of(){
+            return {sizeof(Vertex), offsetof(Vertex, position), offsetof(Vertex, normal), offsetof(Vertex, tangent),
+                    offsetof(Vertex, jointIndices), offsetof(Vertex, jointWeights),
+                    std::is_same<decltype(Vertex::normal), uint32_t>::value};
+        }
+    };
+
+    // Float bind pose CpuSkinning reads from, 68 bytes a vertex. Reading PackedVertex instead would decode two
+    // octahedral directions per vertex and frame. Influences are rounded like PackedVertex holds them, so CPU
+    // and GPU skinning agree, and joints a byte cannot address are -1 (bind pose) as in the packed stream.
+    struct SkinningVertex{
+        glm::vec3 position{0.0f};
+        glm::vec3 normal{0.0f};
+        glm::vec3 tangent{0.0f};
+        glm::ivec4 jointIndices{-1};
+        glm::vec4 jointWeights{0.0f};
+
+        //VeModel::Vertex, or any vertex with the same member names
+        template<typename Vertex>
+        static SkinningVertex of(const Vertex& vertex){
+            SkinningVertex skinning;
+            skinning.position = vertex.position;
+            skinning.normal = vertex.normal;
+            skinning.tangent = vertex.tangent;
+            glm::ivec4 joints = vertexPacking::unpackJoints(vertexPacking::packJoints(vertex.jointIndices));
+            for(int i = 0; i < 4; i++)
+                skinning.jointIndices[i] = joints[i] == vertexPacking::INVALID_JOINT ? -1 : joints[i];
+            uint16_t weights[4];
+            vertexPacking::packWeights(vertex.jointWeights, weights);
+            skinning.jointWeights = vertexPacking::unpackWeights(weights);
+            return skinning;
+        }
+        //decodes a packed vertex, what SkinningSystem builds the bind pose from when CPU skinning starts
+        static SkinningVertex of(const PackedVertex& packed);
+    };
+
+    struct SkinningStats{
+        size_t vertices = 0;
+        uint64_t nanoseconds = 0;
+        unsigned threads = 1;
+
+        double verticesPerMillisecond() const {return nanoseconds > 0 ? vertices * 1e6 / static_cast<double>(nanoseconds) : 0.0;}
+    };
+
+    // Linear blend skinning on the CPU, same result as the skinning compute pass and the vertex shaders:
+    // the up to four joint matrices of a vertex are blended into one (simd::float4 columns, NEON, SSE2 or
+    // scalar), then position, normal and tangent are transformed by it. A weight sum other than one is
+    // divided out, an influence with a joint outside the palette keeps the bind pose. Vertices are split
+    // into batches of BATCH_SIZE that persistent worker threads and the calling thread take in turn.
+    // Fallback for GPUs with little vertex throughput and the headless reference for skinning tests.
+    // The DualQuaternion overloads blend the 8 float palette entries instead (SkinningMethod::DualQuaternion).
+    class CpuSkinning{
+        public:
+            static constexpr size_t BATCH_SIZE = 1024;
+
+            //workers besides the calling thread, hardware threads - 1 when negative
+            explicit CpuSkinning(int workerCount = -1);
+            ~CpuSkinning();
+            CpuSkinning(const CpuSkinning&) = delete;
+            CpuSkinning& operator=(const CpuSkinning&) = delete;
+
+            //source and destination may be the same buffer
+            const SkinningStats& skin(const void* source, void* destination, size_t vertexCount, const SkinningLayout& layout,
+                                      const glm::mat4* joints, size_t jointCount);
+            const SkinningStats& skin(const void* source, void* destination, size_t vertexCount, const SkinningLayout& layout,
+                                      const DualQuaternion* joints, size_t jointCount);
+            //source in sourceLayout (a SkinningVertex bind pose) written to destination in layout (PackedVertex)
+            const SkinningStats& skin(const void* source, const SkinningLayout& sourceLayout, void* destination, size_t vertexCount,
+                                      const SkinningLayout& layout, const glm::mat4* joints, size_t jointCount);
+            const SkinningStats& skin(const void* source, const SkinningLayout& sourceLayout, void* destination, size_t vertexCount,
+                                      const SkinningLayout& layout, const DualQuaternion* joints, size_t jointCount);
+            const SkinningStats& getStats() const {return stats;}
+            unsigned getThreadCount() const {return static_cast<unsigned>(workers.size()) + 1;}
+
+            //vertices [first, last) on the calling thread
+            static void skinRange(const void* source, const SkinningLayout& sourceLayout, void* destination, size_t first, size_t last,
+                                  const SkinningLayout& layout, const glm::mat4* joints, size_t jointCount);
+            //one vertex at a time with glm, what the SIMD path is tested against
+            static void skinReference(const void* source, const SkinningLayout& sourceLayout, void* destination, size_t vertexCount,
+                                      const SkinningLayout& layout, const glm::mat4* joints, size_t jointCount);
+            static void skinRange(const void* source, const SkinningLayout& sourceLayout, void* destination, size_t first, size_t last,
+                                  const SkinningLayout& layout, const DualQuaternion* joints, size_t jointCount);
+            static void skinReference(const void* source, const SkinningLayout& sourceLayout, void* destination, size_t vertexCount,
+                                      const SkinningLayout& layout, const DualQuaternion* joints, size_t jointCount);
+            //same layout on both sides
+            template<typename Palette>
+            static void skinRange(const void* source, void* destination, size_t first, size_t last, const SkinningLayout& layout,
+                                  const Palette* joints, size_t jointCount){
+                skinRange(source, layout, destination, first, last, layout, joints, jointCount);
+            }
+            template<typename Palette>
+            static void skinReference(const void* source, void* destination, size_t vertexCount, const SkinningLayout& layout,
+                                      const Palette* joints, size_t jointCount){
+                skinReference(source, layout, destination, vertexCount, layout, joints, jointCount);
+            }
+        private:
+            struct Job{
+                const void* source = nullptr;
+                void* destination = nullptr;
+                size_t vertexCount = 0;
+                SkinningLayout sourceLayout;
+                SkinningLayout layout;
+                //one of the two palettes
+                const glm::mat4* matrices = nullptr;
+                const DualQuaternion* dualQuaternions = nullptr;
+                size_t jointCount = 0;
+            };
+            const SkinningStats& run(const Job& newJob);
+            static void skinBatch(const Job& job, size_t first, size_t last);
+            void workerLoop();
+            void runBatches();
+
+            std::vector<std::thread> workers;
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::condition_variable done;
+            Job job;
+            size_t batchCount = 0;
+            std::atomic<size_t> nextBatch{0};
+            //bumped for every job, workers that are still busy with the last one are counted in active
+            uint64_t generation = 0;
+            size_t active = 0;
+            bool stopping = false;
+            SkinningStats stats;
+    };
+}
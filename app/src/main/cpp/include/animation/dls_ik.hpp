@@ -0,0 +1,69 @@
+#pragma once
+#include "ik_chain.hpp"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace ve{
+    struct DLSSettings{
+        //fixed budget per solve, fewer when every effector is within tolerance earlier
+        int iterations = 10;
+        float tolerance = 1e-3f;
+        //lambda of the damped least squares step: larger is steadier near singular poses, smaller converges faster
+        float damping = 0.05f;
+        //largest rotation one joint takes per iteration, radians
+        float maxJointStep = 0.4f;
+        //clamp with Skeleton::jointLimits when the skeleton has them
+        bool useLimits = true;
+    };
+
+    struct IKEffector{
+        int joint = -1;
+        //relative importance of reaching this effector's target
+        float weight = 1.0f;
+    };
+
+    // Damped least squares IK for several effectors at once (four paws and the head). Only the joints
+    // between the effectors and the root take part, and the Jacobian is kept as 3x3 blocks for the
+    // (joint, effector) pairs where the joint is an ancestor of the effector. The system that is solved
+    // is effectors x effectors, so its size does not grow with the rig. Rotations are applied with per
+    // joint weights; all buffers are sized in init.
+    class DLSSolver{
+        public:
+            static constexpr size_t MAX_EFFECTORS = 8;
+
+            //joints above root are never moved, NO_PARENT lets every ancestor of the effectors move
+            bool init(const Skeleton& skeleton, const std::vector<IKEffector>& effectors, int root = NO_PARENT);
+            //0 locks the joint, larger values move it more than the others
+            void setJointWeight(int joint, float weight);
+            //one model space target per effector, the skeleton's model matrices have to be current
+            const IKSolveStats& solve(Skeleton& skeleton, const glm::vec3* targets, const DLSSettings& settings = {});
+            const IKSolveStats& getLastStats() const {return stats;}
+            size_t getActiveJointCount() const;
+            //nonzero 3x3 blocks of the Jacobian, a dense one has effectors x active joints
+            size_t getJacobianBlockCount() const;
+        private:
+            struct Node{
+                int joint = -1;
+                //index into nodes, -1 when the parent is not part of the solve
+                int parent = -1;
+                //effectors this joint moves
+                uint32_t effectorMask = 0;
+                float weight = 1.0f;
+            };
+            void updateMatrices(const Skeleton& skeleton);
+
+            std::vector<Node> nodes;
+            std::vector<IKEffector> effectors;
+            std::vector<int> effectorNodes;
+            //model matrices of the nodes during the solve
+            std::vector<glm::mat4> matrices;
+            std::vector<glm::vec3> effectorPositions;
+            //(3 * effectors)^2 system and right hand side
+            std::vector<float> system;
+            std::vector<float> solution;
+            bool hasNodeMatrices = false;
+            IKSolveStats stats;
+    };
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+namespace ve{
+    //how a model's vertices are blended between their joints, chosen per model (VeModel::skinningMethod)
+    enum class SkinningMethod{
+        //weighted sum of joint matrices, 64 byte palette entries
+        LinearBlend,
+        //weighted sum of unit dual quaternions, 32 byte entries, no volume loss on twisted joints
+        DualQuaternion
+    };
+
+    // Unit dual quaternion of a rigid joint transform, one palette entry of dual quaternion skinning.
+    // Both parts are xyzw vec4s rather than glm::quat (whose member order depends on
+    // GLM_FORCE_QUAT_DATA_WXYZ) so the palette is uploaded as is and read as two vec4s by the shaders.
+    struct DualQuaternion{
+        //rotation
+        glm::vec4 real{0.0f, 0.0f, 0.0f, 1.0f};
+        //0.5 * translation * rotation
+        glm::vec4 dual{0.0f};
+    };
+    static_assert(sizeof(DualQuaternion) == 32, "the shaders read two vec4s per joint");
+
+    namespace dualQuaternion{
+        //rotation and translation of a joint matrix. Scale and shear cannot be represented and are dropped,
+        //rigs that scale joints keep SkinningMethod::LinearBlend
+        DualQuaternion fromMatrix(const glm::mat4& matrix);
+        //count palette entries, returns the largest deviation of a column length from 1: the scale lost
+        float fromMatrices(const glm::mat4* matrices, size_t count, DualQuaternion* palette);
+        glm::vec3 transformPoint(const DualQuaternion& dq, const glm::vec3& point);
+        //rotation only, for normals and tangents
+        glm::vec3 rotate(const DualQuaternion& dq, const glm::vec3& vector);
+    }
+}
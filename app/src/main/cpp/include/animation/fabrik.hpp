@@ -0,0 +1,37 @@
+#pragma once
+#include "ik_chain.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace ve{
+    struct FabrikSettings{
+        int maxIterations = 10;
+        //stop once the effector is this close to the target, in model units
+        float tolerance = 1e-3f;
+        //start from the last solution instead of the sampled pose, steady targets then converge in one
+        //or two iterations
+        bool warmStart = true;
+    };
+
+    // FABRIK (Aristidou and Lasenby) for chains of any length: spine, neck, tail. Works on the contiguous
+    // positions of its IKChain and writes the result back as local rotations, buffers are sized in init so
+    // solve does not allocate. Like the other solvers it runs after sampling on current model matrices and
+    // leaves the chain marked dirty for the next updateDirty.
+    class FabrikSolver{
+        public:
+            bool init(const Skeleton& skeleton, int root, int effector);
+            //target in model space
+            const IKSolveStats& solve(Skeleton& skeleton, const glm::vec3& target, const FabrikSettings& settings = {});
+            //forget the last solution, e.g. after a teleport or a clip change
+            void reset(){hasSolution = false;}
+            const IKSolveStats& getLastStats() const {return stats;}
+            const IKChain& getChain() const {return chain;}
+        private:
+            IKChain chain;
+            //last solution relative to the root joint, so it follows the body
+            std::vector<glm::vec3> solution;
+            bool hasSolution = false;
+            IKSolveStats stats;
+    };
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "two_bone_ik.hpp"
+#include "collision_bvh.hpp"
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+namespace ve{
+    struct FootPlacementSettings{
+        //up in the skeleton's model space, the clip's ground is the plane through the model origin
+        glm::vec3 up{0.0f, 1.0f, 0.0f};
+        //rays start this far above the animated paw and end this far below it, model units
+        float rayHeight = 0.5f;
+        float rayDepth = 0.5f;
+        //ground offsets a paw follows, larger steps are clamped
+        float maxStepUp = 0.2f;
+        float maxStepDown = 0.3f;
+        //lower the body by the deepest paw offset so legs over lower ground can still reach it
+        bool adjustPelvis = true;
+        //1/seconds, how fast offsets and leg weights follow the ground
+        float sharpness = 12.0f;
+    };
+
+    // Keeps paws planted on static collision geometry. Runs after sampling, once the model matrices are
+    // current: one ray per paw straight down through its animated position, the hit height becomes an
+    // offset of the paw target (clamped and smoothed over time), and the legs are solved with
+    // twoBoneIK::solveBatch, four legs per SIMD group. Paws without ground under them fade back to the
+    // animated pose. The legs have to be sampled every frame, each solve starts from the animated pose.
+    // appendRays and apply are split so many characters can share one batched CollisionBVH::raycast;
+    // update does both for a single character.
+    class FootPlacement{
+        public:
+            static constexpr size_t MAX_FEET = 8;
+
+            //end joints of the legs by name, pelvis -1 picks the closest common ancestor of the legs
+            bool init(const Skeleton& skeleton, const std::vector<std::string>& feetJoints, int pelvis = -1);
+            //legs ending in a joint named *paw* or *foot*
+            bool init(const Skeleton& skeleton);
+            bool isBoundTo(const Skeleton& skeleton) const {return bound == &skeleton && jointCount == skeleton.joints.size();}
+            size_t getFootCount() const {return feet.size();}
+            //back to the animated pose, for teleports and clip changes
+            void reset();
+
+            //one world space ray per foot, objectMatrix places the skeleton's model space in the world. Takes back
+            //the pelvis offset of the previous frame when the clip did not overwrite it
+            void appendRays(Skeleton& skeleton, const glm::mat4& objectMatrix, std::vector<Ray>& rays);
+            //hits of the rays appendRays added, in the same order. Marks the legs dirty, the caller runs
+            //updateDirty. Returns the feet that found ground
+            size_t apply(Skeleton& skeleton, const RayHit* hits, float deltaTime);
+            size_t update(Skeleton& skeleton, const glm::mat4& objectMatrix, const CollisionBVH& collision, float deltaTime);
+
+            FootPlacementSettings settings;
+        private:
+            struct Foot{
+                TwoBoneChain chain;
+                //smoothed offset along up and leg weight
+                float offset = 0.0f;
+                float weight = 0.0f;
+                //animated paw this frame, model space
+                glm::vec3 animated{0.0f};
+                //last usable bend direction of the knee
+                glm::vec3 bend{0.0f, 0.0f, 1.0f};
+            };
+
+            std::vector<Foot> feet;
+            std::vector<TwoBoneChain> chains;
+            std::vector<TwoBoneGoal> goals;
+            //update's own rays and hits
+            std::vector<Ray> frameRays;
+            std::vector<RayHit> frameHits;
+            int pelvis = -1;
+            float pelvisOffset = 0.0f;
+            //pelvis translation written last frame and the local offset it contains
+            glm::vec3 writtenTranslation{0.0f};
+            glm::vec3 writtenOffset{0.0f};
+            const Skeleton* bound = nullptr;
+            size_t jointCount = 0;
+    };
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "skeleton.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace ve{
+    // Outcome of one IK solve, for budgeting IK per frame.
+    struct IKSolveStats{
+        int iterations = 0;
+        //effector to target distance after the solve
+        float error = 0.0f;
+        //error reached the tolerance (or the target is out of reach and the chain is straightened)
+        bool converged = false;
+        uint64_t nanoseconds = 0;
+    };
+
+    // Joints on the path from a root to an effector, root first. Positions live in one contiguous array
+    // sized once by init, so solvers working on it do not allocate.
+    class IKChain{
+        public:
+            //every joint from root down to effector, false when effector is not below root
+            bool init(const Skeleton& skeleton, int root, int effector);
+            size_t size() const {return joints.size();}
+            bool empty() const {return joints.empty();}
+            int getEffector() const {return joints.back();}
+            //model space positions and bone lengths of the current pose, model matrices have to be current
+            void readPositions(const Skeleton& skeleton);
+            //rotate the local rotations so every bone points at the next entry of positions, root first.
+            //Reads the model matrices of the pose the positions were solved from, marks the chain dirty
+            void writeRotations(Skeleton& skeleton) const;
+
+            std::vector<int> joints;
+            std::vector<glm::vec3> positions;
+            //lengths[i] is the bone from joints[i] to joints[i + 1]
+            std::vector<float> lengths;
+            float totalLength = 0.0f;
+    };
+
+    namespace ikMath{
+        constexpr float EPSILON = 1e-6f;
+        inline glm::vec3 jointPosition(const Skeleton& skeleton, int joint){
+            return glm::vec3(skeleton.getModelMatrix(joint)[3]);
+        }
+        //T * R * S (* node matrix) of the joint's current local transform, Joint::getAnimatedMatrix written out
+        inline glm::mat4 animatedMatrix(const Joint& joint, bool withNodeMatrix){
+            glm::mat4 local = glm::mat4_cast(joint.rotation);
+            local[0] *= joint.scale.x;
+            local[1] *= joint.scale.y;
+            local[2] *= joint.scale.z;
+            local[3] = glm::vec4(joint.translation, 1.0f);
+            return withNodeMatrix ? local * joint.jointWorldMatrix : local;
+        }
+        //rotation part of a model matrix, scale removed
+        glm::quat rotationOf(const glm::mat4& matrix);
+        //rotation part of the joint's model matrix, identity above the root
+        glm::quat globalRotation(const Skeleton& skeleton, int joint);
+        //shortest arc from u to v, neither has to be unit length
+        glm::quat rotationBetween(const glm::vec3& u, const glm::vec3& v);
+        //rotation scaled towards identity, weight 0..1, rotation must have w >= 0
+        glm::quat scaleRotation(const glm::quat& rotation, float weight);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "ccd.hpp"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+namespace ve{
+    // Cost of IK drag events: the solve and the dirty subtree update that follows it.
+    struct IKDragTiming{
+        //last event
+        uint64_t solveNanoseconds = 0;
+        uint64_t totalNanoseconds = 0;
+        int iterations = 0;
+        float error = 0.0f;
+        //since begin
+        int events = 0;
+        uint64_t maxTotalNanoseconds = 0;
+        uint64_t sumTotalNanoseconds = 0;
+
+        double averageTotalNanoseconds() const {return events > 0 ? static_cast<double>(sumTotalNanoseconds) / events : 0.0;}
+    };
+
+    // Dragging an end effector (a paw, the head) with the limb following: a CCD solve per drag event over
+    // the chainLength joints above the effector. Each event starts from the pose the previous one left, so
+    // small finger moves take a few iterations and a capped iteration count per event keeps long moves
+    // inside the frame, the rest converges over the next events. Only the chain root's subtree is
+    // recomputed afterwards.
+    class IKDrag{
+        public:
+            static constexpr int EVENT_ITERATIONS = 8;
+
+            //chainLength joints above effector take part, fewer when the skeleton's root comes first
+            bool begin(const Skeleton& skeleton, int effector, int chainLength);
+            void end();
+            bool isActive() const {return effector != -1;}
+            int getEffector() const {return effector;}
+            int getRoot() const {return root;}
+            //target in model space, the skeleton's model matrices are current again afterwards
+            const IKDragTiming& drag(Skeleton& skeleton, const glm::vec3& target);
+            const IKDragTiming& getTiming() const {return timing;}
+
+            CCDSettings settings{EVENT_ITERATIONS, 1e-3f, true};
+        private:
+            CCDSolver solver;
+            int effector = -1;
+            int root = -1;
+            IKDragTiming timing;
+    };
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace ve{
+    // Swing cone and twist limit of one joint, relative to its rest rotation. Angles are kept as cos/sin of
+    // the half angle so clamping a rotation is a few multiplies and square roots, no trigonometry. 48 bytes,
+    // a table of them sits next to the joints in Skeleton::jointLimits.
+    struct JointLimit{
+        //local rotation the limits are measured from
+        glm::quat rest{1.0f, 0.0f, 0.0f, 0.0f};
+        //bone direction in the joint's local space, twist is measured around it
+        glm::vec3 twistAxis{0.0f, 1.0f, 0.0f};
+        //fraction of each solver step applied to this joint, 1 = undamped
+        float damping = 1.0f;
+        //half of the maximum angle, cos 0 / sin 1 leaves the joint free
+        float cosHalfSwing = 0.0f;
+        float sinHalfSwing = 1.0f;
+        float cosHalfTwist = 0.0f;
+        float sinHalfTwist = 1.0f;
+
+        //maxSwing: cone half angle around twistAxis, maxTwist: symmetric twist range, both in radians
+        static JointLimit create(const glm::quat& rest, const glm::vec3& twistAxis, float maxSwing, float maxTwist, float damping = 1.0f);
+        bool isFree() const {return cosHalfSwing <= 0.0f && cosHalfTwist <= 0.0f;}
+        //pull a local rotation back inside the cone and twist range, true if it was outside
+        bool clamp(glm::quat& rotation) const;
+    };
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "skeleton.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace ve{
+    // Local joint transforms of one skeleton in structure-of-arrays form: ten float streams
+    // (translation xyz, rotation xyzw, scale xyz), each padded to the simd width.
+    // A Pose does not own its floats, they live in a PoseBuffer or a PosePool.
+    struct Pose{
+        enum Stream{
+            TX, TY, TZ,
+            RX, RY, RZ, RW,
+            SX, SY, SZ,
+            STREAM_COUNT
+        };
+        //floats per stream for a given joint count
+        static size_t strideFor(size_t jointCount);
+
+        float* data = nullptr;
+        size_t jointCount = 0;
+        size_t stride = 0;
+
+        bool isValid() const {return data != nullptr;}
+        float* stream(Stream s) {return data + s * stride;}
+        const float* stream(Stream s) const {return data + s * stride;}
+
+        glm::vec3 getTranslation(size_t joint) const;
+        glm::quat getRotation(size_t joint) const;
+        glm::vec3 getScale(size_t joint) const;
+        void setTranslation(size_t joint, const glm::vec3& translation);
+        void setRotation(size_t joint, const glm::quat& rotation);
+        void setScale(size_t joint, const glm::vec3& scale);
+
+        //zero translation, identity rotation, unit scale for every joint
+        void setIdentity();
+        void copyFrom(const Pose& other);
+        //copy the current local transforms of the skeleton, joints without channels keep these values
+        void readFrom(const Skeleton& skeleton);
+        void writeTo(Skeleton& skeleton) const;
+    };
+
+    //owns the floats of a single pose
+    class PoseBuffer{
+        public:
+            explicit PoseBuffer(size_t jointCount = 0);
+            PoseBuffer(const PoseBuffer&) = delete;
+            PoseBuffer& operator=(const PoseBuffer&) = delete;
+            PoseBuffer(PoseBuffer&&) = default;
+            PoseBuffer& operator=(PoseBuffer&&) = default;
+
+            void resize(size_t jointCount);
+            Pose& pose() {return view;}
+            const Pose& pose() const {return view;}
+        private:
+            std::vector<float> storage;
+            Pose view;
+    };
+
+    // Per-frame arena of poses for one joint count. All storage is allocated up front, acquire()
+    // only bumps an atomic index so worker threads can take poses concurrently without touching
+    // the heap. reset() recycles every pose at the start of the next frame.
+    class PosePool{
+        public:
+            PosePool(size_t jointCount, size_t capacity);
+            PosePool(const PosePool&) = delete;
+            PosePool& operator=(const PosePool&) = delete;
+
+            //uninitialized pose valid until the next reset, invalid Pose when the pool is exhausted
+            Pose acquire();
+            void reset();
+
+            size_t getJointCount() const {return jointCount;}
+            size_t getCapacity() const {return capacity;}
+            size_t getUsed() const;
+        private:
+            size_t jointCount;
+            size_t stride;
+            size_t capacity;
+            std::vector<float> storage;
+            std::atomic<size_t> next{0};
+    };
+
+    // Batch kernels over SoA lanes, count is rounded up to the simd width so every
+    // stream must hold at least Pose::strideFor(count) floats.
+    namespace poseKernels{
+        //out = a + (b - a) * t per component
+        void lerp(const float* const a[3], const float* const b[3], const float* t, float* const out[3], size_t count);
+        //shortest path quaternion blend: nlerp with a corrected weight that tracks slerp closely
+        void slerp(const float* const a[4], const float* const b[4], const float* t, float* const out[4], size_t count);
+        //plain normalized lerp, cheaper but drifts from slerp for large angles
+        void nlerp(const float* const a[4], const float* const b[4], const float* t, float* const out[4], size_t count);
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ve{
+    //FNV-1a over raw bytes, chain calls through seed to hash several arrays. Floats hash bit for bit
+    constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+    uint64_t hashBytes(const void* data, size_t size, uint64_t seed = FNV_OFFSET);
+
+    //immutable float keys of an animation sampler, shared between clips and models
+    struct SharedKeys{
+        std::vector<float> timeStamps;
+        std::vector<glm::vec4> values;
+
+        size_t byteSize() const{
+            return sizeof(SharedKeys) + timeStamps.capacity() * sizeof(float) + values.capacity() * sizeof(glm::vec4);
+        }
+    };
+
+    // Content-hash interning of sampler keys. Samplers with bit-identical times and values end up
+    // pointing at the same SharedKeys. Entries are weak, a key set lives as long as some sampler uses it.
+    // The keys are const after interning, so they can be read from any thread.
+    class SamplerStore{
+        public:
+            struct Stats{
+                size_t internCalls = 0;
+                size_t hits = 0;
+                //bytes not allocated because an identical key set already existed (cumulative)
+                size_t bytesSaved = 0;
+                //key sets currently alive and their bytes
+                size_t uniqueSamplers = 0;
+                size_t uniqueBytes = 0;
+            };
+
+            //process wide store used by Animation::Sampler::share
+            static SamplerStore& global();
+
+            //shared keys equal to the given arrays, bytesSaved receives the size of the arrays on a hit and 0 otherwise
+            std::shared_ptr<const SharedKeys> intern(std::vector<float> timeStamps, std::vector<glm::vec4> values, size_t& bytesSaved);
+            //forget expired entries
+            void purge();
+            Stats getStats();
+
+        private:
+            static uint64_t hash(const std::vector<float>& timeStamps, const std::vector<glm::vec4>& values);
+            static bool equals(const SharedKeys& keys, const std::vector<float>& timeStamps, const std::vector<glm::vec4>& values);
+
+            std::mutex mutex;
+            std::unordered_multimap<uint64_t, std::weak_ptr<const SharedKeys>> entries;
+            Stats stats;
+    };
+}
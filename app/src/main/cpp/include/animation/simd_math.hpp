@@ -0,0 +1,198 @@
+#pragma once
+
+// Minimal 4-wide float vector used by the batch animation kernels.
+// NEON on arm (all Android arm ABIs we ship), SSE2 on x86/x86_64, plain floats otherwise.
+// Define VE_SIMD_SCALAR to force the scalar fallback.
+#if !defined(VE_SIMD_SCALAR) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define VE_SIMD_NEON 1
+#include <arm_neon.h>
+#elif !defined(VE_SIMD_SCALAR) && (defined(__SSE2__) || defined(_M_X64))
+#define VE_SIMD_SSE 1
+#include <emmintrin.h>
+#else
+#include <cmath>
+#endif
+
+#include <cstdint>
+#include <cstring>
+
+namespace ve::simd{
+    struct float4{
+#if defined(VE_SIMD_NEON)
+        float32x4_t v;
+#elif defined(VE_SIMD_SSE)
+        __m128 v;
+#else
+        float v[4];
+#endif
+    };
+
+    //number of floats processed per kernel iteration
+    constexpr size_t WIDTH = 4;
+
+    inline float4 load(const float* p){
+#if defined(VE_SIMD_NEON)
+        return {vld1q_f32(p)};
+#elif defined(VE_SIMD_SSE)
+        return {_mm_loadu_ps(p)};
+#else
+        float4 r;
+        std::memcpy(r.v, p, sizeof(r.v));
+        return r;
+#endif
+    }
+
+    inline void store(float* p, float4 a){
+#if defined(VE_SIMD_NEON)
+        vst1q_f32(p, a.v);
+#elif defined(VE_SIMD_SSE)
+        _mm_storeu_ps(p, a.v);
+#else
+        std::memcpy(p, a.v, sizeof(a.v));
+#endif
+    }
+
+    inline float4 splat(float s){
+#if defined(VE_SIMD_NEON)
+        return {vdupq_n_f32(s)};
+#elif defined(VE_SIMD_SSE)
+        return {_mm_set1_ps(s)};
+#else
+        return {{s, s, s, s}};
+#endif
+    }
+
+    inline float4 operator+(float4 a, float4 b){
+#if defined(VE_SIMD_NEON)
+        return {vaddq_f32(a.v, b.v)};
+#elif defined(VE_SIMD_SSE)
+        return {_mm_add_ps(a.v, b.v)};
+#else
+        return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+#endif
+    }
+
+    inline float4 operator-(float4 a, float4 b){
+#if defined(VE_SIMD_NEON)
+        return {vsubq_f32(a.v, b.v)};
+#elif defined(VE_SIMD_SSE)
+        return {_mm_sub_ps(a.v, b.v)};
+#else
+        return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+#endif
+    }
+
+    inline float4 operator*(float4 a, float4 b){
+#if defined(VE_SIMD_NEON)
+        return {vmulq_f32(a.v, b.v)};
+#elif defined(VE_SIMD_SSE)
+        return {_mm_mul_ps(a.v, b.v)};
+#else
+        return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+#endif
+    }
+
+    //a * b + c
+    inline float4 madd(float4 a, float4 b, float4 c){
+#if defined(VE_SIMD_NEON)
+        return {vmlaq_f32(c.v, a.v, b.v)};
+#else
+        return a * b + c;
+#endif
+    }
+
+    inline float4 abs(float4 a){
+#if defined(VE_SIMD_NEON)
+        return {vabsq_f32(a.v)};
+#elif defined(VE_SIMD_SSE)
+        return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)};
+#else
+        return {{std::fabs(a.v[0]), std::fabs(a.v[1]), std::fabs(a.v[2]), std::fabs(a.v[3])}};
+#endif
+    }
+
+    inline float4 min(float4 a, float4 b){
+#if defined(VE_SIMD_NEON)
+        return {vminq_f32(a.v, b.v)};
+#elif defined(VE_SIMD_SSE)
+        return {_mm_min_ps(a.v, b.v)};
+#else
+        return {{std::fmin(a.v[0], b.v[0]), std::fmin(a.v[1], b.v[1]), std::fmin(a.v[2], b.v[2]), std::fmin(a.v[3], b.v[3])}};
+#endif
+    }
+
+    inline float4 max(float4 a, float4 b){
+#if defined(VE_SIMD_NEON)
+        return {vmaxq_f32(a.v, b.v)};
+#elif defined(VE_SIMD_SSE)
+        return {_mm_max_ps(a.v, b.v)};
+#else
+        return {{std::fmax(a.v[0], b.v[0]), std::fmax(a.v[1], b.v[1]), std::fmax(a.v[2], b.v[2]), std::fmax(a.v[3], b.v[3])}};
+#endif
+    }
+
+    //a with its sign flipped in every lane where s is negative
+    inline float4 xorSign(float4 a, float4 s){
+#if defined(VE_SIMD_NEON)
+        uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(s.v), vdupq_n_u32(0x80000000u));
+        return {vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a.v), sign))};
+#elif defined(VE_SIMD_SSE)
+        return {_mm_xor_ps(a.v, _mm_and_ps(s.v, _mm_set1_ps(-0.0f)))};
+#else
+        float4 r;
+        for(int i = 0; i < 4; i++){
+            r.v[i] = std::signbit(s.v[i]) ? -a.v[i] : a.v[i];
+        }
+        return r;
+#endif
+    }
+
+    //1/sqrt(a), refined to close to full float precision
+    inline float4 rsqrt(float4 a){
+#if defined(VE_SIMD_NEON)
+        float32x4_t e = vrsqrteq_f32(a.v);
+        e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a.v, e), e));
+        e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a.v, e), e));
+        return {e};
+#elif defined(VE_SIMD_SSE)
+        //one newton step: e * (1.5 - 0.5 * a * e * e)
+        __m128 e = _mm_rsqrt_ps(a.v);
+        __m128 halfAee = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), a.v), _mm_mul_ps(e, e));
+        return {_mm_mul_ps(e, _mm_sub_ps(_mm_set1_ps(1.5f), halfAee))};
+#else
+        return {{1.0f / std::sqrt(a.v[0]), 1.0f / std::sqrt(a.v[1]), 1.0f / std::sqrt(a.v[2]), 1.0f / std::sqrt(a.v[3])}};
+#endif
+    }
+
+    //sqrt(max(a, 0)) through rsqrt, exact 0 for zero lanes
+    inline float4 sqrt(float4 a){
+        a = max(a, splat(0.0f));
+        return a * rsqrt(max(a, splat(1e-30f)));
+    }
+
+    //in-place 4x4 transpose, turns four xyzw vectors into x, y, z and w lanes
+    inline void transpose(float4& r0, float4& r1, float4& r2, float4& r3){
+#if defined(VE_SIMD_NEON)
+        float32x4x2_t t01 = vtrnq_f32(r0.v, r1.v);
+        float32x4x2_t t23 = vtrnq_f32(r2.v, r3.v);
+        r0.v = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+        r1.v = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+        r2.v = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+        r3.v = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+#elif defined(VE_SIMD_SSE)
+        _MM_TRANSPOSE4_PS(r0.v, r1.v, r2.v, r3.v);
+#else
+        float m[4][4];
+        std::memcpy(m[0], r0.v, sizeof(m[0]));
+        std::memcpy(m[1], r1.v, sizeof(m[1]));
+        std::memcpy(m[2], r2.v, sizeof(m[2]));
+        std::memcpy(m[3], r3.v, sizeof(m[3]));
+        for(int i = 0; i < 4; i++){
+            r0.v[i] = m[i][0];
+            r1.v[i] = m[i][1];
+            r2.v[i] = m[i][2];
+            r3.v[i] = m[i][3];
+        }
+#endif
+    }
+}
@@ -1,10 +1,13 @@
 #pragma once
+#include "joint_limits.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <memory>
 #include <string>
 #include <map>
+#include <vector>
+#include <cstdint>
 
 namespace ve{
     struct Joint {
@@ -42,21 +45,53 @@ namespace ve{
             ~Skeleton();
             void traverse();
             void traverse(Joint const& joint, int indent=0);
+            //joint matrices for the current local transforms, one linear pass when the joints are sorted
             void update();
+            //recursive walk from ROOT_JOINT, for skeletons whose parents do not precede their children
+            void updateRecursive();
             void updateJoint(int16_t jointIndex);
+            //refresh parentIndices from the joints and check the order, call after changing the hierarchy
+            bool buildHierarchy();
+            //the local transform of jointIndex changed: its subtree needs new matrices on the next updateDirty
+            void markDirty(int jointIndex);
+            //recompute only the joints marked dirty since the last update, cost follows the edited chains
+            void updateDirty();
+            bool isDirty() const {return dirtyBegin < dirtyEnd;}
+            //joint to model space (jointMatrices without the inverse bind), valid after update
+            const glm::mat4& getModelMatrix(int jointIndex) const {return modelMatrices[jointIndex];}
             bool isDescendantOf(int childIndex, int ancestorIndex);
-            void updateForIK() {
-                updateJointMatrices();
-                applyParentTransforms(ROOT_JOINT);
-            }
+            //mark the named joints and their subtrees as cosmetic (ears, tongue, toes), reduced animation
+            //LOD levels leave them at their last pose. Returns the number of joints masked
+            size_t setLodMask(const std::vector<std::string>& jointNames);
+            //limit jointIndex around its current local rotation, twist is measured around the bone to its
+            //first child. Angles in radians
+            void setJointLimit(int jointIndex, float maxSwing, float maxTwist, float damping = 1.0f);
+            void updateForIK();
             //public for now
             std::string name;
             std::vector<Joint> joints;
             bool isAnimated = true;
             std::vector<glm::mat4> jointMatrices;
             std::map<int, int> nodeJointMap;
+            //parent of each joint in one contiguous array, parents come first when isTopological
+            std::vector<int16_t> parentIndices;
+            bool isTopological = false;
+            //one past the last joint of each subtree, subtrees are contiguous when isContiguous (depth first order)
+            std::vector<uint32_t> subtreeEnd;
+            bool isContiguous = false;
+            //parallel to joints, 1 for joints skipped by reduced LOD levels, empty when nothing is masked
+            std::vector<uint8_t> lodMask;
+            //bumped by setLodMask so cached bindings know to filter again
+            uint32_t lodMaskVersion = 0;
+            //parallel to joints, read by the constrained IK solvers, empty when no joint is limited
+            std::vector<JointLimit> jointLimits;
         private:
+            void updateRange(size_t begin, size_t end);
             void updateJointMatrices();
+            std::vector<glm::mat4> modelMatrices;
+            //joints [dirtyBegin, dirtyEnd) are stale
+            size_t dirtyBegin = 0;
+            size_t dirtyEnd = 0;
             void applyParentTransforms(int16_t jointIndex);
     };
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+#include "skeleton.hpp"
+#include "pose.hpp"
+
+#include <glm/glm.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ve{
+    // Immutable rig of one skeleton: hierarchy, bind data and rest pose in flat arrays, joints sorted
+    // parents first. Shared by every instance of a model, per instance state lives in SkeletonInstance.
+    class SkeletonDefinition{
+        public:
+            //snapshot of the rig and rest pose of skeleton, nullptr when its joints are not sorted parents first
+            static std::shared_ptr<const SkeletonDefinition> create(const Skeleton& skeleton);
+
+            size_t getJointCount() const {return parentIndices.size();}
+            //joint index by name, -1 if unknown
+            int findJoint(const std::string& jointName) const;
+            const Pose& getRestPose() const {return restPose.pose();}
+            size_t getMemoryUsage() const;
+
+            std::string name;
+            std::vector<std::string> jointNames;
+            std::vector<int16_t> parentIndices;
+            //one past the last joint of each subtree
+            std::vector<uint32_t> subtreeEnd;
+            std::vector<glm::mat4> inverseBindMatrices;
+            //glTF node matrices applied after the animated TRS, empty when all are identity
+            std::vector<glm::mat4> nodeMatrices;
+            std::map<int, int> nodeJointMap;
+            std::vector<uint8_t> lodMask;
+            std::vector<JointLimit> jointLimits;
+        private:
+            PoseBuffer restPose;
+    };
+
+    // Mutable state of one animated instance: its local pose and skinning palette. Both point into the
+    // storage of the SkeletonInstancePool it came from.
+    struct SkeletonInstance{
+        const SkeletonDefinition* definition = nullptr;
+        Pose local;
+        //joint to model space times inverse bind, ready for the joint buffer
+        glm::mat4* palette = nullptr;
+
+        size_t getJointCount() const {return local.jointCount;}
+        //back to the rest pose of the definition
+        void resetToRestPose();
+        //compose the palette from the local pose in one pass over the sorted joints
+        void updatePalette();
+    };
+
+    // Fixed capacity store of instances for one definition. All pose and palette memory is allocated up
+    // front, acquire/release only move an index on a free list, so N instances cost N pose buffers and
+    // palettes on top of one shared definition.
+    class SkeletonInstancePool{
+        public:
+            struct Releaser{
+                SkeletonInstancePool* pool = nullptr;
+                void operator()(SkeletonInstance* instance) const {if(pool) pool->release(instance);}
+            };
+            using Handle = std::unique_ptr<SkeletonInstance, Releaser>;
+
+            SkeletonInstancePool(std::shared_ptr<const SkeletonDefinition> definition, size_t capacity);
+            SkeletonInstancePool(const SkeletonInstancePool&) = delete;
+            SkeletonInstancePool& operator=(const SkeletonInstancePool&) = delete;
+
+            //instance in rest pose, empty handle when the pool is exhausted
+            Handle acquire();
+
+            const std::shared_ptr<const SkeletonDefinition>& getDefinition() const {return definition;}
+            size_t getCapacity() const {return instances.size();}
+            size_t getUsed() const;
+            //pose and palette bytes of all instances
+            size_t getMemoryUsage() const;
+        private:
+            void release(SkeletonInstance* instance);
+
+            std::shared_ptr<const SkeletonDefinition> definition;
+            std::vector<float> poseStorage;
+            std::vector<glm::mat4> paletteStorage;
+            std::vector<SkeletonInstance> instances;
+            mutable std::mutex mutex;
+            std::vector<uint32_t> freeList;
+    };
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "skeleton.hpp"
+
+#include <glm/glm.hpp>
+#include <string>
+
+namespace ve{
+    // Hip -> knee -> paw or shoulder -> elbow -> paw. Joints between root and mid (or mid and end) are
+    // allowed, they stay rigid and move with the joint above them.
+    struct TwoBoneChain{
+        int root = -1;
+        int mid = -1;
+        int end = -1;
+    };
+
+    // Goal of one chain in the skeleton's model space, the space of Skeleton::getModelMatrix.
+    struct TwoBoneGoal{
+        glm::vec3 target{0.0f};
+        //point the middle joint bends towards, must not lie on the line from root to target
+        glm::vec3 pole{0.0f, 0.0f, 1.0f};
+        //0 keeps the animated pose, 1 reaches the target
+        float weight = 1.0f;
+    };
+
+    // Closed form two bone IK: law of cosines for the middle joint, no iteration, so the cost of a solve
+    // is fixed. Runs after sampling on the local rotations of root and mid. The skeleton's model matrices
+    // have to be current (update or updateDirty), the solved joints are marked dirty and one updateDirty
+    // afterwards refreshes all chains. Targets out of reach are approached along the straightened chain.
+    namespace twoBoneIK{
+        //chain ending at the named joint, walking two parents up. root is -1 when there is no such chain
+        TwoBoneChain findChain(const Skeleton& skeleton, const std::string& endJoint);
+        bool isValid(const Skeleton& skeleton, const TwoBoneChain& chain);
+        //one chain, scalar reference
+        void solve(Skeleton& skeleton, const TwoBoneChain& chain, const TwoBoneGoal& goal);
+        //count chains in groups of simd::WIDTH, one chain per lane: the four legs of a dog in one call.
+        //Chains must not contain each other's joints
+        void solveBatch(Skeleton& skeleton, const TwoBoneChain* chains, const TwoBoneGoal* goals, size_t count);
+    }
+}
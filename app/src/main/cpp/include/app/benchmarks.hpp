@@ -0,0 +1,73 @@
+#pragma once
+#include "animation.hpp"
+#include "skeleton.hpp"
+#include "pose.hpp"
+
+#include <memory>
+
+// On-device micro benchmarks for the animation runtime. Results are written to logcat.
+// Built into the engine only when configured with -DVE_RUN_BENCHMARKS=ON, in which case
+// FirstApp::init runs them once before the first frame.
+namespace ve::benchmarks{
+    //synthetic rig: a single chain of numJoints joints, node index == joint index
+    std::unique_ptr<Skeleton> createChainSkeleton(int numJoints);
+    //synthetic dog of 50 joints: pelvis with four hip -> knee -> paw legs ("paw_0".."paw_3") and toes, a spine,
+    //neck and "head" with ears and jaw, and a 20 joint tail
+    std::unique_ptr<Skeleton> createQuadrupedSkeleton();
+    //synthetic clip: one translation, rotation and scale channel per joint with keysPerChannel keys at 30Hz
+    std::shared_ptr<Animation> createSyntheticClip(int numJoints, int keysPerChannel);
+
+    //per-frame sampling cost while key count goes from 30 to 30000 (should stay flat), and the cursor
+    //against a fresh binary search after playback, seeks and wraps
+    void runKeyframeLookupBenchmark();
+
+    //bytes per clip, playback cost and pose error of a quantized clip against the float original
+    void runCompressionBenchmark();
+    //playback/seek cost and memory of authored keys against clips baked to 30 and 60 Hz
+    void runBakeBenchmark();
+    //scalar Animation::update against the simd Animation::sample into a Pose
+    void runBatchSamplingBenchmark();
+    //tolerance check of the batch sampler against the scalar path, logs and returns the result
+    bool validateBatchSampler();
+    //many instances sampled into pooled poses, on one thread and split over worker threads
+    void runPosePoolBenchmark();
+    //clip memory for 20 breeds with and without the shared ClipLibrary, plus identity retarget and clip set checks
+    void runClipLibraryBenchmark();
+    //hits and bytes saved when five models intern identical samplers
+    void runSamplerDedupBenchmark();
+    //keys, bytes, playback cost and model space drift of reduced clips on smooth and noisy curves
+    void runKeyReductionBenchmark();
+    //update cost of many instances at each animation LOD level and the error of reduced rates
+    void runAnimationLodBenchmark();
+    //recursive against flat parents-first joint matrix update for deep, long and branching rigs
+    void runHierarchyBenchmark();
+    //single joint edits with a full update against marking and updating only the dirty subtree
+    void runDirtyUpdateBenchmark();
+    //memory and update cost of per object skeleton copies against one shared rig with pooled instances
+    void runSkeletonInstanceBenchmark();
+    //two bone leg IK solves per second, scalar per leg against four legs per simd call
+    void runTwoBoneIKBenchmark();
+    //FABRIK iterations and solve time on a moving target, cold start from the sampled pose against warm start
+    void runFabrikBenchmark();
+    //CCD with and without swing/twist limits: iterations, solve time and joints left outside their limits
+    void runCCDBenchmark();
+    //damped least squares with four paw and one head effector on the 50 joint dog: Jacobian sparsity, iterations, time
+    void runDLSBenchmark();
+    //BVH paw raycasts for many dogs, one ray at a time against batched packets, and legs planted on uneven ground
+    void runFootPlacementBenchmark();
+    //look-at on neck/head over a limited spine in one pass: aim error, limits and cost against chain length
+    void runAimConstraintBenchmark();
+    //joint editor IK drags of a paw and the head: iterations and solve + subtree update time per drag event
+    void runIKDragBenchmark();
+    //CPU linear blend skinning of a dog sized mesh: glm reference, SIMD on one thread and on worker threads, vertices/ms
+    void runCpuSkinningBenchmark();
+    //dual quaternion against linear blend skinning: palette bytes, conversion cost, kernel throughput and a twisted joint
+    void runDualQuaternionSkinningBenchmark();
+    //joint palettes of a crowd: fixed 200 joint buffers per object against the shared, right-sized ring
+    void runJointPaletteBenchmark();
+    //PackedVertex against the float vertex: bytes fetched per vertex and index, encoding error and CPU skinning into both
+    void runPackedVertexBenchmark();
+
+    //runs every benchmark above, logs each failed check and returns how many failed
+    int runAll();
+}
@@ -15,6 +15,8 @@
 #include "frame_info.hpp"
 #include "shadow_manager.hpp"
 #include "animation_sequencer.hpp"
+#include "collision_bvh.hpp"
+#include "joint_palette_ring.hpp"
 //render systems
 #include "pbr_render_system.hpp"
 #include "point_light_system.hpp"
@@ -22,6 +24,7 @@
 #include "cube_map_system.hpp"
 #include "skeleton_system.hpp"
 #include "shadow_render_system.hpp"
+#include "skinning_system.hpp"
 
 //core libraries
 #include <android/asset_manager.h>
@@ -80,6 +83,8 @@ namespace ve {
 
     private:
             void loadGameObjects();
+            //collision triangles of every static object, for foot placement
+            void buildCollision();
             void loadTextures();
             int getNumLights();
             void renderDogModelList();
@@ -106,6 +111,8 @@ namespace ve {
             std::unique_ptr<VeDescriptorSetLayout> globalSetLayout;
             std::vector<VkDescriptorSet> globalDescriptorSets;
             std::vector<std::unique_ptr<VeBuffer>> uniformBuffers;
+            //joint palettes of every animated object, set 1 of the pbr pass and set 0 of the shadow pass
+            std::unique_ptr<JointPaletteRing> jointPalettes;
             //texture descriptor
             std::unique_ptr<VeDescriptorSetLayout> textureSetLayout;
             VkDescriptorSet textureDescriptorSet = VK_NULL_HANDLE;
@@ -129,9 +136,11 @@ namespace ve {
             std::unique_ptr<CubeMapRenderSystem> cubeMapRenderSystem;
             std::unique_ptr<SkeletonSystem> skeletonSystem;
             std::unique_ptr<ShadowRenderSystem> shadowRenderSystem;
+            std::unique_ptr<SkinningSystem> skinningSystem;
 
             //scene entities
             VeGameObject::Map gameObjects;
+            CollisionBVH collision;
             EngineInfo engineInfo;
             AnimationSequencer animationSequencer;
             std::unique_ptr<ShadowManager> shadowManager;
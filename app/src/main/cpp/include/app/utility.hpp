@@ -40,6 +40,9 @@ namespace ve{
 
 
     inline void UpdateOrCreateKeyframe(ve::Animation::Sampler& sampler, float time, const glm::vec4& value) {
+        // Baked samplers derive their key times from the rate, edit explicit ones
+        sampler.makeIrregular();
+
         // Look for existing keyframe at this time
         bool keyframeExists = false;
         size_t keyframeIndex = 0;
@@ -107,6 +110,8 @@ namespace ve{
     }
     inline void SaveJointKeyframe(ve::Animation& animation, ve::Skeleton* skeleton, int jointIndex, float time,
                                   bool saveRotation, bool saveTranslation) {
+        // Keyframes are edited in float form
+        animation.decompress();
         // Find channels for this joint
         bool rotationChannelFound = false;
         bool translationChannelFound = false;
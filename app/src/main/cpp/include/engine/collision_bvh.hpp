@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace ve{
+    struct Ray{
+        glm::vec3 origin{0.0f};
+        //hit distances are measured in multiples of this vector's length
+        glm::vec3 direction{0.0f, -1.0f, 0.0f};
+        float maxDistance = 1e30f;
+    };
+
+    struct RayHit{
+        //index into the BVH's triangles, -1 when the ray hit nothing
+        int triangle = -1;
+        float distance = 0.0f;
+        glm::vec3 position{0.0f};
+        //unit geometric normal facing the ray origin
+        glm::vec3 normal{0.0f, 1.0f, 0.0f};
+
+        bool hit() const {return triangle >= 0;}
+    };
+
+    //traversal counters, summed over every ray of a call
+    struct RaycastStats{
+        size_t nodeVisits = 0;
+        size_t triangleTests = 0;
+    };
+
+    // Bounding volume hierarchy over static collision triangles (the ground quad and unskinned meshes), in
+    // world space. Built once after the static objects are loaded: nodes split at the centroid median of
+    // their longest axis until at most LEAF_TRIANGLES remain, so a ray visits O(log n) nodes. Nodes are
+    // stored depth first, the left child follows its parent. The batched raycast sorts rays by origin and
+    // walks packets of PACKET_SIZE rays together, a node's bounds are loaded once per packet instead of
+    // once per ray, which is what many dogs with four paw rays each need.
+    class CollisionBVH{
+        public:
+            static constexpr uint32_t LEAF_TRIANGLES = 4;
+            static constexpr size_t PACKET_SIZE = 64;
+
+            void clear();
+            //world space copy of an indexed triangle list, call build afterwards
+            void addTriangles(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const glm::mat4& transform);
+            void build();
+            bool empty() const {return nodes.empty();}
+            size_t getTriangleCount() const {return triangles.size();}
+            size_t getNodeCount() const {return nodes.size();}
+
+            //closest hit along the ray
+            RayHit raycast(const Ray& ray, RaycastStats* stats = nullptr) const;
+            //hits[i] is the closest hit of rays[i]
+            void raycast(const Ray* rays, RayHit* hits, size_t count, RaycastStats* stats = nullptr) const;
+        private:
+            struct Triangle{
+                glm::vec3 vertex;
+                glm::vec3 edge1;
+                glm::vec3 edge2;
+            };
+            struct Node{
+                glm::vec3 boundsMin;
+                //leaf: first triangle, interior: index of the right child
+                uint32_t offset;
+                glm::vec3 boundsMax;
+                //triangles in a leaf, 0 for interior nodes
+                uint32_t count;
+            };
+            //ray data the traversal needs, precomputed once per ray
+            struct TraversalRay{
+                glm::vec3 origin;
+                glm::vec3 direction;
+                glm::vec3 inverseDirection;
+            };
+            uint32_t buildNode(std::vector<uint32_t>& order, uint32_t begin, uint32_t end, const std::vector<glm::vec3>& centroids);
+            static TraversalRay prepare(const Ray& ray);
+            //entry distance into the node's bounds, or a value above limit when the ray misses them
+            static float intersectBounds(const Node& node, const TraversalRay& ray, float limit);
+            bool intersectTriangle(uint32_t index, const TraversalRay& ray, RayHit& hit) const;
+            static void finishHit(const Triangle& triangle, const TraversalRay& ray, RayHit& hit);
+
+            std::vector<Triangle> triangles;
+            std::vector<Node> nodes;
+    };
+}
@@ -7,6 +7,7 @@
 //engine
 #include "ve_game_object.hpp"
 #include "frame_info.hpp"
+#include "ik_drag.hpp"
 //glm
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -33,6 +34,11 @@ namespace ve{
         glm::quat originalRotation{1.0f, 0.0f, 0.0f, 0.0f};  // Identity quaternion
         glm::vec3 originalScale{1.0f};
         glm::vec3 currentEditPosition{0.0f};
+        // IK drag: the selected joint is an end effector and the chain above it follows the gizmo
+        bool ikDragMode = false;
+        int ikChainLength = 2;
+        glm::vec3 ikTarget{0.0f};  // model space
+        std::vector<std::pair<int, glm::quat>> ikOriginalRotations;
 
         // Reset state when needed
         void reset() {
@@ -49,11 +55,20 @@ namespace ve{
             currentEditPosition = glm::vec3(0.0f);
             currentOperation = ImGuizmo::TRANSLATE;
             currentMode = ImGuizmo::WORLD;
-
+            ikDragMode = false;
+            ikChainLength = 2;
+            ikTarget = glm::vec3(0.0f);
+            ikOriginalRotations.clear();
         }
     };
     class JointEditor{
     private:
+        IKDrag ikDrag;
+
+        // Start or restart the IK drag on the selected joint
+        void BeginIKDrag(VeGameObject& gameObject);
+        // Gizmo on the IK target, every manipulation is one drag event
+        void RenderIKGizmo(VeGameObject& gameObject, EngineInfo& engineInfo);
 
     public:
         JointEditorState state;
@@ -93,7 +108,7 @@ namespace ve{
         void SaveJointPose(VeGameObject& gameObject, int jointIndex);
 
         // Reset editor state (useful when switching models/scenes)
-        void Reset() { state.reset(); }
+        void Reset() { state.reset(); ikDrag.end(); }
 
 
 
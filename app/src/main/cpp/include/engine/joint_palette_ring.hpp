@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ve_device.hpp"
+#include "ve_descriptors.hpp"
+#include "buffer.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ve{
+    // Joint palettes of every animated object in one persistently mapped storage buffer per frame in flight.
+    // Each object writes exactly its joint count (64 byte matrices or 32 byte dual quaternions) behind the
+    // previous one and draws with the returned base index as a push constant, so all of them share one
+    // descriptor set and nothing is uploaded for joints a model does not have. The frame's buffer is reset by
+    // beginFrame and grows (contents kept, descriptor set rewritten) when a frame needs more than its capacity.
+    // Write every palette of a frame after beginFrame and before its commands bind the set, then flush once.
+    class JointPaletteRing{
+        public:
+            //palettes are addressed in vec4s, the shaders read vec4 jointData[]
+            static constexpr VkDeviceSize ENTRY_SIZE = 16;
+            //256 quadruped sized palettes of 64 matrices
+            static constexpr VkDeviceSize DEFAULT_CAPACITY = 1024 * 1024;
+
+            //where one object's palette is in a frame's buffer, valid until that frame comes around again
+            struct Allocation{
+                uint64_t serial = 0;
+                uint32_t base = 0;
+                uint32_t jointCount = 0;
+            };
+
+            JointPaletteRing(VeDevice& device, VeDescriptorPool& descriptorPool, VkDeviceSize capacity = DEFAULT_CAPACITY);
+            JointPaletteRing(const JointPaletteRing&) = delete;
+            JointPaletteRing& operator=(const JointPaletteRing&) = delete;
+
+            //the frame's previous palettes are done on the GPU once its fence was waited for
+            void beginFrame(int frameIndex);
+            //size bytes for jointCount joints, rounded up to ENTRY_SIZE
+            Allocation write(int frameIndex, const void* data, VkDeviceSize size, uint32_t jointCount);
+            void flush(int frameIndex);
+            //whether allocation was written for the frame that is being recorded
+            bool isCurrent(const Allocation& allocation, int frameIndex) const;
+
+            VkDescriptorSetLayout getSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+            VkDescriptorSet getDescriptorSet(int frameIndex) const { return frames[frameIndex].descriptorSet; }
+            VkDeviceSize getUsedBytes(int frameIndex) const { return frames[frameIndex].used; }
+            VkDeviceSize getCapacity(int frameIndex) const { return frames[frameIndex].buffer->getBufferSize(); }
+
+        private:
+            struct Frame{
+                std::unique_ptr<VeBuffer> buffer;
+                VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+                VkDeviceSize used = 0;
+                uint64_t serial = 0;
+            };
+            std::unique_ptr<VeBuffer> createBuffer(VkDeviceSize capacity);
+            void grow(Frame& frame, VkDeviceSize required);
+
+            VeDevice& veDevice;
+            VeDescriptorPool& descriptorPool;
+            std::unique_ptr<VeDescriptorSetLayout> setLayout;
+            std::vector<Frame> frames;
+            uint64_t nextSerial = 1;
+    };
+}
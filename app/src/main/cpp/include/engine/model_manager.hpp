@@ -7,6 +7,7 @@
 
 #include "ve_device.hpp"
 #include "ve_model.hpp"
+#include "clip_library.hpp"
 
 #include <android/asset_manager.h>
 
@@ -41,6 +42,10 @@ namespace ve{
         void clearAll();
 
         void startAsyncLoad(const std::string& name);
+        // Applies to models loaded after the call
+        void setAnimationImportSettings(const AnimationImportSettings& settings);
+        // Clips are parsed once and shared by every breed that can bind them by joint name
+        ClipLibrary& getClipLibrary() { return clipLibrary_; }
 
     private:
         VeDevice& device_;
@@ -54,6 +59,8 @@ namespace ve{
         // Async loading
         std::unordered_map<std::string, std::future<std::shared_ptr<VeModel>>> loading_;
         mutable std::mutex mutex_;
+        AnimationImportSettings animationSettings_;
+        ClipLibrary clipLibrary_;
 
         // Helper methods
         void addToCache(const std::string& name, std::shared_ptr<VeModel> model);
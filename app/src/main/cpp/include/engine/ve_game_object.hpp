@@ -4,6 +4,9 @@
 #include "ve_device.hpp"
 #include "ve_descriptors.hpp"
 #include "cube_map.hpp"
+#include "ve_camera.hpp"
+#include "foot_placement.hpp"
+#include "joint_palette_ring.hpp"
 #include "debug.hpp"
 
 #include <android/asset_manager.h>
@@ -29,10 +32,47 @@ namespace ve{
         VkDescriptorSet descriptorSet;
         std::unique_ptr<VeDescriptorSetLayout> descriptorSetLayout;
     };
+    //one frame in flight's copy of the model's vertices, skinned by SkinningSystem
+    struct SkinnedVertices{
+        std::unique_ptr<VeBuffer> buffer;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        //model whose vertices the buffer holds (the descriptor set reads its vertex buffer), empty until the
+        //first dispatch
+        std::shared_ptr<const VeModel> model;
+        //host visible and written by CpuSkinning instead of the compute pass
+        bool hostVisible = false;
+    };
     struct AnimationComponent{
-        std::unique_ptr<VeDescriptorSetLayout> animationSetLayout;
-        std::vector<VkDescriptorSet> animationDescriptorSets;
-        std::vector<std::unique_ptr<VeBuffer>> shaderJointsBuffer;
+        //shared buffer the joint palette is written to every frame
+        JointPaletteRing* jointPalettes = nullptr;
+        //this object's palette per frame in flight, exactly the model's joint count
+        std::vector<JointPaletteRing::Allocation> jointPaletteAllocations;
+        //own rig instance and clip time when created with createAnimatedInstance, empty for objects that play
+        //the model's clip on its skeleton
+        SkeletonInstancePool::Handle skeletonInstance;
+        float animationTime = 0.0f;
+        //animation level of detail, picked from the screen size every frame
+        AnimationLodPolicy lodPolicy;
+        int lodLevel = 0;
+        float screenSize = 0.0f;
+        //reduced rate sampling into this object's pose: the skeleton instance's, or pose below
+        AnimationLodState animationLod;
+        //sampled pose of an object without a skeleton instance, written to the skeleton before the post-processes
+        PoseBuffer pose;
+        //skeleton pose was set up for, a model change starts again from the new rest pose
+        const Skeleton* poseSkeleton = nullptr;
+        //frame the pose was last sampled and solved in
+        int poseFrameCount = -1;
+        //its joint matrices after the post-processes, drawn again while the pose is frozen
+        std::vector<glm::mat4> jointMatrices;
+        //paws planted on the static collision geometry, bound to the model's skeleton on first use. Solved on
+        //this object's pose once per sampled frame, see solvePose
+        FootPlacement footPlacement;
+        bool footPlacementEnabled = true;
+        //per frame in flight, skinned once and drawn by every pass
+        std::vector<SkinnedVertices> skinnedVertices;
+        //palette converted for SkinningMethod::DualQuaternion models, reused every frame
+        std::vector<DualQuaternion> dualQuaternionPalette;
     };
 
     class VeGameObject { 
@@ -50,9 +90,22 @@ namespace ve{
             static VeGameObject createPointLight(float intensity=1.0f, float radius=0.1f, glm::vec3 color=glm::vec3(1.0f));
             //instantiation of cube map
             static VeGameObject createCubeMap(VeDevice& device, AAssetManager* assetManager, const std::vector<std::string>& faces, VeDescriptorPool& descriptorPool);
-            //instantiation of game object with animation
-            static VeGameObject createAnimatedObject(VeDevice& device, VeDescriptorPool& descriptorPool, std::shared_ptr<VeModel> veModel);
+            //instantiation of game object with animation, its joint palette is written to jointPalettes
+            static VeGameObject createAnimatedObject(JointPaletteRing& jointPalettes, std::shared_ptr<VeModel> veModel);
+            //same, with a pooled skeleton instance and a clip clock of its own, so objects of one model play it
+            //out of step. Animation LOD, aim constraints and foot placement work as for createAnimatedObject. The
+            //timeline and the joint editor seek and pose the model's clip and skeleton, an instance does not
+            //follow them: the edited object stays a createAnimatedObject
+            static VeGameObject createAnimatedInstance(JointPaletteRing& jointPalettes, std::shared_ptr<VeModel> veModel);
             void updateAnimation(float deltaTime, int frameCounter, int frameIndex);
+            //same, at the LOD level chosen from the object's screen size through camera. With collision the
+            //paws are placed on it after sampling
+            void updateAnimation(float deltaTime, int frameCounter, int frameIndex, const VeCamera& camera, const CollisionBVH* collision = nullptr);
+            //binds this frame's pre-skinned vertices when SkinningSystem wrote them, the model's own otherwise.
+            //Returns whether the vertex shader still has to skin, with getJointPalette's palette
+            bool bindModel(VkCommandBuffer commandBuffer, int frameIndex);
+            //where this frame's joint palette is in the shared buffer, jointCount 0 when none was written
+            JointPaletteRing::Allocation getJointPalette(int frameIndex) const;
 
             VeGameObject(const VeGameObject&) = delete;
             VeGameObject& operator=(const VeGameObject&) = delete;
@@ -104,6 +157,18 @@ namespace ve{
             //instantiation of VeGameobject is only allowed through createGameObject to 
             //make sure id is unique (incrementing)
             VeGameObject(id_t objId): id{objId} {}
+            //sample the model's current clip at this object's own time into its skeleton instance
+            void updateInstanceAnimation(float deltaTime, int frameCounter, int frameIndex, const AnimationLodLevel* lod,
+                                         const CollisionBVH* collision);
+            //sample the model's current clip at the model's time into this object's pose
+            void updateModelAnimation(float deltaTime, int frameCounter, int frameIndex, const AnimationLodLevel* lod,
+                                      const CollisionBVH* collision);
+            //compose pose on the model's skeleton, then aim and, with collision, place the paws on it. The result
+            //is in the skeleton's jointMatrices
+            void solvePose(const Pose& pose, float deltaTime, const CollisionBVH* collision);
+            //joint matrices to the frame's joint palette, as matrices or dual quaternions per the model's skinningMethod.
+            //An unchanged pose (frozen LOD) is written again without converting it again
+            void writeJointPalette(int frameIndex, const glm::mat4* matrices, size_t count, bool poseChanged = true);
             id_t id;
             char title[26]; 
             uint32_t textureIndex = -1;
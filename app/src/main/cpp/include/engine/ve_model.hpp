@@ -4,6 +4,12 @@
 #include "ve_device.hpp"
 #include "skeleton.hpp"
 #include "animation_manager.hpp"
+#include "animation_lod.hpp"
+#include "skeleton_definition.hpp"
+#include "aim_constraint.hpp"
+#include "dual_quaternion.hpp"
+#include "vertex_packing.hpp"
+#include "cpu_skinning.hpp"
 #include "buffer.hpp"
 #include "ve_descriptors.hpp"
 #include "ve_texture.hpp"
@@ -16,6 +22,8 @@
 //cpp headers
 #include <vector>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 #ifndef ENGINE_DIR
 #define ENGINE_DIR "../"
@@ -29,8 +37,44 @@ namespace ve{
         VkDescriptorImageInfo albedoInfo;
     };
 
+    class ClipLibrary;
+
+    //per clip options applied by VeModel::loadAnimations
+    struct ClipImportSettings{
+        //resample every sampler onto this rate (Hz) for O(1) keyframe lookup, 0 keeps the authored keys
+        float bakeRate = 0.0f;
+        //samplers whose baked curve deviates more than this from the original keep their authored keys
+        float maxRotationError = 0.001f;   //radians
+        float maxLinearError = 0.001f;     //translation and scale units
+        //drop keys the curve reproduces within tolerance (see Animation::reduceKeys), ignored when baking
+        bool reduceKeys = false;
+        Animation::ReductionSettings reduction;
+        //store the keys quantized (see Animation::compress)
+        bool compress = false;
+        //intern float keys in SamplerStore::global so identical samplers are stored once
+        bool deduplicate = true;
+    };
+    struct AnimationImportSettings{
+        ClipImportSettings defaults;
+        //when set, clips already in the library are bound to this model by joint name instead of being parsed
+        ClipLibrary* clipLibrary = nullptr;
+        //motion source the model's clips were authored from, models of one set share their clips by name.
+        //Empty keeps the model's clips to itself
+        std::string clipSet;
+        //cosmetic joints (ears, tongue, toes) reduced animation LOD levels stop animating, see Skeleton::setLodMask
+        std::vector<std::string> lodMaskJoints;
+        //overrides keyed by the glTF animation name
+        std::unordered_map<std::string, ClipImportSettings> clips;
+
+        const ClipImportSettings& forClip(const std::string& name) const{
+            auto it = clips.find(name);
+            return it != clips.end() ? it->second : defaults;
+        }
+    };
+
     class VeModel{
     public:
+        //what the loaders produce, VeModel packs it into PackedVertex plus an optional color stream
         struct Vertex{
             glm::vec3 position;
             glm::vec3 color;
@@ -40,9 +84,6 @@ namespace ve{
             glm::ivec4 jointIndices;
             glm::vec4 jointWeights;
 
-            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
-            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
-
             bool operator==(const Vertex& other) const{
                 return  position == other.position && 
                         color == other.color && 
@@ -59,8 +100,13 @@ namespace ve{
             std::vector<Vertex> vertices;
             std::vector<uint32_t> indices;
             tinygltf::Model model;
+            //skin joint index of every skeleton joint: depth first from the roots, so parents come before
+            //their children and each subtree is a contiguous range (see sortSkinJoints)
+            std::vector<int> jointOrder;
 //            void loadModel(const std::string& filePath, AAssetManager *assetManager);
             void loadModelGLTF(const std::string& filePath, AAssetManager *assetManager);
+            //fill jointOrder from the first skin and remap the vertex joint indices to it
+            void sortSkinJoints();
             void loadCubeMap(glm::vec3 cubeVetices[CUBE_MAP_VERTEX_COUNT]);
             void loadQuad();
         };
@@ -70,30 +116,73 @@ namespace ve{
         VeModel(const VeModel&) = delete;
         VeModel& operator=(const VeModel&) = delete;
 
-        static std::unique_ptr<VeModel> createModelFromFile(VeDevice& device,AAssetManager *assetManager, VeDescriptorPool& descriptorPool, const std::string& filePath);
+        static std::unique_ptr<VeModel> createModelFromFile(VeDevice& device,AAssetManager *assetManager, VeDescriptorPool& descriptorPool, const std::string& filePath,
+                                                            const AnimationImportSettings& animationSettings = {});
         static std::unique_ptr<VeModel> createCubeMap(VeDevice& device, glm::vec3 cubeVetices[CUBE_MAP_VERTEX_COUNT]);
         static std::unique_ptr<VeModel> createQuad(VeDevice& device);
 
+        //PackedVertex at binding 0 and the color stream at binding 1, which advances per vertex only for
+        //pipelines drawing models with vertex colors and repeats a single white entry otherwise
+        static std::vector<VkVertexInputBindingDescription> getBindingDescriptions(bool vertexColors = false);
+        static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
         void bind(VkCommandBuffer commandBuffer);
+        //this model's index buffer with vertices from another buffer in the same layout (pre-skinned copies)
+        void bind(VkCommandBuffer commandBuffer, VkBuffer vertices);
         void draw(VkCommandBuffer commandBuffer);
         void drawInstanced(VkCommandBuffer commandBuffer, uint32_t instanceCount);
-        void updateAnimation(float deltaTime, int frameCounter, int frameIndex);
+        //moves the current clip on once per frame for every object playing this model, returns the clip seconds
+        //it advanced this frame. Objects sample their own pose at the clip's time, see VeGameObject::updateAnimation
+        float advanceAnimation(float deltaTime, int frameCounter);
+        //whether the clip ran this frame, false while it is paused or stopped. Whether an object's pose was
+        //sampled is up to its own LOD state
+        bool wasClipRunning() const { return clipRunning; }
+        //look-at and aim post-process on the current pose of skeleton, the skeleton's matrices are current again afterwards
+        void applyAimConstraints();
 
         AnimationManager& getAnimationManager() { return *animationManager.get(); }
         bool hasAnimationData() const { return hasAnimation; }
+        //bind pose bounds in model space
+        const glm::vec3& getBoundingCenter() const { return boundingCenter; }
+        float getBoundingRadius() const { return boundingRadius; }
+        //device local, also usable as a storage buffer by the skinning compute pass
+        VkBuffer getVertexBuffer() const { return vertexBuffer->getBuffer(); }
+        uint32_t getVertexCount() const { return vertexCount; }
+        //whether it needs a pipeline from getBindingDescriptions(true), false when every vertex is white
+        bool hasVertexColors() const { return vertexColors; }
+        //float bind pose of skinned glTF models for CpuSkinning, empty until SkinningSystem builds it in Cpu mode
+        const std::vector<SkinningVertex>& getSkinningVertices() const { return skinningVertices; }
+        //decodes the model's getVertexCount() packed vertices, e.g. read back from the vertex buffer
+        void buildSkinningVertices(const PackedVertex* packed);
+        //back to GPU skinning, nothing reads the float bind pose anymore
+        void releaseSkinningVertices() { std::vector<SkinningVertex>().swap(skinningVertices); }
+        //triangles of static meshes in model space for CollisionBVH, empty for skinned models and the cube map
+        const std::vector<glm::vec3>& getCollisionPositions() const { return collisionPositions; }
+        const std::vector<uint32_t>& getCollisionIndices() const { return collisionIndices; }
 
+        //pose edited by the joint editor, animated objects compose their own pose on it in turn
         std::unique_ptr<Skeleton> skeleton;
+        //rig shared by every instance of this model, instances own only a pose and a palette
+        std::shared_ptr<const SkeletonDefinition> skeletonDefinition;
+        static constexpr size_t MAX_SKELETON_INSTANCES = 64;
+        //pose and palette of its own for one game object, empty handle without a skeleton or when all are taken
+        SkeletonInstancePool::Handle acquireSkeletonInstance();
         std::shared_ptr<AnimationManager> animationManager;
+        //look-at and aim post-process on the sampled pose of skeleton, see AimConstraintSet
+        AimConstraintSet aimConstraints;
+        //how the vertex shaders, the skinning pass and CpuSkinning blend joints for this model
+        SkinningMethod skinningMethod = SkinningMethod::LinearBlend;
 
         std::unique_ptr<MaterialComponent> materialComponent = nullptr;
 
 
     private:
         void createVertexBuffers(const std::vector<Vertex>& vertices);
+        void createColorBuffer(const std::vector<Vertex>& vertices);
         void createIndexBuffers(const std::vector<uint32_t>& indices);  
-        void loadSkeleton(const tinygltf::Model& model);
-        void loadAnimations(const tinygltf::Model& model);
-        void loadJoints(int nodeIndex, int parentIndex, const tinygltf::Model& model);
+        void keepCollisionGeometry(const Builder& builder);
+        void loadSkeleton(const tinygltf::Model& model, const std::vector<int>& jointOrder);
+        void loadAnimations(const tinygltf::Model& model, const AnimationImportSettings& settings);
         void extractNodeTransform(const tinygltf::Node& node, Joint& joint);
         glm::mat4 calculateLocalTransform(const Joint& joint);
         void updateJointHierarchy(const tinygltf::Model& model);
@@ -103,12 +192,25 @@ namespace ve{
         //vertex buffer
         std::unique_ptr<VeBuffer> vertexBuffer;
         uint32_t vertexCount;
-        //index buffer
+        //one unorm8x4 per vertex, or a single white one
+        std::unique_ptr<VeBuffer> colorBuffer;
+        bool vertexColors{false};
+        //index buffer, 16 bit when every index fits
         bool hasIndexBuffer{false};
         std::unique_ptr<VeBuffer> indexBuffer;
         uint32_t indexCount;
+        VkIndexType indexType{VK_INDEX_TYPE_UINT32};
         //animation data
         bool hasAnimation{false};
+        std::unique_ptr<SkeletonInstancePool> skeletonInstances;
+        int advanceFrameCount{-1};
+        float frameAdvance{0.0f};
+        bool clipRunning{false};
+        glm::vec3 boundingCenter{0.0f};
+        float boundingRadius{0.0f};
+        std::vector<glm::vec3> collisionPositions;
+        std::vector<uint32_t> collisionIndices;
+        std::vector<SkinningVertex> skinningVertices;
         //materials
     };
 }
\ No newline at end of file
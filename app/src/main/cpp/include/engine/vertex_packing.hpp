@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ve{
+    // What a VeModel's vertex buffer holds, 36 bytes against the 88 of VeModel::Vertex. Normals and tangents
+    // are octahedral encoded into two snorm16s, uvs are halfs, joints are bytes and weights unorm16s. Vertex
+    // color is a separate stream (binding 1) that models without vertex colors do not have, see
+    // VeModel::getBindingDescriptions. The shaders and the skinning pass decode it, CpuSkinning writes it
+    // from a float SkinningVertex bind pose through SkinningLayout.
+    struct PackedVertex{
+        glm::vec3 position{0.0f};   //R32G32B32_SFLOAT
+        uint32_t normal = 0;        //R16G16_SNORM, octahedral
+        uint32_t tangent = 0;       //R16G16_SNORM, octahedral
+        uint32_t uv = 0;            //R16G16_SFLOAT
+        uint32_t jointIndices = 0;  //R8G8B8A8_UINT
+        uint16_t jointWeights[4] = {0, 0, 0, 0};  //R16G16B16A16_UNORM
+    };
+    static_assert(sizeof(PackedVertex) == 36, "the attribute descriptions and skinning.comp expect 36 bytes");
+
+    //skinning.comp reads PackedVertex as 32 bit words, its VERTEX_WORDS, POSITION, NORMAL, TANGENT, JOINTS
+    //and WEIGHTS constants mirror these
+    namespace packedVertexWords{
+        constexpr size_t VERTEX_WORDS = 9;
+        constexpr size_t POSITION = 0;
+        constexpr size_t NORMAL = 3;
+        constexpr size_t TANGENT = 4;
+        constexpr size_t UV = 5;
+        constexpr size_t JOINTS = 6;
+        constexpr size_t WEIGHTS = 7;
+    }
+    static_assert(sizeof(PackedVertex) == packedVertexWords::VERTEX_WORDS * sizeof(uint32_t), "skinning.comp VERTEX_WORDS");
+    static_assert(offsetof(PackedVertex, position) == packedVertexWords::POSITION * sizeof(uint32_t), "skinning.comp POSITION");
+    static_assert(offsetof(PackedVertex, normal) == packedVertexWords::NORMAL * sizeof(uint32_t), "skinning.comp NORMAL");
+    static_assert(offsetof(PackedVertex, tangent) == packedVertexWords::TANGENT * sizeof(uint32_t), "skinning.comp TANGENT");
+    static_assert(offsetof(PackedVertex, uv) == packedVertexWords::UV * sizeof(uint32_t), "PackedVertex uv word");
+    static_assert(offsetof(PackedVertex, jointIndices) == packedVertexWords::JOINTS * sizeof(uint32_t), "skinning.comp JOINTS");
+    static_assert(offsetof(PackedVertex, jointWeights) == packedVertexWords::WEIGHTS * sizeof(uint32_t), "skinning.comp WEIGHTS");
+
+    namespace vertexPacking{
+        //joint indices are bytes, this one marks an influence that keeps the bind pose
+        constexpr int INVALID_JOINT = 255;
+
+        //unit vector onto the octahedron, unfolded into [-1, 1]^2 and stored as two snorm16s (x in the low half)
+        uint32_t packOctahedral(const glm::vec3& v);
+        glm::vec3 unpackOctahedral(uint32_t packed);
+        uint32_t packHalf2(const glm::vec2& v);
+        glm::vec2 unpackHalf2(uint32_t packed);
+        //indices outside [0, INVALID_JOINT) become INVALID_JOINT
+        uint32_t packJoints(const glm::ivec4& joints);
+        glm::ivec4 unpackJoints(uint32_t packed);
+        void packWeights(const glm::vec4& weights, uint16_t packed[4]);
+        glm::vec4 unpackWeights(const uint16_t packed[4]);
+        //white as far as the unorm8 color stream can tell
+        bool isWhite(const glm::vec3& color);
+        uint32_t packColor(const glm::vec3& color);
+
+        //VeModel::Vertex, or any vertex with the same member names
+        template<typename Vertex>
+        PackedVertex pack(const Vertex& vertex){
+            PackedVertex packed;
+            packed.position = vertex.position;
+            packed.normal = packOctahedral(vertex.normal);
+            packed.tangent = packOctahedral(vertex.tangent);
+            packed.uv = packHalf2(vertex.uv);
+            packed.jointIndices = packJoints(vertex.jointIndices);
+            packWeights(vertex.jointWeights, packed.jointWeights);
+            return packed;
+        }
+    }
+}
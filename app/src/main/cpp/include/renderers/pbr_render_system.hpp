@@ -24,6 +24,8 @@ namespace ve {
 
             VeDevice& veDevice;
             std::unique_ptr<VePipeline> vePipeline;
+            //same shaders, per vertex color stream for models with vertex colors
+            std::unique_ptr<VePipeline> vertexColorPipeline;
             VkPipelineLayout pipelineLayout{};
     };
 }
\ No newline at end of file
@@ -24,6 +24,9 @@ namespace ve{
             glm::mat4 mvpMatrix;  // 64 bytes
             glm::vec3 lightPos;   // 12 bytes
             bool isAnimated;      // 1 byte
+            VkBool32 dualQuaternion; // 4 bytes at 80, the shader's next bool
+            uint32_t jointBase;   // palette in the joint palette ring, in vec4s
+            uint32_t jointCount;
         };
 
         ShadowRenderSystem(VeDevice& device, AAssetManager* assetManager, VkRenderPass shadowRenderPass, const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ve_device.hpp"
+#include "ve_game_object.hpp"
+#include "ve_descriptors.hpp"
+#include "frame_info.hpp"
+#include "cpu_skinning.hpp"
+
+#include <android/asset_manager.h>
+#include <memory>
+namespace ve {
+    // Pre-skinning: a compute pass that skins every animated object's vertices once per frame into a
+    // per frame in flight copy of its vertex buffer (AnimationComponent::skinnedVertices). The shadow pass
+    // draws each object 6 times per light and the scene passes once more; they bind the skinned copy through
+    // VeGameObject::bindModel and skip the skinning loop in their vertex shaders. Record it after the joint
+    // palettes are written and flushed and before the first pass that draws. In Cpu mode CpuSkinning writes the copies
+    // through a persistent mapping instead, for GPUs with little compute and vertex throughput. Its float bind pose
+    // (VeModel::getSkinningVertices) is decoded per model on the first Cpu mode frame and released in Compute mode.
+    class SkinningSystem{
+        public:
+            static constexpr uint32_t WORKGROUP_SIZE = 64;
+            enum class Mode{
+                Compute,
+                Cpu
+            };
+
+            //jointPaletteSetLayout: JointPaletteRing's, its frame's set is FrameInfo::animatedDescriptorSet
+            SkinningSystem(VeDevice& device, AAssetManager *assetManager, VkDescriptorSetLayout jointPaletteSetLayout);
+            ~SkinningSystem();
+            SkinningSystem(const SkinningSystem&) = delete;
+            SkinningSystem& operator=(const SkinningSystem&) = delete;
+            //returns how many objects were skinned
+            size_t skinGameObjects(FrameInfo& frameInfo, VeDescriptorPool& descriptorPool);
+            //takes effect per frame in flight as their buffers come around again
+            void setMode(Mode newMode) { mode = newMode; }
+            Mode getMode() const { return mode; }
+            //last object skinned in Cpu mode
+            const SkinningStats& getCpuStats() const { return cpuStats; }
+
+        private:
+            void createDescriptorSetLayout();
+            void createPipelineLayout(VkDescriptorSetLayout jointPaletteSetLayout);
+            void createPipeline(AAssetManager *assetManager);
+            //(re)creates the frame's skinned buffer and descriptor set when the object's model changed
+            bool prepare(VeGameObject& obj, int frameIndex, VeDescriptorPool& descriptorPool);
+            bool prepareHostVisible(VeGameObject& obj, int frameIndex);
+            void skinOnCpu(VeGameObject& obj, int frameIndex);
+
+            VeDevice& veDevice;
+            //source vertices, skinned vertices
+            std::unique_ptr<VeDescriptorSetLayout> skinningSetLayout;
+            VkPipelineLayout pipelineLayout{};
+            VkPipeline pipeline{};
+            Mode mode = Mode::Compute;
+            //worker threads start with the first Cpu mode frame
+            std::unique_ptr<CpuSkinning> cpuSkinning;
+            SkinningStats cpuStats;
+    };
+}
@@ -0,0 +1,131 @@
+#include "aim_constraint.hpp"
+#include "debug.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ve{
+    int AimConstraintSet::add(const Skeleton& skeleton, int root, int aimJoint, const glm::vec3& forward, float maxAngle){
+        IKChain path;
+        if(!path.init(skeleton, root, aimJoint))
+            return -1;
+        AimConstraint constraint;
+        constraint.forward = glm::normalize(forward);
+        for(int joint : path.joints)
+            constraint.chain.push_back({joint, 1.0f, maxAngle});
+        constraints.push_back(constraint);
+        sortConstraints(skeleton);
+        return static_cast<int>(constraints.size()) - 1;
+    }
+
+    int AimConstraintSet::add(const Skeleton& skeleton, const std::string& root, const std::string& aimJoint, const glm::vec3& forward, float maxAngle){
+        int rootIndex = -1;
+        int aimIndex = -1;
+        for(size_t i = 0; i < skeleton.joints.size(); i++){
+            if(skeleton.joints[i].name == root)
+                rootIndex = static_cast<int>(i);
+            if(skeleton.joints[i].name == aimJoint)
+                aimIndex = static_cast<int>(i);
+        }
+        if(rootIndex == -1 || aimIndex == -1){
+            LOGE("Skeleton %s: no joints %s / %s for an aim constraint", skeleton.name.c_str(), root.c_str(), aimJoint.c_str());
+            return -1;
+        }
+        return add(skeleton, rootIndex, aimIndex, forward, maxAngle);
+    }
+
+    bool AimConstraintSet::setJoint(int constraint, int joint, float weight, float maxAngle){
+        for(auto& aim : constraints[constraint].chain){
+            if(aim.joint == joint){
+                aim.weight = std::max(weight, 0.0f);
+                aim.maxAngle = std::max(maxAngle, 0.0f);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void AimConstraintSet::clear(){
+        constraints.clear();
+        order.clear();
+        readsMoved.clear();
+    }
+
+    void AimConstraintSet::setObjectMatrix(const glm::mat4& objectMatrix){
+        worldToModel = glm::inverse(objectMatrix);
+    }
+
+    void AimConstraintSet::sortConstraints(const Skeleton& skeleton){
+        //parents come before their children in the joint array, so root order is a topological order
+        order.resize(constraints.size());
+        for(size_t i = 0; i < order.size(); i++)
+            order[i] = static_cast<int>(i);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b){return constraints[a].chain[0].joint < constraints[b].chain[0].joint;});
+        readsMoved.assign(constraints.size(), false);
+        for(size_t i = 0; i < order.size(); i++){
+            int root = constraints[order[i]].chain[0].joint;
+            for(size_t earlier = 0; earlier < i && !readsMoved[i]; earlier++){
+                for(const auto& aim : constraints[order[earlier]].chain){
+                    for(int joint = root; joint != NO_PARENT && !readsMoved[i]; joint = skeleton.joints[joint].parentIndex)
+                        readsMoved[i] = joint == aim.joint;
+                }
+            }
+        }
+    }
+
+    size_t AimConstraintSet::apply(Skeleton& skeleton){
+        const JointLimit* limits = useLimits && skeleton.jointLimits.size() == skeleton.joints.size() ? skeleton.jointLimits.data() : nullptr;
+        size_t evaluated = 0;
+        for(size_t i = 0; i < order.size(); i++){
+            const auto& constraint = constraints[order[i]];
+            if(!constraint.enabled || constraint.weight <= 0.0f)
+                continue;
+            //a constraint above this one moved a parent, its matrices are stale until updated
+            if(readsMoved[i] && skeleton.isDirty())
+                skeleton.updateDirty();
+            solve(skeleton, constraint, glm::vec3(worldToModel * glm::vec4(constraint.target, 1.0f)), limits);
+            skeleton.markDirty(constraint.chain[0].joint);
+            evaluated++;
+        }
+        return evaluated;
+    }
+
+    void AimConstraintSet::solve(Skeleton& skeleton, const AimConstraint& constraint, const glm::vec3& target, const JointLimit* limits) const{
+        int aimJoint = constraint.chain.back().joint;
+        glm::vec3 aimPosition = ikMath::jointPosition(skeleton, aimJoint);
+        glm::vec3 forward = ikMath::globalRotation(skeleton, aimJoint) * constraint.forward;
+        float remainingWeight = 0.0f;
+        for(const auto& aim : constraint.chain)
+            remainingWeight += aim.weight;
+        //rotations applied so far as one rigid transform of the sampled model space: x' = applied * x + shift
+        glm::quat applied(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 shift(0.0f);
+        for(const auto& aim : constraint.chain){
+            if(aim.weight <= 0.0f)
+                continue;
+            glm::vec3 toTarget = target - aimPosition;
+            if(glm::dot(toTarget, toTarget) < ikMath::EPSILON || remainingWeight <= ikMath::EPSILON)
+                break;
+            //this joint's share of what is still missing
+            glm::quat delta = ikMath::scaleRotation(ikMath::rotationBetween(forward, toTarget), constraint.weight * aim.weight / remainingWeight);
+            remainingWeight -= aim.weight;
+            float angle = 2.0f * std::acos(std::min(delta.w, 1.0f));
+            if(angle > aim.maxAngle){
+                glm::vec3 axis(delta.x, delta.y, delta.z);
+                delta = glm::angleAxis(aim.maxAngle, axis / std::max(glm::length(axis), ikMath::EPSILON));
+            }
+            //a model space delta on a joint with parent rotation P: local' = P^-1 * delta * P * local
+            auto& joint = skeleton.joints[aim.joint];
+            glm::quat parent = applied * ikMath::globalRotation(skeleton, joint.parentIndex);
+            glm::quat sampled = joint.rotation;
+            joint.rotation = glm::normalize(glm::conjugate(parent) * delta * parent * joint.rotation);
+            if(limits && limits[aim.joint].clamp(joint.rotation))
+                delta = glm::normalize(parent * joint.rotation * glm::conjugate(sampled) * glm::conjugate(parent));
+            glm::vec3 pivot = applied * ikMath::jointPosition(skeleton, aim.joint) + shift;
+            applied = glm::normalize(delta * applied);
+            shift = delta * (shift - pivot) + pivot;
+            aimPosition = delta * (aimPosition - pivot) + pivot;
+            forward = delta * forward;
+        }
+    }
+}
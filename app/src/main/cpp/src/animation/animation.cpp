@@ -1,11 +1,60 @@
 #include "animation.hpp"
+#include "skeleton_definition.hpp"
 #include "debug.hpp"
 
 #include <imgui.h>
 #include <vector>
 #include <set>
+#include <algorithm>
+#include <functional>
+#include <cmath>
 #include <iostream>
 namespace ve{
+    namespace{
+        //index i such that keys[i] <= time < keys[i+1], keys can be float seconds or quantized frames
+        template<typename Key>
+        size_t findInterval(const Key* keys, size_t numKeys, float time, size_t& cursor){
+            if(numKeys < 2 || time < keys[0] || time > keys[numKeys - 1]){
+                return Animation::NO_KEYFRAME;
+            }
+            //the last interval is closed so that the final key is still reachable
+            size_t lastInterval = numKeys - 2;
+            //fast path: playback normally stays in the cached interval or moves into the next one
+            if(cursor <= lastInterval && time >= keys[cursor]){
+                if(time < keys[cursor + 1] || cursor == lastInterval){
+                    return cursor;
+                }
+                if(time < keys[cursor + 2] || cursor + 1 == lastInterval){
+                    return ++cursor;
+                }
+            }
+            //after a seek or a wrap around fall back to a binary search
+            const Key* upper = std::upper_bound(keys, keys + numKeys, time);
+            cursor = std::min(static_cast<size_t>(upper - keys) - 1, lastInterval);
+            return cursor;
+        }
+
+        //radians between two rotations, distance between two translations or scales
+        float keyError(Animation::PathType pathType, const glm::vec4& expected, glm::vec4 actual){
+            if(pathType != Animation::PathType::ROTATION){
+                return glm::length(glm::vec3(expected) - glm::vec3(actual));
+            }
+            if(glm::dot(expected, actual) < 0.0f)
+                actual = -actual;
+            //angle from the chord length, acos of the dot product is too coarse in float
+            float chord = glm::length(expected - actual);
+            return 4.0f * std::asin(std::min(1.0f, chord * 0.5f));
+        }
+
+        glm::quat toQuat(const glm::vec4& v){
+            glm::quat q;
+            q.x = v.x;
+            q.y = v.y;
+            q.z = v.z;
+            q.w = v.w;
+            return q;
+        }
+    }
     Animation::Animation(std::string const& name): name(name), isRepeat(true){}
     void Animation::start(){
         if(currentKeyFrameTime==0.0f && currentKeyFrameTime > lastKeyFrameTime)
@@ -26,6 +75,18 @@ namespace ve{
 //            LOGE("Attempting to update Animation %s while it is not running", name.c_str());
             return;
         }
+        advance(deltaTime);
+        sampleChannels(skeleton, false);
+    }
+    float Animation::advance(const float& deltaTime){
+        if(!isRunning()){
+            return 0.0f;
+        }
+        float adjustedDeltaTime = playbackStep(deltaTime);
+        currentKeyFrameTime = wrapTime(currentKeyFrameTime + adjustedDeltaTime);
+        return adjustedDeltaTime;
+    }
+    float Animation::playbackStep(float deltaTime) const{
         float adjustedDeltaTime = deltaTime * playbackSpeed;
 
         // Ensure a minimum impact
@@ -36,204 +97,266 @@ namespace ve{
             // For speeds < 1, ensure some progression
             adjustedDeltaTime = std::max(adjustedDeltaTime, deltaTime * 0.1f);
         }
+        return adjustedDeltaTime;
+    }
+    float Animation::wrapTime(float time) const{
+        if(!isRepeat || time <= lastKeyFrameTime){
+            return time;
+        }
+        float duration = lastKeyFrameTime - firstKeyFrameTime;
+        if(duration <= 0.0f){
+            return firstKeyFrameTime;
+        }
+        //keep the overshoot so a wrapping frame lands where the clip would be, not on the first key
+        return firstKeyFrameTime + std::fmod(time - firstKeyFrameTime, duration);
+    }
+    void Animation::updatePose(Skeleton& skeleton){
 
-        currentKeyFrameTime += adjustedDeltaTime;
-
-        if(isRepeat && (currentKeyFrameTime > lastKeyFrameTime)){
-            currentKeyFrameTime = firstKeyFrameTime;
+        currentKeyFrameTime = wrapTime(currentKeyFrameTime);
+        //updatePose is the seek path, the cached intervals are unlikely to be near the new time
+        invalidateCursors();
+        sampleChannels(skeleton, true);
+    }
+    void Animation::sampleChannels(Skeleton& skeleton, bool logMissingKeyframes){
+        if(channelCursors.size() != channels.size()){
+            channelCursors.assign(channels.size(), 0);
         }
-        
+        const Binding& binding = getBinding(skeleton);
         // std::cout << "Current key frame time: " << currentKeyFrameTime << std::endl;
-        for(auto& channel: channels){
-            auto& sampler = samplers[channel.samplerIndex];
-            int jointIndex = skeleton.nodeJointMap[channel.node];
-            auto& joint = skeleton.joints[jointIndex];
-
-            bool keyFrameFound = false;
-            for(size_t i = 0; i < sampler.timeStamps.size() - 1; i++){
-                if(currentKeyFrameTime>=sampler.timeStamps[i] && currentKeyFrameTime <= sampler.timeStamps[i+1]){
-                    keyFrameFound = true;
-//                    LOGI("Found keyframe interval %f to %f", sampler.timeStamps[i], sampler.timeStamps[i+1]);
-
-                    switch (sampler.interpolationMethod){
-                        case InterpolationMethod::LINEAR:{                 
-                            float t = (currentKeyFrameTime - sampler.timeStamps[i]) / (sampler.timeStamps[i + 1] - sampler.timeStamps[i]);
-                            switch (channel.pathType){
-                                case PathType::TRANSLATION:
-                                    joint.translation = glm::mix(sampler.TRSoutputValues[i], sampler.TRSoutputValues[i+1], t);
-                                    break;
-                                case PathType::ROTATION:
-                                    glm::quat q1;
-                                    q1.x = sampler.TRSoutputValues[i].x;
-                                    q1.y = sampler.TRSoutputValues[i].y;
-                                    q1.z = sampler.TRSoutputValues[i].z;
-                                    q1.w = sampler.TRSoutputValues[i].w;
-                                    glm::quat q2;
-                                    q2.x = sampler.TRSoutputValues[i+1].x;
-                                    q2.y = sampler.TRSoutputValues[i+1].y;
-                                    q2.z = sampler.TRSoutputValues[i+1].z;
-                                    q2.w = sampler.TRSoutputValues[i+1].w;
-                                    // Check quaternions for validity
-                                    joint.rotation = glm::normalize(glm::slerp(q1, q2, t));
-                                    break;
-                                case PathType::SCALE:
-                                    joint.scale = glm::mix(sampler.TRSoutputValues[i], sampler.TRSoutputValues[i+1], t);
-                                    break;
-                            }
-                            break;
-                        }
-                        case InterpolationMethod::STEP:{
-                            switch (channel.pathType){
-                                case PathType::TRANSLATION:{
-                                    joint.translation = glm::vec3(sampler.TRSoutputValues[i]);
-                                    break;
-                                }
-                                case PathType::ROTATION:{
-                                    glm::quat q;
-                                    q.x = sampler.TRSoutputValues[i].x;
-                                    q.y = sampler.TRSoutputValues[i].y;
-                                    q.z = sampler.TRSoutputValues[i].z;
-                                    q.w = sampler.TRSoutputValues[i].w;
-
-                                    joint.rotation = q;
-                                    break;
-                                }
-                                case PathType::SCALE:{
-
-                                    joint.scale = glm::vec3(sampler.TRSoutputValues[i]);
-                                    break;
-                                }
-                                default:
-                                    LOGE("Unknown channel path type: %d", static_cast<int>(channel.pathType));
-                                    break;
-                            }
-                            break;
-                        }
-                        default:
-                            LOGE("Unknown interpolation method: %d", static_cast<int>(sampler.interpolationMethod));
-                            break;
-                            
-                    }
-                }
+        sampleTargets<PathType::TRANSLATION>(binding[PathType::TRANSLATION], skeleton, logMissingKeyframes);
+        sampleTargets<PathType::ROTATION>(binding[PathType::ROTATION], skeleton, logMissingKeyframes);
+        sampleTargets<PathType::SCALE>(binding[PathType::SCALE], skeleton, logMissingKeyframes);
+//        LOGI("Animation %s updated", name.c_str());
+    }
+    template<Animation::PathType PATH>
+    void Animation::sampleTargets(const std::vector<Binding::Target>& targets, Skeleton& skeleton, bool logMissingKeyframes){
+        const bool isRetargeted = !channelRemaps.empty();
+        for(const auto& target : targets){
+            const auto& sampler = samplers[target.sampler];
+            size_t i = findKeyframe(sampler, currentKeyFrameTime, channelCursors[target.channel]);
+            if(i == NO_KEYFRAME){
+                if(logMissingKeyframes)
+                    LOGE("No keyframe found for current time %f", currentKeyFrameTime);
+                continue;
+            }
+//            LOGI("Found keyframe interval %f to %f", sampler.keyTime(i), sampler.keyTime(i+1));
+            glm::vec4 start = sampler.keyValue(i);
+            glm::vec4 end = start;
+            float t = 0.0f;
+            bool isLinear = sampler.interpolationMethod == InterpolationMethod::LINEAR;
+            if(isLinear){
+                float startTime = sampler.keyTime(i);
+                float endTime = sampler.keyTime(i + 1);
+                //quantized times can collapse two keys onto the same frame
+                t = endTime > startTime ? (currentKeyFrameTime - startTime) / (endTime - startTime) : 0.0f;
+                end = sampler.keyValue(i + 1);
             }
-            if (!keyFrameFound) {
-                std::string timeStamps = "";
-                for (size_t i = 0; i < sampler.timeStamps.size(); i++) {
-                    timeStamps += std::to_string(sampler.timeStamps[i]) + " ";
+            auto& joint = skeleton.joints[target.joint];
+            if constexpr (PATH == PathType::ROTATION){
+                glm::quat rotation = isLinear ? glm::normalize(glm::slerp(toQuat(start), toQuat(end), t)) : toQuat(start);
+                joint.rotation = isRetargeted ? channelRemaps[target.channel].rotation * rotation : rotation;
+            }else{
+                glm::vec3 value = glm::vec3(isLinear ? glm::mix(start, end, t) : start);
+                if(isRetargeted){
+                    const auto& remap = channelRemaps[target.channel];
+                    value = value * remap.factor + remap.offset;
+                }
+                if constexpr (PATH == PathType::TRANSLATION){
+                    joint.translation = value;
+                }else{
+                    joint.scale = value;
                 }
-//                LOGE("No keyframe found for current time %f", currentKeyFrameTime);
-//                LOGI("Available keyframe times: %s", timeStamps.c_str());
-
             }
-
         }
-//        LOGI("Animation %s updated", name.c_str());
     }
-    void Animation::updatePose(Skeleton& skeleton){
-
-        if(isRepeat && (currentKeyFrameTime > lastKeyFrameTime)){
-            currentKeyFrameTime = firstKeyFrameTime;
+    Animation::Binding Animation::bind(const Skeleton& skeleton) const{
+        Binding result = bind(skeleton.nodeJointMap, skeleton.joints.size(), skeleton.name);
+        result.skeleton = &skeleton;
+        return result;
+    }
+    Animation::Binding Animation::bind(const SkeletonDefinition& definition) const{
+        Binding result = bind(definition.nodeJointMap, definition.getJointCount(), definition.name);
+        result.definition = &definition;
+        return result;
+    }
+    const Animation::Binding& Animation::getBinding(const SkeletonDefinition& definition){
+        if(definitionBinding.definition != &definition || definitionBinding.channelCount != channels.size()){
+            definitionBinding = bind(definition);
+        }
+        return definitionBinding;
+    }
+    Animation::Binding Animation::bind(const std::map<int, int>& nodeJointMap, size_t jointCount, const std::string& skeletonName) const{
+        Binding result;
+        result.channelCount = channels.size();
+        result.jointCount = jointCount;
+        for(size_t i = 0; i < channels.size(); i++){
+            const auto& channel = channels[i];
+            auto node = nodeJointMap.find(channel.node);
+            bool hasSampler = channel.samplerIndex >= 0 && static_cast<size_t>(channel.samplerIndex) < samplers.size();
+            if(node == nodeJointMap.end() || node->second < 0 ||
+               static_cast<size_t>(node->second) >= jointCount || !hasSampler){
+                result.unboundChannels.push_back(static_cast<uint32_t>(i));
+                continue;
+            }
+            Binding::Target target{static_cast<uint32_t>(i), static_cast<uint32_t>(channel.samplerIndex), node->second};
+            result.targets[static_cast<int>(channel.pathType)].push_back(target);
+        }
+        if(!result.unboundChannels.empty()){
+            LOGI("Animation %s: %zu of %zu channels target nodes outside skeleton %s",
+                 name.c_str(), result.unboundChannels.size(), channels.size(), skeletonName.c_str());
+            for(uint32_t channel : result.unboundChannels){
+                LOGI("    channel %u -> node %d", channel, channels[channel].node);
+            }
+        }
+        return result;
+    }
+    const Animation::Binding& Animation::getBinding(const Skeleton& skeleton){
+        if(binding.skeleton != &skeleton || binding.channelCount != channels.size() ||
+           binding.jointCount != skeleton.joints.size()){
+            binding = bind(skeleton);
+        }
+        return binding;
+    }
+    void Animation::prepareState(SamplingState& state) const{
+        if(state.cursors.size() != channels.size()){
+            state.cursors.assign(channels.size(), 0);
         }
+    }
+    void Animation::sample(float time, const Binding& binding, Pose& pose, SamplingState& state) const{
+        if(pose.jointCount < binding.jointCount){
+            LOGE("Animation %s: pose has %zu joints, binding needs %zu", name.c_str(), pose.jointCount, binding.jointCount);
+            return;
+        }
+        prepareState(state);
+        for(int path = 0; path < 3; path++){
+            const auto& targets = binding.targets[path];
+            size_t count = targets.size();
+            if(count == 0){
+                continue;
+            }
+            bool isRotation = static_cast<PathType>(path) == PathType::ROTATION;
+            int components = isRotation ? 4 : 3;
+            size_t stride = Pose::strideFor(count);
+            //lanes: start value streams, end value streams, blend weight
+            size_t laneFloats = stride * (2 * components + 1);
+            if(state.lanes.size() < laneFloats){
+                state.lanes.resize(laneFloats);
+            }
+            if(state.joints.size() < count){
+                state.joints.resize(count);
+            }
+            float* start[4];
+            float* end[4];
+            for(int c = 0; c < components; c++){
+                start[c] = state.lanes.data() + c * stride;
+                end[c] = state.lanes.data() + (components + c) * stride;
+            }
+            float* weight = state.lanes.data() + 2 * components * stride;
 
-        // std::cout << "Current key frame time: " << currentKeyFrameTime << std::endl;
-        for(auto& channel: channels){
-            auto& sampler = samplers[channel.samplerIndex];
-            int jointIndex = skeleton.nodeJointMap[channel.node];
-            auto& joint = skeleton.joints[jointIndex];
-
-            bool keyFrameFound = false;
-            for(size_t i = 0; i < sampler.timeStamps.size() - 1; i++){
-                if(currentKeyFrameTime>=sampler.timeStamps[i] && currentKeyFrameTime <= sampler.timeStamps[i+1]){
-                    keyFrameFound = true;
-//                    LOGI("Found keyframe interval %f to %f", sampler.timeStamps[i], sampler.timeStamps[i+1]);
-
-                    switch (sampler.interpolationMethod){
-                        case InterpolationMethod::LINEAR:{
-                            float t = (currentKeyFrameTime - sampler.timeStamps[i]) / (sampler.timeStamps[i + 1] - sampler.timeStamps[i]);
-                            switch (channel.pathType){
-                                case PathType::TRANSLATION:
-                                    joint.translation = glm::mix(sampler.TRSoutputValues[i], sampler.TRSoutputValues[i+1], t);
-                                    break;
-                                case PathType::ROTATION:
-                                    glm::quat q1;
-                                    q1.x = sampler.TRSoutputValues[i].x;
-                                    q1.y = sampler.TRSoutputValues[i].y;
-                                    q1.z = sampler.TRSoutputValues[i].z;
-                                    q1.w = sampler.TRSoutputValues[i].w;
-                                    glm::quat q2;
-                                    q2.x = sampler.TRSoutputValues[i+1].x;
-                                    q2.y = sampler.TRSoutputValues[i+1].y;
-                                    q2.z = sampler.TRSoutputValues[i+1].z;
-                                    q2.w = sampler.TRSoutputValues[i+1].w;
-                                    // Check quaternions for validity
-                                    joint.rotation = glm::normalize(glm::slerp(q1, q2, t));
-                                    break;
-                                case PathType::SCALE:
-                                    joint.scale = glm::mix(sampler.TRSoutputValues[i], sampler.TRSoutputValues[i+1], t);
-                                    break;
-                            }
-                            break;
-                        }
-                        case InterpolationMethod::STEP:{
-                            switch (channel.pathType){
-                                case PathType::TRANSLATION:{
-                                    joint.translation = glm::vec3(sampler.TRSoutputValues[i]);
-                                    break;
-                                }
-                                case PathType::ROTATION:{
-                                    glm::quat q;
-                                    q.x = sampler.TRSoutputValues[i].x;
-                                    q.y = sampler.TRSoutputValues[i].y;
-                                    q.z = sampler.TRSoutputValues[i].z;
-                                    q.w = sampler.TRSoutputValues[i].w;
-
-                                    joint.rotation = q;
-                                    break;
-                                }
-                                case PathType::SCALE:{
-
-                                    joint.scale = glm::vec3(sampler.TRSoutputValues[i]);
-                                    break;
-                                }
-                                default:
-                                    LOGE("Unknown channel path type: %d", static_cast<int>(channel.pathType));
-                                    break;
-                            }
-                            break;
+            //gather: one lane per target, padding lanes hold an identity so the kernels stay finite
+            glm::vec4 identity = isRotation ? glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) : glm::vec4(0.0f);
+            for(size_t lane = 0; lane < stride; lane++){
+                glm::vec4 a = identity;
+                glm::vec4 b = identity;
+                float t = 0.0f;
+                if(lane < count){
+                    const auto& target = targets[lane];
+                    const auto& sampler = samplers[target.sampler];
+                    size_t key = findKeyframe(sampler, time, state.cursors[target.channel]);
+                    //outside the sampler range the joint keeps its current pose value
+                    state.joints[lane] = key == NO_KEYFRAME ? -1 : target.joint;
+                    if(key != NO_KEYFRAME){
+                        a = sampler.keyValue(key);
+                        b = a;
+                        if(sampler.interpolationMethod == InterpolationMethod::LINEAR){
+                            b = sampler.keyValue(key + 1);
+                            float startTime = sampler.keyTime(key);
+                            float endTime = sampler.keyTime(key + 1);
+                            t = endTime > startTime ? (time - startTime) / (endTime - startTime) : 0.0f;
                         }
-                        default:
-                            LOGE("Unknown interpolation method: %d", static_cast<int>(sampler.interpolationMethod));
-                            break;
-
                     }
                 }
-            }
-            if (!keyFrameFound) {
-                std::string timeStamps = "";
-                for (size_t i = 0; i < sampler.timeStamps.size(); i++) {
-                    timeStamps += std::to_string(sampler.timeStamps[i]) + " ";
+                for(int c = 0; c < components; c++){
+                    start[c][lane] = a[c];
+                    end[c][lane] = b[c];
                 }
-                LOGE("No keyframe found for current time %f", currentKeyFrameTime);
-//                LOGI("Available keyframe times: %s", timeStamps.c_str());
+                weight[lane] = t;
+            }
+            //blend in place into the start lanes
+            if(isRotation){
+                poseKernels::slerp(start, end, weight, start, count);
+            }else{
+                poseKernels::lerp(start, end, weight, start, count);
+            }
 
+            //rest pose compensation for retargeted clips
+            if(!channelRemaps.empty()){
+                for(size_t lane = 0; lane < count; lane++){
+                    const auto& remap = channelRemaps[targets[lane].channel];
+                    if(isRotation){
+                        glm::quat q = remap.rotation * glm::quat(start[3][lane], start[0][lane], start[1][lane], start[2][lane]);
+                        start[0][lane] = q.x;
+                        start[1][lane] = q.y;
+                        start[2][lane] = q.z;
+                        start[3][lane] = q.w;
+                    }else{
+                        for(int c = 0; c < 3; c++){
+                            start[c][lane] = start[c][lane] * remap.factor[c] + remap.offset[c];
+                        }
+                    }
+                }
             }
 
+            //scatter into the pose streams
+            int firstStream = isRotation ? Pose::RX : (static_cast<PathType>(path) == PathType::TRANSLATION ? Pose::TX : Pose::SX);
+            for(size_t lane = 0; lane < count; lane++){
+                int joint = state.joints[lane];
+                if(joint < 0){
+                    continue;
+                }
+                for(int c = 0; c < components; c++){
+                    pose.stream(static_cast<Pose::Stream>(firstStream + c))[joint] = start[c][lane];
+                }
+            }
         }
-//        LOGI("Animation %s updated", name.c_str());
+    }
+    size_t Animation::findKeyframe(const Sampler& sampler, float time, size_t& cursor){
+        if(sampler.uniformRate > 0.0f){
+            //baked samplers: the interval index follows directly from the time
+            size_t numKeys = sampler.keyCount();
+            float offset = (time - sampler.keyTime(0)) * sampler.uniformRate;
+            if(numKeys < 2 || offset < 0.0f || offset > static_cast<float>(numKeys - 1)){
+                return NO_KEYFRAME;
+            }
+            cursor = std::min(static_cast<size_t>(offset), numKeys - 2);
+            return cursor;
+        }
+        if(sampler.compressed){
+            //search directly on the 16 bit frame indices instead of decoding the times
+            const auto& track = *sampler.compressed;
+            return findInterval(track.frameData(), track.keyCount(), track.toFrame(time), cursor);
+        }
+        const auto& timeStamps = sampler.floatTimes();
+        return findInterval(timeStamps.data(), timeStamps.size(), time, cursor);
     }
     void Animation::setProgress(float progress){
         progress =  std::clamp(progress, 0.0f, getDuration());
         // Calculate absolute time based on total duration
         currentKeyFrameTime = progress;
+        invalidateCursors();
+    }
+    void Animation::invalidateCursors(){
+        //an out of range cursor always fails the fast path in findKeyframe
+        channelCursors.assign(channels.size(), NO_KEYFRAME);
     }
     std::vector<float> Animation::getKeyframeTimes(){
         std::set<float> uniqueTimes;
         for (const ve::Animation::Sampler& sampler : samplers) {
             // 4. Iterate through the timeStamps vector in the current sampler
-            for (float time : sampler.timeStamps) {
+            for (size_t i = 0; i < sampler.keyCount(); i++) {
                 // 5. Insert each timestamp into the set.
                 //    Duplicates will be automatically ignored by the set.
-                uniqueTimes.insert(time);
+                uniqueTimes.insert(sampler.keyTime(i));
             }
         }
 
@@ -241,4 +364,369 @@ namespace ve{
         std::vector<float> keyframeTimesVec(uniqueTimes.begin(), uniqueTimes.end());
         return keyframeTimesVec;
     }
-}
\ No newline at end of file
+    glm::vec4 Animation::evaluate(const Sampler& sampler, PathType pathType, float time, size_t& cursor){
+        size_t numKeys = sampler.keyCount();
+        if(numKeys == 0){
+            return glm::vec4(0.0f);
+        }
+        if(time <= sampler.keyTime(0)){
+            return sampler.keyValue(0);
+        }
+        if(time >= sampler.keyTime(numKeys - 1)){
+            return sampler.keyValue(numKeys - 1);
+        }
+        size_t i = findKeyframe(sampler, time, cursor);
+        glm::vec4 start = sampler.keyValue(i);
+        if(sampler.interpolationMethod == InterpolationMethod::STEP){
+            return start;
+        }
+        glm::vec4 end = sampler.keyValue(i + 1);
+        float startTime = sampler.keyTime(i);
+        float endTime = sampler.keyTime(i + 1);
+        float t = endTime > startTime ? (time - startTime) / (endTime - startTime) : 0.0f;
+        if(pathType == PathType::ROTATION){
+            glm::quat q = glm::normalize(glm::slerp(toQuat(start), toQuat(end), t));
+            return glm::vec4(q.x, q.y, q.z, q.w);
+        }
+        return glm::mix(start, end, t);
+    }
+    Animation::BakeReport Animation::bake(float rate, float maxRotationError, float maxLinearError){
+        BakeReport report;
+        report.bytesBefore = getMemoryUsage();
+        if(rate <= 0.0f){
+            report.bytesAfter = report.bytesBefore;
+            return report;
+        }
+        //baking works on float keys
+        decompress();
+        std::vector<int> samplerChannel(samplers.size(), -1);
+        for(size_t i = 0; i < channels.size(); i++){
+            samplerChannel[channels[i].samplerIndex] = static_cast<int>(i);
+        }
+        for(size_t samplerIndex = 0; samplerIndex < samplers.size(); samplerIndex++){
+            auto& original = samplers[samplerIndex];
+            if(samplerChannel[samplerIndex] < 0 || original.uniformRate > 0.0f || original.timeStamps.size() < 2){
+                continue;
+            }
+            PathType pathType = channels[samplerChannel[samplerIndex]].pathType;
+            float startTime = original.timeStamps.front();
+            float endTime = original.timeStamps.back();
+            //the last baked key may lie past the end, it then holds the final value
+            size_t numKeys = static_cast<size_t>(std::ceil((endTime - startTime) * rate)) + 1;
+
+            //values only, the key times follow from the rate
+            Sampler baked;
+            baked.interpolationMethod = original.interpolationMethod;
+            baked.uniformRate = rate;
+            baked.uniformStart = startTime;
+            baked.TRSoutputValues.resize(numKeys);
+            size_t cursor = 0;
+            for(size_t key = 0; key < numKeys; key++){
+                baked.TRSoutputValues[key] = evaluate(original, pathType, baked.keyTime(key), cursor);
+            }
+
+            //max error check: authored keys plus the midpoints of both the authored and the baked intervals
+            std::vector<float> testTimes;
+            testTimes.reserve(original.timeStamps.size() * 2 + numKeys);
+            for(size_t key = 0; key < original.timeStamps.size(); key++){
+                testTimes.push_back(original.timeStamps[key]);
+                if(key + 1 < original.timeStamps.size())
+                    testTimes.push_back(0.5f * (original.timeStamps[key] + original.timeStamps[key + 1]));
+            }
+            for(size_t key = 0; key + 1 < numKeys; key++){
+                testTimes.push_back(std::min(0.5f * (baked.keyTime(key) + baked.keyTime(key + 1)), endTime));
+            }
+            float error = 0.0f;
+            size_t originalCursor = 0;
+            size_t bakedCursor = 0;
+            for(float time : testTimes){
+                glm::vec4 expected = evaluate(original, pathType, time, originalCursor);
+                glm::vec4 actual = evaluate(baked, pathType, time, bakedCursor);
+                error = std::max(error, keyError(pathType, expected, actual));
+            }
+
+            bool isRotation = pathType == PathType::ROTATION;
+            if(error > (isRotation ? maxRotationError : maxLinearError)){
+                report.rejectedSamplers++;
+                continue;
+            }
+            float& maxError = isRotation ? report.maxRotationError : report.maxLinearError;
+            maxError = std::max(maxError, error);
+            original = std::move(baked);
+            report.bakedSamplers++;
+        }
+        invalidateCursors();
+        report.bytesAfter = getMemoryUsage();
+        LOGI("Animation %s baked at %.0f Hz: %d samplers baked, %d kept (error too high), %zu -> %zu bytes, max error %f rad / %f units",
+             name.c_str(), rate, report.bakedSamplers, report.rejectedSamplers, report.bytesBefore, report.bytesAfter,
+             report.maxRotationError, report.maxLinearError);
+        return report;
+    }
+    Animation::ReductionReport Animation::reduceKeys(const Skeleton& skeleton, const ReductionSettings& settings){
+        ReductionReport report;
+        report.bytesBefore = getMemoryUsage();
+        //works on owned float keys
+        decompress();
+
+        //how far a joint reaches into its subtree: the rest pose length of its longest descendant chain
+        std::vector<float> reach(skeleton.joints.size(), -1.0f);
+        std::function<float(size_t)> reachOf = [&](size_t j){
+            if(reach[j] < 0.0f){
+                reach[j] = 0.0f;
+                for(int child : skeleton.joints[j].childrenIndices){
+                    if(child >= 0 && static_cast<size_t>(child) < reach.size())
+                        reach[j] = std::max(reach[j], reachOf(child) + glm::length(skeleton.joints[child].translation));
+                }
+            }
+            return reach[j];
+        };
+        for(size_t j = 0; j < reach.size(); j++)
+            reachOf(j);
+
+        //a sampler bound by several joints is reduced once, within the tightest of their tolerances
+        const Binding& bound = getBinding(skeleton);
+        std::vector<float> samplerTolerance(samplers.size(), -1.0f);
+        std::vector<int> samplerPath(samplers.size(), -1);
+        for(int path = 0; path < 3; path++){
+            PathType pathType = static_cast<PathType>(path);
+            for(const auto& target : bound.targets[path]){
+                //a rotation or scale error moves every descendant by up to error * reach
+                float tolerance = settings.maxDistanceError;
+                if(pathType == PathType::ROTATION){
+                    tolerance = reach[target.joint] > 0.0f ? std::min(settings.maxAngularError, settings.maxDistanceError / reach[target.joint])
+                                                           : settings.maxAngularError;
+                }else if(pathType == PathType::SCALE){
+                    tolerance = reach[target.joint] > 0.0f ? std::min(settings.maxScaleError, settings.maxDistanceError / reach[target.joint])
+                                                           : settings.maxScaleError;
+                }
+                float& tightest = samplerTolerance[target.sampler];
+                tightest = tightest < 0.0f ? tolerance : std::min(tightest, tolerance);
+                //errors of different paths do not compare, such a sampler keeps its keys
+                int& samplerPathType = samplerPath[target.sampler];
+                samplerPathType = samplerPathType < 0 || samplerPathType == path ? path : 3;
+            }
+        }
+        for(size_t samplerIndex = 0; samplerIndex < samplers.size(); samplerIndex++){
+            if(samplerPath[samplerIndex] < 0){
+                continue;
+            }
+            auto& sampler = samplers[samplerIndex];
+            size_t numKeys = sampler.timeStamps.size();
+            report.keysBefore += numKeys;
+            if(numKeys < 3 || sampler.uniformRate > 0.0f || samplerPath[samplerIndex] > 2){
+                report.keysAfter += numKeys;
+                continue;
+            }
+            PathType pathType = static_cast<PathType>(samplerPath[samplerIndex]);
+            float tolerance = samplerTolerance[samplerIndex];
+
+            const auto& times = sampler.timeStamps;
+            const auto& values = sampler.TRSoutputValues;
+            std::vector<size_t> kept{0};
+            size_t anchor = 0;
+            if(sampler.interpolationMethod == InterpolationMethod::STEP){
+                //a held key is redundant when it repeats the value being held
+                for(size_t i = 1; i + 1 < numKeys; i++){
+                    if(keyError(pathType, values[anchor], values[i]) > tolerance){
+                        kept.push_back(i);
+                        anchor = i;
+                    }
+                }
+            }else{
+                //greedy: extend each segment while the dropped keys stay within tolerance of the blend
+                size_t end = anchor + 2;
+                while(end < numKeys){
+                    bool fits = end - anchor <= settings.maxSegmentKeys;
+                    for(size_t k = anchor + 1; fits && k < end; k++){
+                        float t = (times[k] - times[anchor]) / (times[end] - times[anchor]);
+                        glm::vec4 blended;
+                        if(pathType == PathType::ROTATION){
+                            glm::quat q = glm::normalize(glm::slerp(toQuat(values[anchor]), toQuat(values[end]), t));
+                            blended = glm::vec4(q.x, q.y, q.z, q.w);
+                        }else{
+                            blended = glm::mix(values[anchor], values[end], t);
+                        }
+                        fits = keyError(pathType, values[k], blended) <= tolerance;
+                    }
+                    if(!fits){
+                        anchor = end - 1;
+                        kept.push_back(anchor);
+                    }
+                    end++;
+                }
+            }
+            kept.push_back(numKeys - 1);
+
+            std::vector<float> reducedTimes(kept.size());
+            std::vector<glm::vec4> reducedValues(kept.size());
+            for(size_t i = 0; i < kept.size(); i++){
+                reducedTimes[i] = times[kept[i]];
+                reducedValues[i] = values[kept[i]];
+            }
+            sampler.timeStamps = std::move(reducedTimes);
+            sampler.TRSoutputValues = std::move(reducedValues);
+            report.keysAfter += kept.size();
+        }
+        invalidateCursors();
+        report.bytesAfter = getMemoryUsage();
+        LOGI("Animation %s reduced: %zu -> %zu keys, %zu -> %zu bytes", name.c_str(),
+             report.keysBefore, report.keysAfter, report.bytesBefore, report.bytesAfter);
+        return report;
+    }
+    void Animation::compress(float frameRate){
+        size_t bytesBefore = getMemoryUsage();
+        std::vector<bool> isRotation(samplers.size(), false);
+        std::vector<bool> isReferenced(samplers.size(), false);
+        for(const auto& channel : channels){
+            isReferenced[channel.samplerIndex] = true;
+            isRotation[channel.samplerIndex] = channel.pathType == PathType::ROTATION;
+        }
+        float maxRotationError = 0.0f;
+        float maxLinearError = 0.0f;
+        float maxTimeError = 0.0f;
+        for(size_t i = 0; i < samplers.size(); i++){
+            auto& sampler = samplers[i];
+            if(!isReferenced[i] || sampler.compressed || sampler.keyCount() == 0){
+                continue;
+            }
+            auto encoding = isRotation[i] ? CompressedTrack::Encoding::SMALLEST_THREE_QUATERNION
+                                          : CompressedTrack::Encoding::RANGE_QUANTIZED_VEC3;
+            //baked samplers keep their rate so the uniform lookup stays exact (16 bit frames permitting)
+            float trackRate = sampler.isUniform() && sampler.keyCount() <= 65536 ? sampler.uniformRate : frameRate;
+            auto track = std::make_shared<const CompressedTrack>(sampler.keyTimes(), sampler.floatValues(), encoding, trackRate);
+            if(!track->hasDistinctFrames()){
+                //more keys than 16 bit frames can tell apart, quantizing would drop some of them
+                LOGE("Animation %s: sampler %zu has %zu keys that do not fit into 16 bit frames, keeping float keys",
+                     name.c_str(), i, sampler.keyCount());
+                continue;
+            }
+            sampler.compressed = std::move(track);
+            if(trackRate != sampler.uniformRate)
+                sampler.uniformRate = 0.0f;
+            std::vector<float>().swap(sampler.timeStamps);
+            std::vector<glm::vec4>().swap(sampler.TRSoutputValues);
+            sampler.shared.reset();
+
+            float& maxError = isRotation[i] ? maxRotationError : maxLinearError;
+            maxError = std::max(maxError, sampler.compressed->getValueError());
+            maxTimeError = std::max(maxTimeError, sampler.compressed->getTimeError());
+        }
+        invalidateCursors();
+        LOGI("Animation %s compressed: %zu -> %zu bytes, max error %f rad / %f units / %f s",
+             name.c_str(), bytesBefore, getMemoryUsage(), maxRotationError, maxLinearError, maxTimeError);
+    }
+    void Animation::decompress(){
+        for(auto& sampler : samplers){
+            if(sampler.compressed){
+                //uniform samplers keep deriving their times from the rate
+                if(sampler.isUniform())
+                    sampler.uniformStart = sampler.compressed->keyTime(0);
+                else
+                    sampler.timeStamps = sampler.compressed->decodeTimes();
+                sampler.TRSoutputValues = sampler.compressed->decodeValues();
+                sampler.compressed.reset();
+            }else if(sampler.shared){
+                sampler.timeStamps = sampler.shared->timeStamps;
+                sampler.TRSoutputValues = sampler.shared->values;
+            }
+            sampler.shared.reset();
+        }
+        //the keys are owned now, bake the rest pose compensation into them. A sampler may drive several
+        //channels (legal in glTF): it is compensated once, channels with another remap get their own copy
+        std::vector<int> bakedBy(samplers.size(), -1);
+        const size_t authoredSamplers = samplers.size();
+        std::vector<int> references(authoredSamplers, 0);
+        for(const auto& channel : channels){
+            if(channel.samplerIndex >= 0 && static_cast<size_t>(channel.samplerIndex) < authoredSamplers)
+                references[channel.samplerIndex]++;
+        }
+        //keys before compensation, kept only for samplers a later channel may need to copy
+        std::vector<std::vector<glm::vec4>> authoredValues(authoredSamplers);
+        for(size_t i = 0; i < channelRemaps.size() && i < channels.size(); i++){
+            auto& channel = channels[i];
+            if(channel.samplerIndex < 0 || static_cast<size_t>(channel.samplerIndex) >= authoredSamplers){
+                continue;
+            }
+            const auto& remap = channelRemaps[i];
+            int& owner = bakedBy[channel.samplerIndex];
+            if(owner >= 0){
+                const auto& baked = channelRemaps[owner];
+                if(channels[owner].pathType == channel.pathType && baked.rotation == remap.rotation &&
+                   baked.factor == remap.factor && baked.offset == remap.offset){
+                    continue;
+                }
+                Sampler copy = samplers[channel.samplerIndex];
+                copy.TRSoutputValues = authoredValues[channel.samplerIndex];
+                channel.samplerIndex = static_cast<int>(samplers.size());
+                samplers.push_back(std::move(copy));
+            }else{
+                owner = static_cast<int>(i);
+                if(references[channel.samplerIndex] > 1)
+                    authoredValues[channel.samplerIndex] = samplers[channel.samplerIndex].TRSoutputValues;
+            }
+            for(auto& value : samplers[channel.samplerIndex].TRSoutputValues){
+                if(channel.pathType == PathType::ROTATION){
+                    glm::quat q = glm::normalize(remap.rotation * toQuat(value));
+                    value = glm::vec4(q.x, q.y, q.z, q.w);
+                }else{
+                    value = glm::vec4(glm::vec3(value) * remap.factor + remap.offset, 0.0f);
+                }
+            }
+        }
+        channelRemaps.clear();
+        //channels may point at new samplers
+        unbind();
+        invalidateCursors();
+    }
+    std::vector<float> Animation::Sampler::keyTimes() const{
+        if(!isUniform() || compressed){
+            return compressed ? compressed->decodeTimes() : floatTimes();
+        }
+        std::vector<float> times(keyCount());
+        for(size_t i = 0; i < times.size(); i++)
+            times[i] = keyTime(i);
+        return times;
+    }
+    void Animation::Sampler::makeIrregular(){
+        if(!isUniform()){
+            return;
+        }
+        timeStamps = keyTimes();
+        if(shared){
+            TRSoutputValues = shared->values;
+            shared.reset();
+        }
+        uniformRate = 0.0f;
+    }
+    size_t Animation::Sampler::share(){
+        if(shared || compressed){
+            return 0;
+        }
+        size_t bytesSaved = 0;
+        shared = SamplerStore::global().intern(std::move(timeStamps), std::move(TRSoutputValues), bytesSaved);
+        timeStamps = {};
+        TRSoutputValues = {};
+        return bytesSaved;
+    }
+    bool Animation::isCompressed() const{
+        return std::any_of(samplers.begin(), samplers.end(), [](const Sampler& sampler){return sampler.compressed != nullptr;});
+    }
+    float Animation::getChannelError(size_t channelIndex) const{
+        const auto& sampler = samplers[channels[channelIndex].samplerIndex];
+        return sampler.compressed ? sampler.compressed->getValueError() : 0.0f;
+    }
+    size_t Animation::Sampler::byteSize() const{
+        size_t bytes = sizeof(Sampler) + timeStamps.capacity() * sizeof(float) + TRSoutputValues.capacity() * sizeof(glm::vec4);
+        if(shared){
+            bytes += shared->byteSize();
+        }
+        return compressed ? bytes + compressed->byteSize() : bytes;
+    }
+    size_t Animation::getMemoryUsage() const{
+        size_t bytes = sizeof(Animation) + channels.capacity() * sizeof(Channel) + channelRemaps.capacity() * sizeof(ChannelRemap);
+        for(const auto& sampler : samplers){
+            bytes += sampler.byteSize();
+        }
+        return bytes;
+    }
+}
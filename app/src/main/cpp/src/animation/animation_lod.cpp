@@ -0,0 +1,157 @@
+#include "animation_lod.hpp"
+#include "debug.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ve{
+    int AnimationLodPolicy::select(float screenSize, int currentLevel) const{
+        if(screenSize <= 0.0f && freezeOffscreen){
+            return FROZEN;
+        }
+        int levelCount = static_cast<int>(levels.size());
+        for(int i = 0; i < levelCount; i++){
+            float threshold = levels[i].minScreenSize;
+            //moving to a more detailed level than the current one needs a margin
+            if(currentLevel == FROZEN || i < currentLevel)
+                threshold *= 1.0f + hysteresis;
+            if(screenSize >= threshold)
+                return i;
+        }
+        return levelCount - 1;
+    }
+    const AnimationLodLevel* AnimationLodPolicy::get(int level) const{
+        if(level < 0 || level >= static_cast<int>(levels.size()))
+            return nullptr;
+        return &levels[level];
+    }
+
+    float computeScreenSize(const glm::vec3& center, float radius, const glm::mat4& view, const glm::mat4& projection){
+        //side planes of the frustum from the rows of the view projection matrix (Gribb/Hartmann)
+        glm::mat4 viewProjection = projection * view;
+        glm::vec4 position(center, 1.0f);
+        glm::vec4 rowX(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+        glm::vec4 rowY(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+        glm::vec4 rowW(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+        const glm::vec4 planes[4] = {rowW + rowX, rowW - rowX, rowW + rowY, rowW - rowY};
+        for(const auto& plane : planes){
+            float length = glm::length(glm::vec3(plane));
+            if(length > 0.0f && glm::dot(plane, position) < -radius * length)
+                return 0.0f;
+        }
+        float distance = -(view * position).z;
+        if(distance < -radius)
+            return 0.0f;
+        if(distance <= radius)
+            return 1.0f;
+        //projected radius in ndc is radius * P[1][1] / distance, ndc spans 2 so this is diameter / height
+        return std::min(1.0f, radius * std::abs(projection[1][1]) / distance);
+    }
+
+    bool AnimationLodState::update(float deltaTime, Animation& animation, float time, float advanced, const Skeleton& skeleton,
+                                   Pose& pose, const AnimationLodLevel* level){
+        return update(deltaTime, animation, time, advanced, animation.getBinding(skeleton), skeleton.lodMask,
+                      skeleton.lodMaskVersion, pose, level);
+    }
+    bool AnimationLodState::update(float deltaTime, Animation& animation, float time, float advanced, const SkeletonDefinition& definition,
+                                   Pose& pose, const AnimationLodLevel* level){
+        //the rig is immutable, so is its mask
+        return update(deltaTime, animation, time, advanced, animation.getBinding(definition), definition.lodMask, 0, pose, level);
+    }
+    bool AnimationLodState::update(float deltaTime, const Animation& animation, float time, float advanced, const Animation::Binding& source,
+                                   const std::vector<uint8_t>& lodMask, uint32_t lodMaskVersion, Pose& pose, const AnimationLodLevel* level){
+        //a seek, a wrap or a skipped update jumps like full rate playback does instead of blending across it
+        if(time != clipTime + advanced)
+            primed = false;
+        clipTime = time;
+        if(!level){
+            primed = false;
+            return false;
+        }
+        if(!animation.isRunning()){
+            return false;
+        }
+        if(deltaTime > 0.0f)
+            timeScale = advanced / deltaTime;
+
+        bool masked = level->skipMaskedJoints && !lodMask.empty();
+        if(!isBoundTo(animation, source) || masked != boundMasked || lodMaskVersion != boundMaskVersion){
+            rebind(animation, source, lodMask, lodMaskVersion, masked);
+            primed = false;
+        }
+        float levelInterval = level->updateRate > 0.0f ? 1.0f / level->updateRate : 0.0f;
+        if(levelInterval != interval){
+            interval = levelInterval;
+            primed = false;
+        }
+        if(interval <= 0.0f){
+            //full rate, joints that are not sampled (masked or without channels) keep the current pose
+            animation.sample(time, binding, pose, state);
+            primed = true;
+            return true;
+        }
+
+        if(!primed){
+            if(next.pose().jointCount != pose.jointCount){
+                previous.resize(pose.jointCount);
+                next.resize(pose.jointCount);
+                weights.assign(Pose::strideFor(pose.jointCount), 0.0f);
+            }
+            next.pose().copyFrom(pose);
+            animation.sample(time, binding, next.pose(), state);
+            previous.pose().copyFrom(next.pose());
+            animation.sample(lookAhead(animation, time + interval * timeScale), binding, next.pose(), state);
+            elapsed = 0.0f;
+            primed = true;
+        }else{
+            elapsed += deltaTime;
+            if(elapsed >= interval){
+                elapsed = std::fmod(elapsed, interval);
+                previous.pose().copyFrom(next.pose());
+                animation.sample(lookAhead(animation, time + (interval - elapsed) * timeScale), binding, next.pose(), state);
+            }
+        }
+
+        //blend previous -> next over the interval
+        std::fill(weights.begin(), weights.end(), elapsed / interval);
+        Pose& a = previous.pose();
+        Pose& b = next.pose();
+        Pose& out = pose;
+        size_t jointCount = out.jointCount;
+        const float* const translationA[3] = {a.stream(Pose::TX), a.stream(Pose::TY), a.stream(Pose::TZ)};
+        const float* const translationB[3] = {b.stream(Pose::TX), b.stream(Pose::TY), b.stream(Pose::TZ)};
+        float* const translationOut[3] = {out.stream(Pose::TX), out.stream(Pose::TY), out.stream(Pose::TZ)};
+        poseKernels::lerp(translationA, translationB, weights.data(), translationOut, jointCount);
+        const float* const rotationA[4] = {a.stream(Pose::RX), a.stream(Pose::RY), a.stream(Pose::RZ), a.stream(Pose::RW)};
+        const float* const rotationB[4] = {b.stream(Pose::RX), b.stream(Pose::RY), b.stream(Pose::RZ), b.stream(Pose::RW)};
+        float* const rotationOut[4] = {out.stream(Pose::RX), out.stream(Pose::RY), out.stream(Pose::RZ), out.stream(Pose::RW)};
+        poseKernels::slerp(rotationA, rotationB, weights.data(), rotationOut, jointCount);
+        const float* const scaleA[3] = {a.stream(Pose::SX), a.stream(Pose::SY), a.stream(Pose::SZ)};
+        const float* const scaleB[3] = {b.stream(Pose::SX), b.stream(Pose::SY), b.stream(Pose::SZ)};
+        float* const scaleOut[3] = {out.stream(Pose::SX), out.stream(Pose::SY), out.stream(Pose::SZ)};
+        poseKernels::lerp(scaleA, scaleB, weights.data(), scaleOut, jointCount);
+        return true;
+    }
+    bool AnimationLodState::isBoundTo(const Animation& animation, const Animation::Binding& source) const{
+        return &animation == boundAnimation && source.skeleton == binding.skeleton && source.definition == binding.definition &&
+               source.channelCount == binding.channelCount && source.jointCount == binding.jointCount;
+    }
+    void AnimationLodState::rebind(const Animation& animation, const Animation::Binding& source, const std::vector<uint8_t>& lodMask,
+                                   uint32_t lodMaskVersion, bool masked){
+        binding = source;
+        if(masked){
+            for(auto& targets : binding.targets){
+                targets.erase(std::remove_if(targets.begin(), targets.end(), [&](const Animation::Binding::Target& target){
+                    return lodMask[target.joint] != 0;
+                }), targets.end());
+            }
+        }
+        boundAnimation = &animation;
+        boundMasked = masked;
+        boundMaskVersion = lodMaskVersion;
+    }
+    float AnimationLodState::lookAhead(const Animation& animation, float time) const{
+        //an interval crossing the end of the clip ends on the last key, update re-primes once advance wraps
+        return std::min(time, animation.getLastKeyFrameTime());
+    }
+}
@@ -0,0 +1,62 @@
+#include "ccd.hpp"
+
+#include <chrono>
+
+namespace ve{
+    bool CCDSolver::init(const Skeleton& skeleton, int root, int effector){
+        if(!chain.init(skeleton, root, effector))
+            return false;
+        matrices.assign(chain.size(), glm::mat4(1.0f));
+        hasNodeMatrices = false;
+        for(int joint : chain.joints)
+            hasNodeMatrices = hasNodeMatrices || skeleton.joints[joint].jointWorldMatrix != glm::mat4(1.0f);
+        return true;
+    }
+
+    const IKSolveStats& CCDSolver::solve(Skeleton& skeleton, const glm::vec3& target, const CCDSettings& settings){
+        auto start = std::chrono::steady_clock::now();
+        stats = IKSolveStats{};
+        if(chain.empty())
+            return stats;
+        size_t count = chain.size();
+        const int* joints = chain.joints.data();
+        int rootParent = skeleton.joints[joints[0]].parentIndex;
+        parentMatrix = rootParent == NO_PARENT ? glm::mat4(1.0f) : skeleton.getModelMatrix(rootParent);
+        for(size_t i = 0; i < count; i++)
+            matrices[i] = skeleton.getModelMatrix(joints[i]);
+        const JointLimit* limits = settings.useLimits && skeleton.jointLimits.size() == skeleton.joints.size() ? skeleton.jointLimits.data() : nullptr;
+
+        auto effectorError = [&](){return glm::length(glm::vec3(matrices[count - 1][3]) - target);};
+        stats.error = effectorError();
+        while(stats.error > settings.tolerance && stats.iterations < settings.maxIterations){
+            for(size_t i = count - 1; i-- > 0 && stats.error > settings.tolerance;){
+                glm::vec3 pivot(matrices[i][3]);
+                glm::vec3 effector(matrices[count - 1][3]);
+                glm::quat delta = ikMath::rotationBetween(effector - pivot, target - pivot);
+                const JointLimit* limit = limits ? &limits[joints[i]] : nullptr;
+                if(limit && limit->damping < 1.0f)
+                    delta = ikMath::scaleRotation(delta, limit->damping);
+                //a model space delta on a joint with parent rotation P: local' = P^-1 * delta * P * local
+                glm::quat parent = ikMath::rotationOf(i == 0 ? parentMatrix : matrices[i - 1]);
+                auto& joint = skeleton.joints[joints[i]];
+                joint.rotation = glm::normalize(glm::conjugate(parent) * delta * parent * joint.rotation);
+                if(limit)
+                    limit->clamp(joint.rotation);
+                updateFrom(skeleton, i);
+                stats.error = effectorError();
+            }
+            stats.iterations++;
+        }
+        stats.converged = stats.error <= settings.tolerance;
+        skeleton.markDirty(joints[0]);
+        stats.nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        return stats;
+    }
+
+    void CCDSolver::updateFrom(Skeleton& skeleton, size_t first){
+        for(size_t i = first; i < chain.size(); i++){
+            glm::mat4 local = ikMath::animatedMatrix(skeleton.joints[chain.joints[i]], hasNodeMatrices);
+            matrices[i] = (i == 0 ? parentMatrix : matrices[i - 1]) * local;
+        }
+    }
+}
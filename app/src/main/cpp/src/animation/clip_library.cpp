@@ -0,0 +1,145 @@
+#include "clip_library.hpp"
+#include "debug.hpp"
+
+#include <unordered_map>
+
+namespace ve{
+    namespace{
+        //below this length a rest translation is treated as zero and not used for scaling
+        constexpr float MIN_BONE_LENGTH = 1e-5f;
+
+        Animation::ChannelRemap computeRemap(Animation::PathType pathType, const Joint& target,
+                                             const glm::vec3& restTranslation, const glm::quat& restRotation, const glm::vec3& restScale){
+            Animation::ChannelRemap remap;
+            switch(pathType){
+                case Animation::PathType::ROTATION:
+                    //apply the source rotation relative to its rest pose on top of the target rest pose
+                    remap.rotation = target.rotation * glm::inverse(restRotation);
+                    break;
+                case Animation::PathType::TRANSLATION:{
+                    //offsets from the rest pose are scaled by the bone length ratio
+                    float sourceLength = glm::length(restTranslation);
+                    float targetLength = glm::length(target.translation);
+                    float ratio = sourceLength > MIN_BONE_LENGTH ? targetLength / sourceLength : 1.0f;
+                    remap.factor = glm::vec3(ratio);
+                    remap.offset = target.translation - restTranslation * ratio;
+                    break;
+                }
+                case Animation::PathType::SCALE:
+                    for(int c = 0; c < 3; c++){
+                        remap.factor[c] = std::abs(restScale[c]) > MIN_BONE_LENGTH ? target.scale[c] / restScale[c] : 1.0f;
+                    }
+                    break;
+            }
+            return remap;
+        }
+    }
+
+    void ClipLibrary::add(const std::string& clipSet, const std::shared_ptr<Animation>& clip, const Skeleton& sourceSkeleton){
+        if(!clip){
+            return;
+        }
+        //the keys move into shared storage, so the caller's clip and every copy reference one set
+        for(auto& sampler : clip->samplers){
+            sampler.share();
+        }
+        Entry entry;
+        entry.sources.resize(clip->channels.size());
+        for(size_t i = 0; i < clip->channels.size(); i++){
+            auto node = sourceSkeleton.nodeJointMap.find(clip->channels[i].node);
+            if(node == sourceSkeleton.nodeJointMap.end() || node->second < 0 ||
+               static_cast<size_t>(node->second) >= sourceSkeleton.joints.size()){
+                continue;
+            }
+            const auto& joint = sourceSkeleton.joints[node->second];
+            auto& source = entry.sources[i];
+            source.jointName = joint.name;
+            source.restTranslation = joint.translation;
+            source.restRotation = joint.rotation;
+            source.restScale = joint.scale;
+        }
+        //the library keeps its own copy so playback state of the caller's clip never leaks into instances
+        auto reference = std::make_shared<Animation>(*clip);
+        reference->unbind();
+        entry.clip = std::move(reference);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        clips[{clipSet, clip->getName()}] = std::move(entry);
+    }
+
+    std::shared_ptr<Animation> ClipLibrary::instantiate(const std::string& clipSet, const std::string& name, const Skeleton& target, float minBoundRatio) const{
+        Entry entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = clips.find({clipSet, name});
+            if(it == clips.end()){
+                return nullptr;
+            }
+            entry = it->second;
+        }
+        std::unordered_map<std::string, int> jointsByName;
+        jointsByName.reserve(target.joints.size());
+        for(size_t i = 0; i < target.joints.size(); i++){
+            jointsByName.emplace(target.joints[i].name, static_cast<int>(i));
+        }
+        std::vector<int> jointNodes(target.joints.size(), -1);
+        for(const auto& [node, joint] : target.nodeJointMap){
+            if(joint >= 0 && static_cast<size_t>(joint) < jointNodes.size())
+                jointNodes[joint] = node;
+        }
+
+        //samplers are copied as shared pointers only, channels and remaps are rebuilt for the target
+        auto instance = std::make_shared<Animation>(*entry.clip);
+        instance->channels.clear();
+        instance->channelRemaps.clear();
+        size_t sourceChannels = 0;
+        for(size_t i = 0; i < entry.clip->channels.size(); i++){
+            const auto& source = entry.sources[i];
+            if(source.jointName.empty()){
+                continue;
+            }
+            sourceChannels++;
+            auto joint = jointsByName.find(source.jointName);
+            if(joint == jointsByName.end() || jointNodes[joint->second] < 0){
+                continue;
+            }
+            Animation::Channel channel = entry.clip->channels[i];
+            channel.node = jointNodes[joint->second];
+            instance->channels.push_back(channel);
+            instance->channelRemaps.push_back(computeRemap(channel.pathType, target.joints[joint->second],
+                                                           source.restTranslation, source.restRotation, source.restScale));
+        }
+        size_t boundChannels = instance->channels.size();
+        if(sourceChannels == 0 || static_cast<float>(boundChannels) < minBoundRatio * static_cast<float>(sourceChannels)){
+            LOGI("Clip %s: only %zu of %zu channels match skeleton %s by joint name, not shared",
+                 name.c_str(), boundChannels, sourceChannels, target.name.c_str());
+            return nullptr;
+        }
+        LOGI("Clip %s shared with skeleton %s: %zu of %zu channels bound", name.c_str(), target.name.c_str(), boundChannels, sourceChannels);
+        return instance;
+    }
+
+    bool ClipLibrary::contains(const std::string& clipSet, const std::string& name) const{
+        std::lock_guard<std::mutex> lock(mutex);
+        return clips.find({clipSet, name}) != clips.end();
+    }
+
+    void ClipLibrary::clear(){
+        std::lock_guard<std::mutex> lock(mutex);
+        clips.clear();
+    }
+
+    size_t ClipLibrary::getClipCount() const{
+        std::lock_guard<std::mutex> lock(mutex);
+        return clips.size();
+    }
+
+    size_t ClipLibrary::getMemoryUsage() const{
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t bytes = 0;
+        for(const auto& [key, entry] : clips){
+            bytes += entry.clip->getMemoryUsage() + entry.sources.capacity() * sizeof(ChannelSource);
+        }
+        return bytes;
+    }
+}
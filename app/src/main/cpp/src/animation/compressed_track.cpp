@@ -0,0 +1,187 @@
+#include "compressed_track.hpp"
+#include "debug.hpp"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace ve{
+    namespace{
+        constexpr float MAX_FRAME = 65535.0f;
+        constexpr float MAX_QUANTIZED_15 = 32767.0f;
+        constexpr float MAX_QUANTIZED_16 = 65535.0f;
+        //the three smallest components of a unit quaternion lie within +-1/sqrt(2)
+        constexpr float SMALLEST_THREE_RANGE = 0.70710678f;
+    }
+
+    CompressedTrack::CompressedTrack(const std::vector<float>& timeStamps, const std::vector<glm::vec4>& sourceValues,
+                                     Encoding encoding, float frameRate): encoding(encoding){
+        size_t numKeys = std::min(timeStamps.size(), sourceValues.size());
+        if(numKeys == 0){
+            return;
+        }
+        quantizeTimes(std::vector<float>(timeStamps.begin(), timeStamps.begin() + numKeys), frameRate);
+
+        if(encoding == Encoding::RANGE_QUANTIZED_VEC3){
+            glm::vec3 minValue(sourceValues[0]);
+            glm::vec3 maxValue(sourceValues[0]);
+            for(size_t i = 1; i < numKeys; i++){
+                minValue = glm::min(minValue, glm::vec3(sourceValues[i]));
+                maxValue = glm::max(maxValue, glm::vec3(sourceValues[i]));
+            }
+            rangeMin = minValue;
+            rangeExtent = maxValue - minValue;
+        }
+
+        values.resize(numKeys * VALUES_PER_KEY);
+        for(size_t i = 0; i < numKeys; i++){
+            uint16_t* out = &values[i * VALUES_PER_KEY];
+            if(encoding == Encoding::SMALLEST_THREE_QUATERNION){
+                encodeQuaternion(sourceValues[i], out);
+            }else{
+                encodeRange(sourceValues[i], out);
+            }
+        }
+
+        //measure the error bound from the decoded keys rather than trusting the theoretical step size
+        for(size_t i = 0; i < numKeys; i++){
+            glm::vec4 decoded = keyValue(i);
+            if(encoding == Encoding::SMALLEST_THREE_QUATERNION){
+                glm::vec4 original = glm::normalize(sourceValues[i]);
+                if(glm::dot(original, decoded) < 0.0f){
+                    decoded = -decoded;
+                }
+                //rotation angle from the chord length, acos of the dot product is too coarse in float
+                float chord = glm::length(original - decoded);
+                valueError = std::max(valueError, 4.0f * std::asin(std::min(1.0f, chord * 0.5f)));
+            }else{
+                glm::vec3 difference = glm::abs(glm::vec3(sourceValues[i]) - glm::vec3(decoded));
+                valueError = std::max(valueError, std::max(difference.x, std::max(difference.y, difference.z)));
+            }
+        }
+    }
+
+    void CompressedTrack::quantizeTimes(const std::vector<float>& timeStamps, float frameRate){
+        startTime = timeStamps.front();
+        endTime = timeStamps.back();
+        float duration = endTime - startTime;
+        //a fixed frame rate is exact for clips baked at that rate, but must still fit into 16 bits
+        //(one frame of headroom so the rounded up last key does too)
+        float minStep = duration > 0.0f ? duration / (MAX_FRAME - 1.0f) : 1.0f;
+        timeStep = frameRate > 0.0f ? std::max(1.0f / frameRate, minStep) : minStep;
+
+        frames.resize(timeStamps.size());
+        for(size_t attempt = 0; attempt < 2; attempt++){
+            inverseTimeStep = 1.0f / timeStep;
+            bool collision = false;
+            for(size_t i = 0; i < timeStamps.size(); i++){
+                float frame = (timeStamps[i] - startTime) * inverseTimeStep;
+                //the last key rounds up so the frames cover the clip up to its true end, an off grid key
+                //rounded down would leave the final fraction of a frame outside every interval
+                frame = i + 1 < timeStamps.size() ? std::round(frame) : std::ceil(frame - 1e-3f);
+                frames[i] = static_cast<uint16_t>(std::clamp(frame, 0.0f, MAX_FRAME));
+                collision |= (i > 0 && frames[i] <= frames[i - 1]);
+            }
+            distinctFrames = !collision;
+            //keys closer than one frame would collapse, retry at the finest resolution
+            if(!collision || timeStep == minStep){
+                break;
+            }
+            LOGI("Compressed track: keys closer than %f s, falling back to %f s frames", timeStep, minStep);
+            timeStep = minStep;
+        }
+        lastFrame = static_cast<float>(frames.back());
+
+        timeError = 0.0f;
+        for(size_t i = 0; i < timeStamps.size(); i++){
+            timeError = std::max(timeError, std::abs(keyTime(i) - timeStamps[i]));
+        }
+    }
+
+    glm::vec4 CompressedTrack::keyValue(size_t i) const{
+        const uint16_t* in = &values[i * VALUES_PER_KEY];
+        if(encoding == Encoding::SMALLEST_THREE_QUATERNION){
+            return decodeQuaternion(in);
+        }
+        return decodeRange(in);
+    }
+
+    void CompressedTrack::encodeQuaternion(const glm::vec4& value, uint16_t* out) const{
+        glm::vec4 q = glm::normalize(value);
+        int largest = 0;
+        for(int c = 1; c < 4; c++){
+            if(std::abs(q[c]) > std::abs(q[largest])){
+                largest = c;
+            }
+        }
+        //q and -q are the same rotation, keep the dropped component positive
+        if(q[largest] < 0.0f){
+            q = -q;
+        }
+        uint64_t packed = static_cast<uint64_t>(largest);
+        for(int c = 0; c < 4; c++){
+            if(c == largest){
+                continue;
+            }
+            float normalized = std::clamp(q[c] / SMALLEST_THREE_RANGE * 0.5f + 0.5f, 0.0f, 1.0f);
+            packed = (packed << 15) | static_cast<uint64_t>(std::lround(normalized * MAX_QUANTIZED_15));
+        }
+        out[0] = static_cast<uint16_t>(packed >> 32);
+        out[1] = static_cast<uint16_t>(packed >> 16);
+        out[2] = static_cast<uint16_t>(packed);
+    }
+
+    glm::vec4 CompressedTrack::decodeQuaternion(const uint16_t* in) const{
+        uint64_t packed = (static_cast<uint64_t>(in[0]) << 32) | (static_cast<uint64_t>(in[1]) << 16) | in[2];
+        int largest = static_cast<int>((packed >> 45) & 0x3);
+        glm::vec4 q(0.0f);
+        float sumSquares = 0.0f;
+        int shift = 30;
+        for(int c = 0; c < 4; c++){
+            if(c == largest){
+                continue;
+            }
+            float normalized = static_cast<float>((packed >> shift) & 0x7FFF) / MAX_QUANTIZED_15;
+            q[c] = (normalized * 2.0f - 1.0f) * SMALLEST_THREE_RANGE;
+            sumSquares += q[c] * q[c];
+            shift -= 15;
+        }
+        q[largest] = std::sqrt(std::max(0.0f, 1.0f - sumSquares));
+        return q;
+    }
+
+    void CompressedTrack::encodeRange(const glm::vec4& value, uint16_t* out) const{
+        for(int c = 0; c < 3; c++){
+            float normalized = rangeExtent[c] > 0.0f ? (value[c] - rangeMin[c]) / rangeExtent[c] : 0.0f;
+            out[c] = static_cast<uint16_t>(std::lround(std::clamp(normalized, 0.0f, 1.0f) * MAX_QUANTIZED_16));
+        }
+    }
+
+    glm::vec4 CompressedTrack::decodeRange(const uint16_t* in) const{
+        return glm::vec4(rangeMin.x + static_cast<float>(in[0]) / MAX_QUANTIZED_16 * rangeExtent.x,
+                         rangeMin.y + static_cast<float>(in[1]) / MAX_QUANTIZED_16 * rangeExtent.y,
+                         rangeMin.z + static_cast<float>(in[2]) / MAX_QUANTIZED_16 * rangeExtent.z,
+                         0.0f);
+    }
+
+    size_t CompressedTrack::byteSize() const{
+        return sizeof(CompressedTrack) + frames.capacity() * sizeof(uint16_t) + values.capacity() * sizeof(uint16_t);
+    }
+
+    std::vector<float> CompressedTrack::decodeTimes() const{
+        std::vector<float> times(keyCount());
+        for(size_t i = 0; i < times.size(); i++){
+            times[i] = keyTime(i);
+        }
+        return times;
+    }
+
+    std::vector<glm::vec4> CompressedTrack::decodeValues() const{
+        std::vector<glm::vec4> decoded(keyCount());
+        for(size_t i = 0; i < decoded.size(); i++){
+            decoded[i] = keyValue(i);
+        }
+        return decoded;
+    }
+}
@@ -0,0 +1,420 @@
+#include "cpu_skinning.hpp"
+#include "simd_math.hpp"
+#include "vertex_packing.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace ve{
+    namespace{
+        void normalize3(float* v){
+            float length2 = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+            if(length2 > 0.0f){
+                float inverse = 1.0f / std::sqrt(length2);
+                v[0] *= inverse;
+                v[1] *= inverse;
+                v[2] *= inverse;
+            }
+        }
+
+        //bytes of the normal and tangent of one vertex
+        size_t directionSize(const SkinningLayout& layout){
+            return layout.packed ? sizeof(uint32_t) : 3 * sizeof(float);
+        }
+
+        void loadInfluences(const uint8_t* src, const SkinningLayout& layout, float weights[4], int32_t indices[4]){
+            if(!layout.packed){
+                std::memcpy(weights, src + layout.weights, 4 * sizeof(float));
+                std::memcpy(indices, src + layout.joints, 4 * sizeof(int32_t));
+                return;
+            }
+            uint16_t packedWeights[4];
+            uint32_t packedJoints;
+            std::memcpy(packedWeights, src + layout.weights, sizeof(packedWeights));
+            std::memcpy(&packedJoints, src + layout.joints, sizeof(packedJoints));
+            glm::vec4 w = vertexPacking::unpackWeights(packedWeights);
+            glm::ivec4 j = vertexPacking::unpackJoints(packedJoints);
+            for(int i = 0; i < 4; i++){
+                weights[i] = w[i];
+                indices[i] = j[i] == vertexPacking::INVALID_JOINT ? -1 : j[i];
+            }
+        }
+
+        void loadDirection(const uint8_t* src, bool packed, float direction[3]){
+            if(!packed){
+                std::memcpy(direction, src, 3 * sizeof(float));
+                return;
+            }
+            uint32_t octahedral;
+            std::memcpy(&octahedral, src, sizeof(octahedral));
+            glm::vec3 v = vertexPacking::unpackOctahedral(octahedral);
+            direction[0] = v.x;
+            direction[1] = v.y;
+            direction[2] = v.z;
+        }
+
+        void storeDirection(uint8_t* dst, bool packed, const float direction[3]){
+            if(!packed){
+                std::memcpy(dst, direction, 3 * sizeof(float));
+                return;
+            }
+            uint32_t octahedral = vertexPacking::packOctahedral(glm::vec3(direction[0], direction[1], direction[2]));
+            std::memcpy(dst, &octahedral, sizeof(octahedral));
+        }
+
+        void loadAttributes(const uint8_t* src, const SkinningLayout& layout, float position[3], float normal[3], float tangent[3]){
+            std::memcpy(position, src + layout.position, 3 * sizeof(float));
+            loadDirection(src + layout.normal, layout.packed, normal);
+            loadDirection(src + layout.tangent, layout.packed, tangent);
+        }
+
+        //3 floats each, a 4 wide store would run into the next attribute
+        void storeAttributes(uint8_t* dst, const SkinningLayout& layout, const float position[3], const float normal[3], const float tangent[3]){
+            std::memcpy(dst + layout.position, position, 3 * sizeof(float));
+            storeDirection(dst + layout.normal, layout.packed, normal);
+            storeDirection(dst + layout.tangent, layout.packed, tangent);
+        }
+
+        //bind pose, copied as is between layouts of the same encoding so packed directions are not encoded twice
+        void copyAttributes(const uint8_t* src, const SkinningLayout& sourceLayout, uint8_t* dst, const SkinningLayout& layout){
+            if(dst == src){
+                return;
+            }
+            if(sourceLayout.packed != layout.packed){
+                float position[3], normal[3], tangent[3];
+                loadAttributes(src, sourceLayout, position, normal, tangent);
+                storeAttributes(dst, layout, position, normal, tangent);
+                return;
+            }
+            std::memcpy(dst + layout.position, src + sourceLayout.position, 3 * sizeof(float));
+            std::memcpy(dst + layout.normal, src + sourceLayout.normal, directionSize(layout));
+            std::memcpy(dst + layout.tangent, src + sourceLayout.tangent, directionSize(layout));
+        }
+    }
+
+    SkinningVertex SkinningVertex::of(const PackedVertex& packed){
+        SkinningVertex skinning;
+        skinning.position = packed.position;
+        skinning.normal = vertexPacking::unpackOctahedral(packed.normal);
+        skinning.tangent = vertexPacking::unpackOctahedral(packed.tangent);
+        glm::ivec4 joints = vertexPacking::unpackJoints(packed.jointIndices);
+        for(int i = 0; i < 4; i++)
+            skinning.jointIndices[i] = joints[i] == vertexPacking::INVALID_JOINT ? -1 : joints[i];
+        skinning.jointWeights = vertexPacking::unpackWeights(packed.jointWeights);
+        return skinning;
+    }
+
+    CpuSkinning::CpuSkinning(int workerCount){
+        if(workerCount < 0){
+            workerCount = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 0);
+        }
+        workers.reserve(workerCount);
+        for(int i = 0; i < workerCount; i++){
+            workers.emplace_back(&CpuSkinning::workerLoop, this);
+        }
+    }
+
+    CpuSkinning::~CpuSkinning(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for(auto& worker : workers){
+            worker.join();
+        }
+    }
+
+    void CpuSkinning::skinRange(const void* source, const SkinningLayout& sourceLayout, void* destination, size_t first, size_t last,
+                                const SkinningLayout& layout, const glm::mat4* joints, size_t jointCount){
+        using simd::float4;
+        const auto* in = static_cast<const uint8_t*>(source);
+        auto* out = static_cast<uint8_t*>(destination);
+        for(size_t vertex = first; vertex < last; vertex++){
+            const uint8_t* src = in + vertex * sourceLayout.stride;
+            uint8_t* dst = out + vertex * layout.stride;
+            float weights[4];
+            int32_t indices[4];
+            loadInfluences(src, sourceLayout, weights, indices);
+
+            //blended matrix, one float4 per column
+            float4 c0 = simd::splat(0.0f), c1 = c0, c2 = c0, c3 = c0;
+            float totalWeight = 0.0f;
+            for(int i = 0; i < 4; i++){
+                if(weights[i] == 0.0f){
+                    continue;
+                }
+                if(indices[i] < 0 || static_cast<size_t>(indices[i]) >= jointCount){
+                    totalWeight = 0.0f;
+                    break;
+                }
+                const float* m = glm::value_ptr(joints[indices[i]]);
+                float4 w = simd::splat(weights[i]);
+                c0 = simd::madd(simd::load(m), w, c0);
+                c1 = simd::madd(simd::load(m + 4), w, c1);
+                c2 = simd::madd(simd::load(m + 8), w, c2);
+                c3 = simd::madd(simd::load(m + 12), w, c3);
+                totalWeight += weights[i];
+            }
+            if(totalWeight <= 0.0f){
+                copyAttributes(src, sourceLayout, dst, layout);
+                continue;
+            }
+            float position[3], normal[3], tangent[3];
+            loadAttributes(src, sourceLayout, position, normal, tangent);
+            float result[4];
+            float4 p = simd::madd(c0, simd::splat(position[0]), simd::madd(c1, simd::splat(position[1]), simd::madd(c2, simd::splat(position[2]), c3)));
+            simd::store(result, p * simd::splat(1.0f / totalWeight));
+            std::memcpy(position, result, sizeof(position));
+            //the weight sum cancels out in the normalization, octahedral encoding normalizes on its own
+            float4 n = simd::madd(c0, simd::splat(normal[0]), simd::madd(c1, simd::splat(normal[1]), c2 * simd::splat(normal[2])));
+            simd::store(result, n);
+            if(result[0] != 0.0f || result[1] != 0.0f || result[2] != 0.0f){
+                std::memcpy(normal, result, sizeof(normal));
+                if(!layout.packed)
+                    normalize3(normal);
+            }
+            float4 t = simd::madd(c0, simd::splat(tangent[0]), simd::madd(c1, simd::splat(tangent[1]), c2 * simd::splat(tangent[2])));
+            simd::store(result, t);
+            if(result[0] != 0.0f || result[1] != 0.0f || result[2] != 0.0f){
+                std::memcpy(tangent, result, sizeof(tangent));
+                if(!layout.packed)
+                    normalize3(tangent);
+            }
+            storeAttributes(dst, layout, position, normal, tangent);
+        }
+    }
+
+    void CpuSkinning::skinReference(const void* source, const SkinningLayout& sourceLayout, void* destination, size_t vertexCount,
+                                    const SkinningLayout& layout, const glm::mat4* joints, size_t jointCount){
+        const auto* in = static_cast<const uint8_t*>(source);
+        auto* out = static_cast<uint8_t*>(destination);
+        for(size_t vertex = 0; vertex < vertexCount; vertex++){
+            const uint8_t* src = in + vertex * sourceLayout.stride;
+            uint8_t* dst = out + vertex * layout.stride;
+            glm::vec3 position, normal, tangent;
+            glm::vec4 weights;
+            glm::ivec4 indices;
+            loadAttributes(src, sourceLayout, &position.x, &normal.x, &tangent.x);
+            loadInfluences(src, sourceLayout, &weights.x, &indices.x);
+            //per influence like the vertex shaders
+            glm::vec4 skinnedPosition(0.0f);
+            glm::vec3 skinnedNormal(0.0f);
+            glm::vec3 skinnedTangent(0.0f);
+            float totalWeight = 0.0f;
+            for(int i = 0; i < 4; i++){
+                if(weights[i] == 0.0f){
+                    continue;
+                }
+                if(indices[i] < 0 || static_cast<size_t>(indices[i]) >= jointCount){
+                    totalWeight = 0.0f;
+                    break;
+                }
+                const glm::mat4& joint = joints[indices[i]];
+                skinnedPosition += joint * glm::vec4(position, 1.0f) * weights[i];
+                skinnedNormal += glm::mat3(joint) * normal * weights[i];
+                skinnedTangent += glm::mat3(joint) * tangent * weights[i];
+                totalWeight += weights[i];
+            }
+            if(totalWeight <= 0.0f){
+                copyAttributes(src, sourceLayout, dst, layout);
+                continue;
+            }
+            position = glm::vec3(skinnedPosition) / totalWeight;
+            if(glm::dot(skinnedNormal, skinnedNormal) > 0.0f)
+                normal = glm::normalize(skinnedNormal);
+            if(glm::dot(skinnedTangent, skinnedTangent) > 0.0f)
+                tangent = glm::normalize(skinnedTangent);
+            storeAttributes(dst, layout, &position.x, &normal.x, &tangent.x);
+        }
+    }
+
+    void CpuSkinning::skinRange(const void* source, const SkinningLayout& sourceLayout, void* destination, size_t first, size_t last,
+                                const SkinningLayout& layout, const DualQuaternion* joints, size_t jointCount){
+        using simd::float4;
+        const auto* in = static_cast<const uint8_t*>(source);
+        auto* out = static_cast<uint8_t*>(destination);
+        for(size_t vertex = first; vertex < last; vertex++){
+            const uint8_t* src = in + vertex * sourceLayout.stride;
+            uint8_t* dst = out + vertex * layout.stride;
+            float weights[4];
+            int32_t indices[4];
+            loadInfluences(src, sourceLayout, weights, indices);
+
+            float4 real = simd::splat(0.0f), dual = real;
+            const float* pivot = nullptr;
+            float totalWeight = 0.0f;
+            for(int i = 0; i < 4; i++){
+                if(weights[i] == 0.0f){
+                    continue;
+                }
+                if(indices[i] < 0 || static_cast<size_t>(indices[i]) >= jointCount){
+                    totalWeight = 0.0f;
+                    break;
+                }
+                const float* r = &joints[indices[i]].real.x;
+                //q and -q are the same rotation, blend every entry on the first one's side
+                if(!pivot)
+                    pivot = r;
+                float side = r[0] * pivot[0] + r[1] * pivot[1] + r[2] * pivot[2] + r[3] * pivot[3];
+                float4 w = simd::splat(side < 0.0f ? -weights[i] : weights[i]);
+                real = simd::madd(simd::load(r), w, real);
+                dual = simd::madd(simd::load(&joints[indices[i]].dual.x), w, dual);
+                totalWeight += weights[i];
+            }
+            if(totalWeight <= 0.0f){
+                copyAttributes(src, sourceLayout, dst, layout);
+                continue;
+            }
+            DualQuaternion blend;
+            simd::store(&blend.real.x, real);
+            simd::store(&blend.dual.x, dual);
+            float length = glm::length(blend.real);
+            if(length > 0.0f){
+                blend.real /= length;
+                blend.dual /= length;
+            }
+            glm::vec3 position, normal, tangent;
+            loadAttributes(src, sourceLayout, &position.x, &normal.x, &tangent.x);
+            position = dualQuaternion::transformPoint(blend, position);
+            normal = dualQuaternion::rotate(blend, normal);
+            tangent = dualQuaternion::rotate(blend, tangent);
+            storeAttributes(dst, layout, &position.x, &normal.x, &tangent.x);
+        }
+    }
+
+    void CpuSkinning::skinReference(const void* source, const SkinningLayout& sourceLayout, void* destination, size_t vertexCount,
+                                    const SkinningLayout& layout, const DualQuaternion* joints, size_t jointCount){
+        const auto* in = static_cast<const uint8_t*>(source);
+        auto* out = static_cast<uint8_t*>(destination);
+        for(size_t vertex = 0; vertex < vertexCount; vertex++){
+            const uint8_t* src = in + vertex * sourceLayout.stride;
+            uint8_t* dst = out + vertex * layout.stride;
+            glm::vec3 position, normal, tangent;
+            glm::vec4 weights;
+            glm::ivec4 indices;
+            loadAttributes(src, sourceLayout, &position.x, &normal.x, &tangent.x);
+            loadInfluences(src, sourceLayout, &weights.x, &indices.x);
+            DualQuaternion blend;
+            blend.real = glm::vec4(0.0f);
+            bool first = true;
+            glm::vec4 pivot(0.0f);
+            float totalWeight = 0.0f;
+            for(int i = 0; i < 4; i++){
+                if(weights[i] == 0.0f){
+                    continue;
+                }
+                if(indices[i] < 0 || static_cast<size_t>(indices[i]) >= jointCount){
+                    totalWeight = 0.0f;
+                    break;
+                }
+                const DualQuaternion& joint = joints[indices[i]];
+                if(first){
+                    pivot = joint.real;
+                    first = false;
+                }
+                float w = glm::dot(joint.real, pivot) < 0.0f ? -weights[i] : weights[i];
+                blend.real += joint.real * w;
+                blend.dual += joint.dual * w;
+                totalWeight += weights[i];
+            }
+            float length = glm::length(blend.real);
+            if(totalWeight <= 0.0f || length <= 0.0f){
+                copyAttributes(src, sourceLayout, dst, layout);
+                continue;
+            }
+            blend.real /= length;
+            blend.dual /= length;
+            position = dualQuaternion::transformPoint(blend, position);
+            normal = dualQuaternion::rotate(blend, normal);
+            tangent = dualQuaternion::rotate(blend, tangent);
+            storeAttributes(dst, layout, &position.x, &normal.x, &tangent.x);
+        }
+    }
+
+    const SkinningStats& CpuSkinning::skin(const void* source, void* destination, size_t vertexCount, const SkinningLayout& layout,
+                                           const glm::mat4* joints, size_t jointCount){
+        return run({source, destination, vertexCount, layout, layout, joints, nullptr, jointCount});
+    }
+
+    const SkinningStats& CpuSkinning::skin(const void* source, void* destination, size_t vertexCount, const SkinningLayout& layout,
+                                           const DualQuaternion* joints, size_t jointCount){
+        return run({source, destination, vertexCount, layout, layout, nullptr, joints, jointCount});
+    }
+
+    const SkinningStats& CpuSkinning::skin(const void* source, const SkinningLayout& sourceLayout, void* destination, size_t vertexCount,
+                                           const SkinningLayout& layout, const glm::mat4* joints, size_t jointCount){
+        return run({source, destination, vertexCount, sourceLayout, layout, joints, nullptr, jointCount});
+    }
+
+    const SkinningStats& CpuSkinning::skin(const void* source, const SkinningLayout& sourceLayout, void* destination, size_t vertexCount,
+                                           const SkinningLayout& layout, const DualQuaternion* joints, size_t jointCount){
+        return run({source, destination, vertexCount, sourceLayout, layout, nullptr, joints, jointCount});
+    }
+
+    void CpuSkinning::skinBatch(const Job& job, size_t first, size_t last){
+        if(job.dualQuaternions){
+            skinRange(job.source, job.sourceLayout, job.destination, first, last, job.layout, job.dualQuaternions, job.jointCount);
+        }else{
+            skinRange(job.source, job.sourceLayout, job.destination, first, last, job.layout, job.matrices, job.jointCount);
+        }
+    }
+
+    const SkinningStats& CpuSkinning::run(const Job& newJob){
+        auto start = std::chrono::steady_clock::now();
+        size_t batches = (newJob.vertexCount + BATCH_SIZE - 1) / BATCH_SIZE;
+        stats.vertices = newJob.vertexCount;
+        stats.threads = 1;
+        if(workers.empty() || batches <= 1){
+            skinBatch(newJob, 0, newJob.vertexCount);
+        }else{
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job = newJob;
+                batchCount = batches;
+                nextBatch.store(0, std::memory_order_relaxed);
+                generation++;
+                active = workers.size();
+            }
+            wake.notify_all();
+            runBatches();
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this]{return active == 0;});
+            stats.threads = static_cast<unsigned>(std::min(batches, workers.size() + 1));
+        }
+        stats.nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        return stats;
+    }
+
+    void CpuSkinning::runBatches(){
+        for(size_t batch = nextBatch.fetch_add(1); batch < batchCount; batch = nextBatch.fetch_add(1)){
+            size_t first = batch * BATCH_SIZE;
+            skinBatch(job, first, std::min(first + BATCH_SIZE, job.vertexCount));
+        }
+    }
+
+    void CpuSkinning::workerLoop(){
+        uint64_t seen = 0;
+        while(true){
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]{return stopping || generation != seen;});
+                if(stopping){
+                    return;
+                }
+                seen = generation;
+            }
+            runBatches();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(--active == 0){
+                    done.notify_one();
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,233 @@
+#include "dls_ik.hpp"
+#include "debug.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace ve{
+    namespace{
+        //solves a * x = b in place for a symmetric positive definite n x n matrix, b becomes x
+        bool choleskySolve(float* a, float* b, size_t n){
+            for(size_t j = 0; j < n; j++){
+                float diagonal = a[j * n + j];
+                for(size_t k = 0; k < j; k++)
+                    diagonal -= a[j * n + k] * a[j * n + k];
+                if(diagonal <= 0.0f)
+                    return false;
+                diagonal = std::sqrt(diagonal);
+                a[j * n + j] = diagonal;
+                for(size_t i = j + 1; i < n; i++){
+                    float value = a[i * n + j];
+                    for(size_t k = 0; k < j; k++)
+                        value -= a[i * n + k] * a[j * n + k];
+                    a[i * n + j] = value / diagonal;
+                }
+            }
+            for(size_t i = 0; i < n; i++){
+                for(size_t k = 0; k < i; k++)
+                    b[i] -= a[i * n + k] * b[k];
+                b[i] /= a[i * n + i];
+            }
+            for(size_t i = n; i-- > 0;){
+                for(size_t k = i + 1; k < n; k++)
+                    b[i] -= a[k * n + i] * b[k];
+                b[i] /= a[i * n + i];
+            }
+            return true;
+        }
+    }
+
+    bool DLSSolver::init(const Skeleton& skeleton, const std::vector<IKEffector>& effectors, int root){
+        nodes.clear();
+        this->effectors.clear();
+        int jointCount = static_cast<int>(skeleton.joints.size());
+        if(effectors.empty() || effectors.size() > MAX_EFFECTORS){
+            LOGE("Skeleton %s: DLS IK needs 1 to %zu effectors, got %zu", skeleton.name.c_str(), MAX_EFFECTORS, effectors.size());
+            return false;
+        }
+        //joint -> node, the joint's depth orders the nodes parents first
+        std::vector<int> nodeOf(jointCount, -1);
+        std::vector<int> depth(jointCount, 0);
+        auto addNode = [&](int joint){
+            if(nodeOf[joint] == -1){
+                nodeOf[joint] = static_cast<int>(nodes.size());
+                Node node;
+                node.joint = joint;
+                nodes.push_back(node);
+            }
+            return nodeOf[joint];
+        };
+        for(size_t e = 0; e < effectors.size(); e++){
+            int effector = effectors[e].joint;
+            if(effector < 0 || effector >= jointCount || effector == root){
+                LOGE("Skeleton %s: invalid DLS IK effector %d", skeleton.name.c_str(), effector);
+                nodes.clear();
+                return false;
+            }
+            addNode(effector);
+            bool reachedRoot = root == NO_PARENT;
+            for(int joint = skeleton.joints[effector].parentIndex; joint != NO_PARENT && !reachedRoot; joint = skeleton.joints[joint].parentIndex){
+                nodes[addNode(joint)].effectorMask |= 1u << e;
+                reachedRoot = joint == root;
+            }
+            if(!reachedRoot){
+                LOGE("Skeleton %s: DLS IK effector %d is not below joint %d", skeleton.name.c_str(), effector, root);
+                nodes.clear();
+                return false;
+            }
+        }
+        for(auto& node : nodes){
+            for(int joint = skeleton.joints[node.joint].parentIndex; joint != NO_PARENT; joint = skeleton.joints[joint].parentIndex)
+                depth[node.joint]++;
+        }
+        std::stable_sort(nodes.begin(), nodes.end(), [&](const Node& a, const Node& b){return depth[a.joint] < depth[b.joint];});
+        hasNodeMatrices = false;
+        for(size_t i = 0; i < nodes.size(); i++){
+            nodeOf[nodes[i].joint] = static_cast<int>(i);
+            hasNodeMatrices = hasNodeMatrices || skeleton.joints[nodes[i].joint].jointWorldMatrix != glm::mat4(1.0f);
+        }
+        for(auto& node : nodes){
+            int parent = skeleton.joints[node.joint].parentIndex;
+            node.parent = parent == NO_PARENT ? -1 : nodeOf[parent];
+        }
+
+        this->effectors = effectors;
+        effectorNodes.resize(effectors.size());
+        for(size_t e = 0; e < effectors.size(); e++)
+            effectorNodes[e] = nodeOf[effectors[e].joint];
+        size_t size = effectors.size() * 3;
+        matrices.assign(nodes.size(), glm::mat4(1.0f));
+        effectorPositions.assign(effectors.size(), glm::vec3(0.0f));
+        system.assign(size * size, 0.0f);
+        solution.assign(size, 0.0f);
+        return true;
+    }
+
+    void DLSSolver::setJointWeight(int joint, float weight){
+        for(auto& node : nodes){
+            if(node.joint == joint)
+                node.weight = std::max(weight, 0.0f);
+        }
+    }
+
+    size_t DLSSolver::getActiveJointCount() const{
+        return static_cast<size_t>(std::count_if(nodes.begin(), nodes.end(), [](const Node& node){return node.effectorMask != 0;}));
+    }
+
+    size_t DLSSolver::getJacobianBlockCount() const{
+        size_t blocks = 0;
+        for(const auto& node : nodes){
+            for(uint32_t mask = node.effectorMask; mask; mask &= mask - 1)
+                blocks++;
+        }
+        return blocks;
+    }
+
+    void DLSSolver::updateMatrices(const Skeleton& skeleton){
+        for(size_t i = 0; i < nodes.size(); i++){
+            const auto& node = nodes[i];
+            const auto& joint = skeleton.joints[node.joint];
+            glm::mat4 local = ikMath::animatedMatrix(joint, hasNodeMatrices);
+            if(node.parent >= 0){
+                matrices[i] = matrices[node.parent] * local;
+            }else{
+                //parents outside the solve do not move, their model matrix is still current
+                matrices[i] = joint.parentIndex == NO_PARENT ? local : skeleton.getModelMatrix(joint.parentIndex) * local;
+            }
+        }
+    }
+
+    const IKSolveStats& DLSSolver::solve(Skeleton& skeleton, const glm::vec3* targets, const DLSSettings& settings){
+        auto start = std::chrono::steady_clock::now();
+        stats = IKSolveStats{};
+        if(nodes.empty())
+            return stats;
+        size_t effectorCount = effectors.size();
+        size_t size = effectorCount * 3;
+        const JointLimit* limits = settings.useLimits && skeleton.jointLimits.size() == skeleton.joints.size() ? skeleton.jointLimits.data() : nullptr;
+        for(size_t i = 0; i < nodes.size(); i++)
+            matrices[i] = skeleton.getModelMatrix(nodes[i].joint);
+
+        auto measure = [&](){
+            stats.error = 0.0f;
+            for(size_t e = 0; e < effectorCount; e++){
+                effectorPositions[e] = glm::vec3(matrices[effectorNodes[e]][3]);
+                stats.error = std::max(stats.error, glm::length(targets[e] - effectorPositions[e]));
+            }
+        };
+        measure();
+        while(stats.error > settings.tolerance && stats.iterations < settings.iterations){
+            //J W J^T + lambda^2 I, one 3x3 block per effector pair. For joint a moving effectors e1 and e2
+            //with arms r1, r2 the block gains w_a * ((r1 . r2) I - r2 r1^T)
+            std::fill(system.begin(), system.end(), 0.0f);
+            for(size_t i = 0; i < size; i++)
+                system[i * size + i] = settings.damping * settings.damping;
+            for(size_t n = 0; n < nodes.size(); n++){
+                const auto& node = nodes[n];
+                if(!node.effectorMask || node.weight <= 0.0f)
+                    continue;
+                glm::vec3 pivot(matrices[n][3]);
+                for(uint32_t mask1 = node.effectorMask; mask1; mask1 &= mask1 - 1){
+                    size_t e1 = static_cast<size_t>(__builtin_ctz(mask1));
+                    glm::vec3 r1 = (effectorPositions[e1] - pivot) * effectors[e1].weight;
+                    for(uint32_t mask2 = node.effectorMask; mask2; mask2 &= mask2 - 1){
+                        size_t e2 = static_cast<size_t>(__builtin_ctz(mask2));
+                        glm::vec3 r2 = (effectorPositions[e2] - pivot) * effectors[e2].weight;
+                        float r1r2 = glm::dot(r1, r2) * node.weight;
+                        for(int row = 0; row < 3; row++){
+                            float* line = system.data() + (e1 * 3 + row) * size + e2 * 3;
+                            for(int column = 0; column < 3; column++)
+                                line[column] += (row == column ? r1r2 : 0.0f) - node.weight * r2[row] * r1[column];
+                        }
+                    }
+                }
+            }
+            for(size_t e = 0; e < effectorCount; e++){
+                glm::vec3 error = (targets[e] - effectorPositions[e]) * effectors[e].weight;
+                solution[e * 3 + 0] = error.x;
+                solution[e * 3 + 1] = error.y;
+                solution[e * 3 + 2] = error.z;
+            }
+            if(!choleskySolve(system.data(), solution.data(), size)){
+                LOGE("Skeleton %s: DLS IK system is not positive definite", skeleton.name.c_str());
+                break;
+            }
+
+            //joint step w_a * sum over its effectors of r x y_e, a rotation about the joint in model space.
+            //All steps come from the same linearization, so parent rotations are read before any is applied
+            for(size_t n = 0; n < nodes.size(); n++){
+                const auto& node = nodes[n];
+                if(!node.effectorMask || node.weight <= 0.0f)
+                    continue;
+                glm::vec3 pivot(matrices[n][3]);
+                glm::vec3 step(0.0f);
+                for(uint32_t mask = node.effectorMask; mask; mask &= mask - 1){
+                    size_t e = static_cast<size_t>(__builtin_ctz(mask));
+                    glm::vec3 y(solution[e * 3 + 0], solution[e * 3 + 1], solution[e * 3 + 2]);
+                    step += glm::cross((effectorPositions[e] - pivot) * effectors[e].weight, y);
+                }
+                step *= node.weight;
+                float angle = glm::length(step);
+                if(angle < ikMath::EPSILON)
+                    continue;
+                glm::quat delta = glm::angleAxis(std::min(angle, settings.maxJointStep), step / angle);
+                auto& joint = skeleton.joints[node.joint];
+                glm::quat parent = node.parent >= 0 ? ikMath::rotationOf(matrices[node.parent]) : ikMath::globalRotation(skeleton, joint.parentIndex);
+                joint.rotation = glm::normalize(glm::conjugate(parent) * delta * parent * joint.rotation);
+                if(limits)
+                    limits[node.joint].clamp(joint.rotation);
+            }
+            updateMatrices(skeleton);
+            stats.iterations++;
+            measure();
+        }
+        stats.converged = stats.error <= settings.tolerance;
+        for(const auto& node : nodes){
+            if(node.effectorMask)
+                skeleton.markDirty(node.joint);
+        }
+        stats.nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        return stats;
+    }
+}
@@ -0,0 +1,49 @@
+#include "dual_quaternion.hpp"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace ve::dualQuaternion{
+    DualQuaternion fromMatrix(const glm::mat4& matrix){
+        //rotation of the normalized columns, the translation column as is
+        glm::mat3 rotation(matrix);
+        for(int c = 0; c < 3; c++){
+            float length = glm::length(rotation[c]);
+            if(length > 0.0f)
+                rotation[c] /= length;
+        }
+        glm::quat q = glm::normalize(glm::quat_cast(rotation));
+        glm::vec3 r(q.x, q.y, q.z);
+        glm::vec3 t(matrix[3]);
+        //dual = 0.5 * (t, 0) * q
+        DualQuaternion dq;
+        dq.real = glm::vec4(r, q.w);
+        dq.dual = 0.5f * glm::vec4(t * q.w + glm::cross(t, r), -glm::dot(t, r));
+        return dq;
+    }
+
+    float fromMatrices(const glm::mat4* matrices, size_t count, DualQuaternion* palette){
+        float scaleError = 0.0f;
+        for(size_t i = 0; i < count; i++){
+            for(int c = 0; c < 3; c++)
+                scaleError = std::max(scaleError, std::abs(glm::length(glm::vec3(matrices[i][c])) - 1.0f));
+            palette[i] = fromMatrix(matrices[i]);
+        }
+        return scaleError;
+    }
+
+    glm::vec3 transformPoint(const DualQuaternion& dq, const glm::vec3& point){
+        glm::vec3 r(dq.real);
+        glm::vec3 d(dq.dual);
+        //translation = 2 * dual * conjugate(real)
+        glm::vec3 translation = 2.0f * (dq.real.w * d - dq.dual.w * r + glm::cross(r, d));
+        return rotate(dq, point) + translation;
+    }
+
+    glm::vec3 rotate(const DualQuaternion& dq, const glm::vec3& vector){
+        glm::vec3 r(dq.real);
+        return vector + 2.0f * glm::cross(r, glm::cross(r, vector) + dq.real.w * vector);
+    }
+}
@@ -0,0 +1,71 @@
+#include "fabrik.hpp"
+
+#include <chrono>
+#include <cmath>
+
+namespace ve{
+    namespace{
+        //place `to` at length from `from` along their current direction
+        inline void pull(const glm::vec3& from, glm::vec3& to, float length){
+            glm::vec3 offset = to - from;
+            float distance = glm::length(offset);
+            to = distance > ikMath::EPSILON ? from + offset * (length / distance) : from + glm::vec3(0.0f, length, 0.0f);
+        }
+    }
+
+    bool FabrikSolver::init(const Skeleton& skeleton, int root, int effector){
+        hasSolution = false;
+        if(!chain.init(skeleton, root, effector))
+            return false;
+        solution.assign(chain.size(), glm::vec3(0.0f));
+        return true;
+    }
+
+    const IKSolveStats& FabrikSolver::solve(Skeleton& skeleton, const glm::vec3& target, const FabrikSettings& settings){
+        auto start = std::chrono::steady_clock::now();
+        stats = IKSolveStats{};
+        if(chain.empty())
+            return stats;
+        chain.readPositions(skeleton);
+        size_t count = chain.size();
+        glm::vec3* positions = chain.positions.data();
+        const float* lengths = chain.lengths.data();
+        const glm::vec3 root = positions[0];
+        if(settings.warmStart && hasSolution){
+            for(size_t i = 1; i < count; i++)
+                positions[i] = root + solution[i];
+        }
+
+        if(glm::length(target - root) >= chain.totalLength){
+            //out of reach: straighten towards the target
+            glm::vec3 direction = glm::normalize(target - root);
+            for(size_t i = 1; i < count; i++)
+                positions[i] = positions[i - 1] + direction * lengths[i - 1];
+            stats.iterations = 1;
+        }else{
+            stats.error = glm::length(positions[count - 1] - target);
+            while(stats.error > settings.tolerance && stats.iterations < settings.maxIterations){
+                //backward: effector onto the target, then towards the root
+                positions[count - 1] = target;
+                for(size_t i = count - 1; i-- > 0;)
+                    pull(positions[i + 1], positions[i], lengths[i]);
+                //forward: root back in place, then towards the effector
+                positions[0] = root;
+                for(size_t i = 1; i < count; i++)
+                    pull(positions[i - 1], positions[i], lengths[i - 1]);
+                stats.iterations++;
+                stats.error = glm::length(positions[count - 1] - target);
+            }
+        }
+        //an unreachable target stays unconverged, the effector ends short of it
+        stats.error = glm::length(positions[count - 1] - target);
+        stats.converged = stats.error <= settings.tolerance;
+
+        for(size_t i = 0; i < count; i++)
+            solution[i] = positions[i] - root;
+        hasSolution = true;
+        chain.writeRotations(skeleton);
+        stats.nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        return stats;
+    }
+}
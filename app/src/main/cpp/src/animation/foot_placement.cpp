@@ -0,0 +1,171 @@
+#include "foot_placement.hpp"
+#include "ik_chain.hpp"
+#include "debug.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+namespace ve{
+    namespace{
+        bool isFootName(const std::string& name){
+            std::string lower(name);
+            std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c){return static_cast<char>(std::tolower(c));});
+            return lower.find("paw") != std::string::npos || lower.find("foot") != std::string::npos;
+        }
+    }
+
+    bool FootPlacement::init(const Skeleton& skeleton, const std::vector<std::string>& feetJoints, int pelvis){
+        feet.clear();
+        //a rig without legs stays bound and does nothing instead of being searched again every frame
+        bound = &skeleton;
+        jointCount = skeleton.joints.size();
+        for(const auto& name : feetJoints){
+            if(feet.size() == MAX_FEET){
+                LOGE("Skeleton %s: foot placement supports %zu feet, %s ignored", skeleton.name.c_str(), MAX_FEET, name.c_str());
+                continue;
+            }
+            Foot foot;
+            foot.chain = twoBoneIK::findChain(skeleton, name);
+            if(!twoBoneIK::isValid(skeleton, foot.chain)){
+                LOGE("Skeleton %s: no leg ends in %s", skeleton.name.c_str(), name.c_str());
+                continue;
+            }
+            feet.push_back(foot);
+        }
+        if(feet.empty())
+            return false;
+        if(pelvis == -1){
+            //closest joint above every hip
+            pelvis = skeleton.joints[feet[0].chain.root].parentIndex;
+            for(const auto& foot : feet){
+                while(pelvis != NO_PARENT){
+                    bool above = false;
+                    for(int joint = foot.chain.root; joint != NO_PARENT && !above; joint = skeleton.joints[joint].parentIndex)
+                        above = joint == pelvis;
+                    if(above)
+                        break;
+                    pelvis = skeleton.joints[pelvis].parentIndex;
+                }
+            }
+        }
+        this->pelvis = pelvis;
+        chains.resize(feet.size());
+        goals.resize(feet.size());
+        frameRays.reserve(feet.size());
+        frameHits.resize(feet.size());
+        for(size_t i = 0; i < feet.size(); i++)
+            chains[i] = feet[i].chain;
+        reset();
+        LOGI("Skeleton %s: foot placement on %zu legs, pelvis %d", skeleton.name.c_str(), feet.size(), pelvis);
+        return true;
+    }
+
+    bool FootPlacement::init(const Skeleton& skeleton){
+        //outermost joint of each leg with a foot name, toes named paw_toe stay part of their paw
+        std::vector<std::string> names;
+        for(size_t i = 0; i < skeleton.joints.size(); i++){
+            if(!isFootName(skeleton.joints[i].name))
+                continue;
+            bool nested = false;
+            for(int joint = skeleton.joints[i].parentIndex; joint != NO_PARENT && !nested; joint = skeleton.joints[joint].parentIndex)
+                nested = isFootName(skeleton.joints[joint].name);
+            if(!nested)
+                names.push_back(skeleton.joints[i].name);
+        }
+        return init(skeleton, names);
+    }
+
+    void FootPlacement::reset(){
+        for(auto& foot : feet){
+            foot.offset = 0.0f;
+            foot.weight = 0.0f;
+        }
+        pelvisOffset = 0.0f;
+    }
+
+    void FootPlacement::appendRays(Skeleton& skeleton, const glm::mat4& objectMatrix, std::vector<Ray>& rays){
+        if(feet.empty())
+            return;
+        //a pelvis without a translation channel still holds last frame's offset
+        if(pelvis != NO_PARENT && skeleton.joints[pelvis].translation == writtenTranslation && writtenOffset != glm::vec3(0.0f)){
+            skeleton.joints[pelvis].translation -= writtenOffset;
+            skeleton.markDirty(pelvis);
+            skeleton.updateDirty();
+        }
+        writtenOffset = glm::vec3(0.0f);
+        glm::vec3 up = glm::normalize(settings.up);
+        glm::vec3 down = glm::vec3(objectMatrix * glm::vec4(-up * (settings.rayHeight + settings.rayDepth), 0.0f));
+        for(auto& foot : feet){
+            foot.animated = ikMath::jointPosition(skeleton, foot.chain.end);
+            Ray ray;
+            ray.origin = glm::vec3(objectMatrix * glm::vec4(foot.animated + up * settings.rayHeight, 1.0f));
+            //distances are fractions of the whole ray
+            ray.direction = down;
+            ray.maxDistance = 1.0f;
+            rays.push_back(ray);
+        }
+    }
+
+    size_t FootPlacement::apply(Skeleton& skeleton, const RayHit* hits, float deltaTime){
+        if(feet.empty())
+            return 0;
+        glm::vec3 up = glm::normalize(settings.up);
+        float blend = deltaTime > 0.0f ? 1.0f - std::exp(-settings.sharpness * deltaTime) : 1.0f;
+        size_t grounded = 0;
+        float lowest = 0.0f;
+        for(size_t i = 0; i < feet.size(); i++){
+            auto& foot = feet[i];
+            float offset = 0.0f;
+            float weight = 0.0f;
+            if(hits[i].hit()){
+                //ground height above the clip's ground plane, the paw keeps its animated lift on top of it
+                float ground = glm::dot(foot.animated, up) + settings.rayHeight - hits[i].distance * (settings.rayHeight + settings.rayDepth);
+                offset = std::min(std::max(ground, -settings.maxStepDown), settings.maxStepUp);
+                weight = 1.0f;
+                grounded++;
+            }
+            foot.offset += (offset - foot.offset) * blend;
+            foot.weight += (weight - foot.weight) * blend;
+            lowest = std::min(lowest, foot.offset);
+        }
+        pelvisOffset += ((settings.adjustPelvis ? lowest : 0.0f) - pelvisOffset) * blend;
+
+        if(pelvis != NO_PARENT && std::abs(pelvisOffset) > ikMath::EPSILON){
+            auto& joint = skeleton.joints[pelvis];
+            glm::mat3 parent = joint.parentIndex == NO_PARENT ? glm::mat3(1.0f) : glm::mat3(skeleton.getModelMatrix(joint.parentIndex));
+            writtenOffset = glm::inverse(parent) * (up * pelvisOffset);
+            joint.translation += writtenOffset;
+            writtenTranslation = joint.translation;
+            skeleton.markDirty(pelvis);
+            skeleton.updateDirty();
+        }
+
+        for(size_t i = 0; i < feet.size(); i++){
+            auto& foot = feet[i];
+            glm::vec3 root = ikMath::jointPosition(skeleton, foot.chain.root);
+            glm::vec3 mid = ikMath::jointPosition(skeleton, foot.chain.mid);
+            glm::vec3 end = ikMath::jointPosition(skeleton, foot.chain.end);
+            //keep the animated knee direction, a straight leg reuses the last one
+            glm::vec3 axis = end - root;
+            float length = glm::dot(axis, axis);
+            glm::vec3 bend = length > ikMath::EPSILON ? mid - (root + axis * (glm::dot(mid - root, axis) / length)) : glm::vec3(0.0f);
+            if(glm::length(bend) > 1e-4f)
+                foot.bend = glm::normalize(bend);
+            goals[i].target = foot.animated + up * foot.offset;
+            goals[i].pole = mid + foot.bend;
+            goals[i].weight = foot.weight;
+        }
+        twoBoneIK::solveBatch(skeleton, chains.data(), goals.data(), chains.size());
+        return grounded;
+    }
+
+    size_t FootPlacement::update(Skeleton& skeleton, const glm::mat4& objectMatrix, const CollisionBVH& collision, float deltaTime){
+        frameRays.clear();
+        appendRays(skeleton, objectMatrix, frameRays);
+        if(frameRays.empty())
+            return 0;
+        collision.raycast(frameRays.data(), frameHits.data(), frameRays.size());
+        return apply(skeleton, frameHits.data(), deltaTime);
+    }
+}
@@ -0,0 +1,86 @@
+#include "ik_chain.hpp"
+#include "debug.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ve{
+    bool IKChain::init(const Skeleton& skeleton, int root, int effector){
+        joints.clear();
+        int jointCount = static_cast<int>(skeleton.joints.size());
+        if(root < 0 || root >= jointCount || effector < 0 || effector >= jointCount || root == effector){
+            LOGE("Skeleton %s: invalid IK chain %d -> %d", skeleton.name.c_str(), root, effector);
+            return false;
+        }
+        for(int joint = effector; joint != NO_PARENT; joint = skeleton.joints[joint].parentIndex){
+            joints.push_back(joint);
+            if(joint == root)
+                break;
+        }
+        if(joints.back() != root){
+            LOGE("Skeleton %s: joint %d is not below %d", skeleton.name.c_str(), effector, root);
+            joints.clear();
+            return false;
+        }
+        std::reverse(joints.begin(), joints.end());
+        positions.assign(joints.size(), glm::vec3(0.0f));
+        lengths.assign(joints.size() - 1, 0.0f);
+        return true;
+    }
+
+    void IKChain::readPositions(const Skeleton& skeleton){
+        totalLength = 0.0f;
+        for(size_t i = 0; i < joints.size(); i++){
+            positions[i] = ikMath::jointPosition(skeleton, joints[i]);
+            if(i > 0){
+                lengths[i - 1] = glm::length(positions[i] - positions[i - 1]);
+                totalLength += lengths[i - 1];
+            }
+        }
+    }
+
+    void IKChain::writeRotations(Skeleton& skeleton) const{
+        //rotation already applied to the chain above joint i, in model space
+        glm::quat applied(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 solvedOrigin = positions[0];
+        glm::vec3 origin = ikMath::jointPosition(skeleton, joints[0]);
+        for(size_t i = 0; i + 1 < joints.size(); i++){
+            glm::vec3 next = ikMath::jointPosition(skeleton, joints[i + 1]);
+            glm::vec3 bone = applied * (next - origin);
+            glm::quat delta = ikMath::rotationBetween(bone, positions[i + 1] - solvedOrigin);
+            //a model space delta on a joint with parent rotation P: local' = P^-1 * delta * P * local
+            auto& joint = skeleton.joints[joints[i]];
+            glm::quat parent = applied * ikMath::globalRotation(skeleton, joint.parentIndex);
+            joint.rotation = glm::normalize(glm::conjugate(parent) * delta * parent * joint.rotation);
+            applied = glm::normalize(delta * applied);
+            origin = next;
+            solvedOrigin = positions[i + 1];
+        }
+        skeleton.markDirty(joints[0]);
+    }
+
+    namespace ikMath{
+        glm::quat rotationOf(const glm::mat4& matrix){
+            glm::mat3 rotation(matrix);
+            rotation[0] = glm::normalize(rotation[0]);
+            rotation[1] = glm::normalize(rotation[1]);
+            rotation[2] = glm::normalize(rotation[2]);
+            return glm::normalize(glm::quat_cast(rotation));
+        }
+        glm::quat globalRotation(const Skeleton& skeleton, int joint){
+            if(joint == NO_PARENT)
+                return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+            return rotationOf(skeleton.getModelMatrix(joint));
+        }
+        glm::quat rotationBetween(const glm::vec3& u, const glm::vec3& v){
+            glm::vec3 axis = glm::cross(u, v);
+            float w = std::sqrt(glm::dot(u, u) * glm::dot(v, v)) + glm::dot(u, v);
+            float length = std::sqrt(std::max(w * w + glm::dot(axis, axis), EPSILON * EPSILON));
+            return glm::quat(w / length, axis.x / length, axis.y / length, axis.z / length);
+        }
+        glm::quat scaleRotation(const glm::quat& rotation, float weight){
+            //nlerp from identity
+            return glm::normalize(glm::quat(1.0f - weight + rotation.w * weight, rotation.x * weight, rotation.y * weight, rotation.z * weight));
+        }
+    }
+}
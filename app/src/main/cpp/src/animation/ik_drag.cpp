@@ -0,0 +1,43 @@
+#include "ik_drag.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace ve{
+    bool IKDrag::begin(const Skeleton& skeleton, int effector, int chainLength){
+        end();
+        if(effector < 0 || effector >= static_cast<int>(skeleton.joints.size()))
+            return false;
+        int root = effector;
+        for(int i = 0; i < chainLength && skeleton.joints[root].parentIndex != NO_PARENT; i++)
+            root = skeleton.joints[root].parentIndex;
+        if(root == effector || !solver.init(skeleton, root, effector))
+            return false;
+        this->effector = effector;
+        this->root = root;
+        return true;
+    }
+
+    void IKDrag::end(){
+        effector = -1;
+        root = -1;
+        timing = IKDragTiming{};
+    }
+
+    const IKDragTiming& IKDrag::drag(Skeleton& skeleton, const glm::vec3& target){
+        if(!isActive())
+            return timing;
+        auto start = std::chrono::steady_clock::now();
+        //no reset between events: the last solution is the starting pose
+        const auto& stats = solver.solve(skeleton, target, settings);
+        skeleton.updateDirty();
+        timing.solveNanoseconds = stats.nanoseconds;
+        timing.totalNanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        timing.iterations = stats.iterations;
+        timing.error = stats.error;
+        timing.events++;
+        timing.maxTotalNanoseconds = std::max(timing.maxTotalNanoseconds, timing.totalNanoseconds);
+        timing.sumTotalNanoseconds += timing.totalNanoseconds;
+        return timing;
+    }
+}
@@ -0,0 +1,61 @@
+#include "joint_limits.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ve{
+    JointLimit JointLimit::create(const glm::quat& rest, const glm::vec3& twistAxis, float maxSwing, float maxTwist, float damping){
+        JointLimit limit;
+        limit.rest = glm::normalize(rest);
+        float axisLength = glm::length(twistAxis);
+        limit.twistAxis = axisLength > 0.0f ? twistAxis / axisLength : glm::vec3(0.0f, 1.0f, 0.0f);
+        limit.damping = std::clamp(damping, 0.0f, 1.0f);
+        //half angles past 90 degrees cover every rotation, store them as free
+        float halfSwing = std::clamp(maxSwing * 0.5f, 0.0f, glm::radians(90.0f));
+        float halfTwist = std::clamp(maxTwist * 0.5f, 0.0f, glm::radians(90.0f));
+        limit.cosHalfSwing = std::cos(halfSwing);
+        limit.sinHalfSwing = std::sin(halfSwing);
+        limit.cosHalfTwist = std::cos(halfTwist);
+        limit.sinHalfTwist = std::sin(halfTwist);
+        return limit;
+    }
+
+    bool JointLimit::clamp(glm::quat& rotation) const{
+        if(isFree())
+            return false;
+        glm::quat relative = glm::conjugate(rest) * rotation;
+        if(relative.w < 0.0f)
+            relative = -relative;
+        //swing-twist split: twist is the part around the axis, relative = swing * twist
+        glm::vec3 vector(relative.x, relative.y, relative.z);
+        float projection = glm::dot(vector, twistAxis);
+        glm::quat twist(relative.w, twistAxis.x * projection, twistAxis.y * projection, twistAxis.z * projection);
+        float twistLength2 = twist.w * twist.w + projection * projection;
+        if(twistLength2 < 1e-12f){
+            //half turn swing, no defined twist
+            twist = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        }else{
+            twist = twist * (1.0f / std::sqrt(twistLength2));
+        }
+        glm::quat swing = relative * glm::conjugate(twist);
+
+        bool clamped = false;
+        if(twist.w < cosHalfTwist){
+            float sign = projection < 0.0f ? -1.0f : 1.0f;
+            twist = glm::quat(cosHalfTwist, twistAxis.x * sign * sinHalfTwist, twistAxis.y * sign * sinHalfTwist, twistAxis.z * sign * sinHalfTwist);
+            clamped = true;
+        }
+        if(swing.w < cosHalfSwing){
+            glm::vec3 swingAxis(swing.x, swing.y, swing.z);
+            float swingLength = glm::length(swingAxis);
+            if(swingLength > 0.0f){
+                swingAxis *= sinHalfSwing / swingLength;
+                swing = glm::quat(cosHalfSwing, swingAxis.x, swingAxis.y, swingAxis.z);
+                clamped = true;
+            }
+        }
+        if(clamped)
+            rotation = glm::normalize(rest * swing * twist);
+        return clamped;
+    }
+}
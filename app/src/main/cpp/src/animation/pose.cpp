@@ -0,0 +1,157 @@
+#include "pose.hpp"
+#include "simd_math.hpp"
+
+#include <algorithm>
+
+namespace ve{
+    size_t Pose::strideFor(size_t jointCount){
+        return (jointCount + simd::WIDTH - 1) / simd::WIDTH * simd::WIDTH;
+    }
+
+    glm::vec3 Pose::getTranslation(size_t joint) const{
+        return {stream(TX)[joint], stream(TY)[joint], stream(TZ)[joint]};
+    }
+    glm::quat Pose::getRotation(size_t joint) const{
+        return glm::quat(stream(RW)[joint], stream(RX)[joint], stream(RY)[joint], stream(RZ)[joint]);
+    }
+    glm::vec3 Pose::getScale(size_t joint) const{
+        return {stream(SX)[joint], stream(SY)[joint], stream(SZ)[joint]};
+    }
+    void Pose::setTranslation(size_t joint, const glm::vec3& translation){
+        stream(TX)[joint] = translation.x;
+        stream(TY)[joint] = translation.y;
+        stream(TZ)[joint] = translation.z;
+    }
+    void Pose::setRotation(size_t joint, const glm::quat& rotation){
+        stream(RX)[joint] = rotation.x;
+        stream(RY)[joint] = rotation.y;
+        stream(RZ)[joint] = rotation.z;
+        stream(RW)[joint] = rotation.w;
+    }
+    void Pose::setScale(size_t joint, const glm::vec3& scale){
+        stream(SX)[joint] = scale.x;
+        stream(SY)[joint] = scale.y;
+        stream(SZ)[joint] = scale.z;
+    }
+    void Pose::setIdentity(){
+        std::fill_n(data, stride * RW, 0.0f);
+        std::fill_n(stream(RW), stride * (STREAM_COUNT - RW), 1.0f);
+    }
+    void Pose::copyFrom(const Pose& other){
+        size_t count = std::min(jointCount, other.jointCount);
+        for(int s = 0; s < STREAM_COUNT; s++){
+            std::copy_n(other.stream(static_cast<Stream>(s)), count, stream(static_cast<Stream>(s)));
+        }
+    }
+    void Pose::readFrom(const Skeleton& skeleton){
+        size_t count = std::min(jointCount, skeleton.joints.size());
+        for(size_t i = 0; i < count; i++){
+            const auto& joint = skeleton.joints[i];
+            setTranslation(i, joint.translation);
+            setRotation(i, joint.rotation);
+            setScale(i, joint.scale);
+        }
+    }
+    void Pose::writeTo(Skeleton& skeleton) const{
+        size_t count = std::min(jointCount, skeleton.joints.size());
+        for(size_t i = 0; i < count; i++){
+            auto& joint = skeleton.joints[i];
+            joint.translation = getTranslation(i);
+            joint.rotation = getRotation(i);
+            joint.scale = getScale(i);
+        }
+    }
+
+    PoseBuffer::PoseBuffer(size_t jointCount){
+        resize(jointCount);
+    }
+    void PoseBuffer::resize(size_t jointCount){
+        size_t stride = Pose::strideFor(jointCount);
+        storage.assign(stride * Pose::STREAM_COUNT, 0.0f);
+        view.data = storage.data();
+        view.jointCount = jointCount;
+        view.stride = stride;
+        //identity rotation and unit scale for the padding lanes as well
+        view.setIdentity();
+    }
+
+    PosePool::PosePool(size_t jointCount, size_t capacity)
+        : jointCount(jointCount), stride(Pose::strideFor(jointCount)), capacity(capacity),
+          storage(stride * Pose::STREAM_COUNT * capacity, 0.0f){}
+    Pose PosePool::acquire(){
+        size_t index = next.fetch_add(1, std::memory_order_relaxed);
+        if(index >= capacity){
+            return Pose{};
+        }
+        Pose pose;
+        pose.data = storage.data() + index * stride * Pose::STREAM_COUNT;
+        pose.jointCount = jointCount;
+        pose.stride = stride;
+        return pose;
+    }
+    void PosePool::reset(){
+        next.store(0, std::memory_order_relaxed);
+    }
+    size_t PosePool::getUsed() const{
+        return std::min(next.load(std::memory_order_relaxed), capacity);
+    }
+
+    namespace poseKernels{
+        void lerp(const float* const a[3], const float* const b[3], const float* t, float* const out[3], size_t count){
+            for(size_t i = 0; i < count; i += simd::WIDTH){
+                simd::float4 weight = simd::load(t + i);
+                for(int c = 0; c < 3; c++){
+                    simd::float4 start = simd::load(a[c] + i);
+                    simd::float4 end = simd::load(b[c] + i);
+                    simd::store(out[c] + i, simd::madd(end - start, weight, start));
+                }
+            }
+        }
+
+        namespace{
+            template<bool CORRECTED>
+            void blendQuaternions(const float* const a[4], const float* const b[4], const float* t, float* const out[4], size_t count){
+                using simd::float4;
+                for(size_t i = 0; i < count; i += simd::WIDTH){
+                    float4 ax = simd::load(a[0] + i), ay = simd::load(a[1] + i), az = simd::load(a[2] + i), aw = simd::load(a[3] + i);
+                    float4 bx = simd::load(b[0] + i), by = simd::load(b[1] + i), bz = simd::load(b[2] + i), bw = simd::load(b[3] + i);
+                    float4 weight = simd::load(t + i);
+
+                    //take the shorter arc like glm::slerp does
+                    float4 d = ax * bx + ay * by + az * bz + aw * bw;
+                    bx = simd::xorSign(bx, d);
+                    by = simd::xorSign(by, d);
+                    bz = simd::xorSign(bz, d);
+                    bw = simd::xorSign(bw, d);
+
+                    if(CORRECTED){
+                        //weight correction from "Approximating slerp" (A. Kapoulkine), error ~1e-4 rad
+                        d = simd::abs(d);
+                        float4 A = simd::madd(d, simd::madd(d, simd::madd(d, simd::splat(-1.43519f), simd::splat(3.55645f)), simd::splat(-3.2452f)), simd::splat(1.0904f));
+                        float4 B = simd::madd(d, simd::madd(d, simd::splat(0.215638f), simd::splat(-1.06021f)), simd::splat(0.848013f));
+                        float4 centered = weight - simd::splat(0.5f);
+                        float4 k = simd::madd(A, centered * centered, B);
+                        weight = simd::madd(weight * centered * (weight - simd::splat(1.0f)), k, weight);
+                    }
+
+                    float4 rx = simd::madd(bx - ax, weight, ax);
+                    float4 ry = simd::madd(by - ay, weight, ay);
+                    float4 rz = simd::madd(bz - az, weight, az);
+                    float4 rw = simd::madd(bw - aw, weight, aw);
+                    float4 inverseLength = simd::rsqrt(rx * rx + ry * ry + rz * rz + rw * rw);
+                    simd::store(out[0] + i, rx * inverseLength);
+                    simd::store(out[1] + i, ry * inverseLength);
+                    simd::store(out[2] + i, rz * inverseLength);
+                    simd::store(out[3] + i, rw * inverseLength);
+                }
+            }
+        }
+
+        void slerp(const float* const a[4], const float* const b[4], const float* t, float* const out[4], size_t count){
+            blendQuaternions<true>(a, b, t, out, count);
+        }
+        void nlerp(const float* const a[4], const float* const b[4], const float* t, float* const out[4], size_t count){
+            blendQuaternions<false>(a, b, t, out, count);
+        }
+    }
+}
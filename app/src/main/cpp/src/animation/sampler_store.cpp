@@ -0,0 +1,80 @@
+#include "sampler_store.hpp"
+
+#include <cstring>
+#include <iterator>
+
+namespace ve{
+    uint64_t hashBytes(const void* data, size_t size, uint64_t seed){
+        constexpr uint64_t FNV_PRIME = 1099511628211ull;
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        uint64_t h = seed;
+        for(size_t i = 0; i < size; i++){
+            h = (h ^ bytes[i]) * FNV_PRIME;
+        }
+        return h;
+    }
+
+    SamplerStore& SamplerStore::global(){
+        static SamplerStore store;
+        return store;
+    }
+
+    uint64_t SamplerStore::hash(const std::vector<float>& timeStamps, const std::vector<glm::vec4>& values){
+        size_t counts[2] = {timeStamps.size(), values.size()};
+        uint64_t h = hashBytes(counts, sizeof(counts));
+        h = hashBytes(timeStamps.data(), timeStamps.size() * sizeof(float), h);
+        return hashBytes(values.data(), values.size() * sizeof(glm::vec4), h);
+    }
+
+    bool SamplerStore::equals(const SharedKeys& keys, const std::vector<float>& timeStamps, const std::vector<glm::vec4>& values){
+        return keys.timeStamps.size() == timeStamps.size() && keys.values.size() == values.size() &&
+               std::memcmp(keys.timeStamps.data(), timeStamps.data(), timeStamps.size() * sizeof(float)) == 0 &&
+               std::memcmp(keys.values.data(), values.data(), values.size() * sizeof(glm::vec4)) == 0;
+    }
+
+    std::shared_ptr<const SharedKeys> SamplerStore::intern(std::vector<float> timeStamps, std::vector<glm::vec4> values, size_t& bytesSaved){
+        bytesSaved = 0;
+        uint64_t key = hash(timeStamps, values);
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.internCalls++;
+        auto range = entries.equal_range(key);
+        for(auto it = range.first; it != range.second;){
+            auto existing = it->second.lock();
+            if(!existing){
+                it = entries.erase(it);
+                continue;
+            }
+            if(equals(*existing, timeStamps, values)){
+                bytesSaved = timeStamps.size() * sizeof(float) + values.size() * sizeof(glm::vec4);
+                stats.hits++;
+                stats.bytesSaved += bytesSaved;
+                return existing;
+            }
+            ++it;
+        }
+        auto keys = std::make_shared<SharedKeys>();
+        keys->timeStamps = std::move(timeStamps);
+        keys->values = std::move(values);
+        entries.emplace(key, keys);
+        return keys;
+    }
+
+    void SamplerStore::purge(){
+        std::lock_guard<std::mutex> lock(mutex);
+        for(auto it = entries.begin(); it != entries.end();){
+            it = it->second.expired() ? entries.erase(it) : std::next(it);
+        }
+    }
+
+    SamplerStore::Stats SamplerStore::getStats(){
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats result = stats;
+        for(const auto& [key, entry] : entries){
+            if(auto keys = entry.lock()){
+                result.uniqueSamplers++;
+                result.uniqueBytes += keys->byteSize();
+            }
+        }
+        return result;
+    }
+}
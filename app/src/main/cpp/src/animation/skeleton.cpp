@@ -1,5 +1,7 @@
 #include "skeleton.hpp"
 #include "debug.hpp"
+
+#include <algorithm>
 namespace ve{
     Skeleton::Skeleton(){}
     Skeleton::~Skeleton(){}
@@ -17,8 +19,87 @@ namespace ve{
             traverse(child, indent + 1);
         }
     }
+    bool Skeleton::buildHierarchy(){
+        size_t numJoints = joints.size();
+        parentIndices.resize(numJoints);
+        isTopological = true;
+        for(size_t i = 0; i < numJoints; i++){
+            int parent = joints[i].parentIndex;
+            parentIndices[i] = static_cast<int16_t>(parent);
+            if(parent != NO_PARENT && (parent < 0 || static_cast<size_t>(parent) >= i))
+                isTopological = false;
+        }
+        subtreeEnd.assign(numJoints, 0);
+        isContiguous = isTopological;
+        if(isTopological){
+            //children come after their parents, so a reverse pass sees every subtree before its root
+            std::vector<uint32_t> subtreeSize(numJoints, 1);
+            for(size_t i = numJoints; i-- > 0;){
+                if(parentIndices[i] != NO_PARENT)
+                    subtreeSize[parentIndices[i]] += subtreeSize[i];
+            }
+            //depth first order: every joint lies inside its parent's range, which makes each range exactly the subtree
+            for(size_t i = 0; i < numJoints; i++){
+                subtreeEnd[i] = static_cast<uint32_t>(i + subtreeSize[i]);
+                int parent = parentIndices[i];
+                if(parent != NO_PARENT && i >= parent + subtreeSize[parent])
+                    isContiguous = false;
+            }
+        }else{
+            LOGE("Skeleton %s: joints are not sorted parents first, using the recursive update", name.c_str());
+        }
+        modelMatrices.resize(numJoints);
+        //nothing computed yet
+        dirtyBegin = 0;
+        dirtyEnd = numJoints;
+        return isTopological;
+    }
+    void Skeleton::markDirty(int jointIndex){
+        if(parentIndices.size() != joints.size())
+            buildHierarchy();
+        size_t begin = static_cast<size_t>(jointIndex);
+        size_t end = isContiguous ? subtreeEnd[jointIndex] : joints.size();
+        if(!isContiguous)
+            begin = 0;
+        //joints between two dirty subtrees are recomputed too, their parents are either recomputed or clean
+        dirtyBegin = isDirty() ? std::min(dirtyBegin, begin) : begin;
+        dirtyEnd = std::max(dirtyEnd, end);
+    }
+    void Skeleton::updateDirty(){
+        if(parentIndices.size() != joints.size())
+            buildHierarchy();
+        if(!isDirty())
+            return;
+        if(!isTopological || !isAnimated){
+            updateRecursive();
+        }else{
+            updateRange(dirtyBegin, dirtyEnd);
+        }
+        dirtyBegin = dirtyEnd = 0;
+    }
     //update the coordinates of all joints based on animation
     void Skeleton::update(){
+        if(parentIndices.size() != joints.size())
+            buildHierarchy();
+        if(!isTopological || !isAnimated){
+            updateRecursive();
+        }else{
+            updateRange(0, joints.size());
+        }
+        dirtyBegin = dirtyEnd = 0;
+    }
+    void Skeleton::updateRange(size_t begin, size_t end){
+        //parents precede their children so every parent matrix is final when a child reads it
+        const int16_t* parents = parentIndices.data();
+        glm::mat4* model = modelMatrices.data();
+        for(size_t i = begin; i < end; i++){
+            glm::mat4 local = joints[i].getAnimatedMatrix();
+            model[i] = parents[i] == NO_PARENT ? local : model[parents[i]] * local;
+            //return from animated space to original model space
+            jointMatrices[i] = model[i] * joints[i].inverseBindMatrix;
+        }
+    }
+    void Skeleton::updateRecursive(){
         int16_t numJoints = static_cast<int16_t>(joints.size());
         // isAnimated = false;
         if(isAnimated){
@@ -28,6 +109,7 @@ namespace ve{
             }
             //recursively update joint matrices
             updateJoint(ROOT_JOINT);
+            modelMatrices = jointMatrices;
 
             //return from animated space to original model space
             for(int16_t i = 0; i < numJoints; i++){
@@ -58,6 +140,47 @@ namespace ve{
         }
         return false;
     }
+    size_t Skeleton::setLodMask(const std::vector<std::string>& jointNames){
+        lodMask.assign(joints.size(), 0);
+        size_t maskedCount = 0;
+        std::vector<int> pending;
+        for(const auto& jointName : jointNames){
+            auto it = std::find_if(joints.begin(), joints.end(), [&](const Joint& joint){return joint.name == jointName;});
+            if(it == joints.end()){
+                LOGE("LOD mask joint %s not found in skeleton %s", jointName.c_str(), name.c_str());
+                continue;
+            }
+            pending.push_back(static_cast<int>(it - joints.begin()));
+        }
+        while(!pending.empty()){
+            int jointIndex = pending.back();
+            pending.pop_back();
+            if(lodMask[jointIndex])
+                continue;
+            lodMask[jointIndex] = 1;
+            maskedCount++;
+            for(int child : joints[jointIndex].childrenIndices)
+                pending.push_back(child);
+        }
+        if(!maskedCount)
+            lodMask.clear();
+        lodMaskVersion++;
+        return maskedCount;
+    }
+    void Skeleton::setJointLimit(int jointIndex, float maxSwing, float maxTwist, float damping){
+        if(jointIndex < 0 || jointIndex >= static_cast<int>(joints.size())){
+            LOGE("Joint limit for unknown joint %d in skeleton %s", jointIndex, name.c_str());
+            return;
+        }
+        if(jointLimits.size() != joints.size())
+            jointLimits.assign(joints.size(), JointLimit{});
+        const auto& joint = joints[jointIndex];
+        //a child's translation is the bone direction in this joint's space
+        glm::vec3 boneAxis(0.0f, 1.0f, 0.0f);
+        if(!joint.childrenIndices.empty() && glm::length(joints[joint.childrenIndices[0]].translation) > 0.0f)
+            boneAxis = joints[joint.childrenIndices[0]].translation;
+        jointLimits[jointIndex] = JointLimit::create(joint.rotation, boneAxis, maxSwing, maxTwist, damping);
+    }
     // Implementation of the new methods
     void Skeleton::updateJointMatrices() {
         // First set local matrices for all joints
@@ -79,6 +202,19 @@ namespace ve{
         }
     }
 
+    void Skeleton::updateForIK(){
+        updateJointMatrices();
+        if(parentIndices.size() != joints.size())
+            buildHierarchy();
+        if(!isTopological){
+            applyParentTransforms(ROOT_JOINT);
+            return;
+        }
+        for(size_t i = 0; i < joints.size(); i++){
+            if(parentIndices[i] != NO_PARENT)
+                jointMatrices[i] = jointMatrices[parentIndices[i]] * jointMatrices[i];
+        }
+    }
     void Skeleton::applyParentTransforms(int16_t jointIndex) {
         auto& currentJoint = joints[jointIndex];
         int16_t parentJoint = currentJoint.parentIndex;
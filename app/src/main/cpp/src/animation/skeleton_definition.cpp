@@ -0,0 +1,138 @@
+#include "skeleton_definition.hpp"
+#include "debug.hpp"
+
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+
+namespace ve{
+    std::shared_ptr<const SkeletonDefinition> SkeletonDefinition::create(const Skeleton& skeleton){
+        //buildHierarchy caches into the skeleton, run it on a copy to keep the source untouched
+        Skeleton sorted = skeleton;
+        if(!sorted.buildHierarchy()){
+            LOGE("Skeleton %s: cannot share a rig whose joints are not sorted parents first", skeleton.name.c_str());
+            return nullptr;
+        }
+        auto definition = std::make_shared<SkeletonDefinition>();
+        size_t numJoints = skeleton.joints.size();
+        definition->name = skeleton.name;
+        definition->parentIndices = sorted.parentIndices;
+        definition->subtreeEnd = sorted.subtreeEnd;
+        definition->nodeJointMap = skeleton.nodeJointMap;
+        definition->lodMask = skeleton.lodMask;
+        definition->jointLimits = skeleton.jointLimits;
+        definition->jointNames.reserve(numJoints);
+        definition->inverseBindMatrices.reserve(numJoints);
+        definition->restPose.resize(numJoints);
+        bool hasNodeMatrices = false;
+        for(size_t i = 0; i < numJoints; i++){
+            const auto& joint = skeleton.joints[i];
+            definition->jointNames.push_back(joint.name);
+            definition->inverseBindMatrices.push_back(joint.inverseBindMatrix);
+            hasNodeMatrices = hasNodeMatrices || joint.jointWorldMatrix != glm::mat4(1.0f);
+        }
+        if(hasNodeMatrices){
+            definition->nodeMatrices.reserve(numJoints);
+            for(const auto& joint : skeleton.joints)
+                definition->nodeMatrices.push_back(joint.jointWorldMatrix);
+        }
+        definition->restPose.pose().readFrom(skeleton);
+        return definition;
+    }
+    int SkeletonDefinition::findJoint(const std::string& jointName) const{
+        auto it = std::find(jointNames.begin(), jointNames.end(), jointName);
+        return it == jointNames.end() ? -1 : static_cast<int>(it - jointNames.begin());
+    }
+    size_t SkeletonDefinition::getMemoryUsage() const{
+        size_t bytes = sizeof(SkeletonDefinition);
+        for(const auto& jointName : jointNames)
+            bytes += jointName.capacity();
+        bytes += jointNames.capacity() * sizeof(std::string);
+        bytes += parentIndices.capacity() * sizeof(int16_t);
+        bytes += subtreeEnd.capacity() * sizeof(uint32_t);
+        bytes += (inverseBindMatrices.capacity() + nodeMatrices.capacity()) * sizeof(glm::mat4);
+        //red-black tree node: three pointers and a color next to the pair
+        bytes += nodeJointMap.size() * (sizeof(std::pair<const int, int>) + 4 * sizeof(void*));
+        bytes += lodMask.capacity();
+        bytes += jointLimits.capacity() * sizeof(JointLimit);
+        bytes += Pose::strideFor(getJointCount()) * Pose::STREAM_COUNT * sizeof(float);
+        return bytes;
+    }
+
+    void SkeletonInstance::resetToRestPose(){
+        local.copyFrom(definition->getRestPose());
+    }
+    void SkeletonInstance::updatePalette(){
+        const auto& rig = *definition;
+        size_t numJoints = local.jointCount;
+        const int16_t* parents = rig.parentIndices.data();
+        const glm::mat4* nodeMatrices = rig.nodeMatrices.empty() ? nullptr : rig.nodeMatrices.data();
+        const float* tx = local.stream(Pose::TX);
+        const float* ty = local.stream(Pose::TY);
+        const float* tz = local.stream(Pose::TZ);
+        const float* sx = local.stream(Pose::SX);
+        const float* sy = local.stream(Pose::SY);
+        const float* sz = local.stream(Pose::SZ);
+        //model space first, children read their parent's matrix before the inverse bind is applied
+        for(size_t i = 0; i < numJoints; i++){
+            //T * R * S written out, same as Joint::getAnimatedMatrix
+            glm::mat4 matrix = glm::mat4_cast(local.getRotation(i));
+            matrix[0] *= sx[i];
+            matrix[1] *= sy[i];
+            matrix[2] *= sz[i];
+            matrix[3] = glm::vec4(tx[i], ty[i], tz[i], 1.0f);
+            if(nodeMatrices)
+                matrix = matrix * nodeMatrices[i];
+            palette[i] = parents[i] == NO_PARENT ? matrix : palette[parents[i]] * matrix;
+        }
+        for(size_t i = 0; i < numJoints; i++){
+            palette[i] = palette[i] * rig.inverseBindMatrices[i];
+        }
+    }
+
+    SkeletonInstancePool::SkeletonInstancePool(std::shared_ptr<const SkeletonDefinition> definition, size_t capacity)
+        : definition(std::move(definition)){
+        size_t numJoints = this->definition->getJointCount();
+        size_t stride = Pose::strideFor(numJoints);
+        poseStorage.assign(stride * Pose::STREAM_COUNT * capacity, 0.0f);
+        paletteStorage.assign(numJoints * capacity, glm::mat4(1.0f));
+        instances.resize(capacity);
+        freeList.reserve(capacity);
+        for(size_t i = 0; i < capacity; i++){
+            auto& instance = instances[i];
+            instance.definition = this->definition.get();
+            instance.local.data = poseStorage.data() + i * stride * Pose::STREAM_COUNT;
+            instance.local.jointCount = numJoints;
+            instance.local.stride = stride;
+            instance.palette = paletteStorage.data() + i * numJoints;
+            //hand out low indices first
+            freeList.push_back(static_cast<uint32_t>(capacity - 1 - i));
+        }
+    }
+    SkeletonInstancePool::Handle SkeletonInstancePool::acquire(){
+        SkeletonInstance* instance = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(freeList.empty()){
+                LOGE("Skeleton instance pool for %s exhausted (%zu instances)", definition->name.c_str(), instances.size());
+                return Handle(nullptr, Releaser{this});
+            }
+            instance = &instances[freeList.back()];
+            freeList.pop_back();
+        }
+        instance->resetToRestPose();
+        instance->updatePalette();
+        return Handle(instance, Releaser{this});
+    }
+    void SkeletonInstancePool::release(SkeletonInstance* instance){
+        std::lock_guard<std::mutex> lock(mutex);
+        freeList.push_back(static_cast<uint32_t>(instance - instances.data()));
+    }
+    size_t SkeletonInstancePool::getUsed() const{
+        std::lock_guard<std::mutex> lock(mutex);
+        return instances.size() - freeList.size();
+    }
+    size_t SkeletonInstancePool::getMemoryUsage() const{
+        return poseStorage.capacity() * sizeof(float) + paletteStorage.capacity() * sizeof(glm::mat4) +
+               instances.capacity() * sizeof(SkeletonInstance);
+    }
+}
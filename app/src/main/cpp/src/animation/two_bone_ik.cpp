@@ -0,0 +1,262 @@
+#include "two_bone_ik.hpp"
+#include "ik_chain.hpp"
+#include "simd_math.hpp"
+#include "debug.hpp"
+
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace ve{
+    namespace{
+        using simd::float4;
+        using ikMath::EPSILON;
+        using ikMath::jointPosition;
+        using ikMath::globalRotation;
+
+        // three components over four lanes
+        struct Vector4{
+            float4 x, y, z;
+        };
+        struct Quaternion4{
+            float4 x, y, z, w;
+        };
+        inline Vector4 operator+(const Vector4& a, const Vector4& b){return {a.x + b.x, a.y + b.y, a.z + b.z};}
+        inline Vector4 operator-(const Vector4& a, const Vector4& b){return {a.x - b.x, a.y - b.y, a.z - b.z};}
+        inline Vector4 operator*(const Vector4& a, float4 s){return {a.x * s, a.y * s, a.z * s};}
+        inline float4 dot(const Vector4& a, const Vector4& b){return a.x * b.x + a.y * b.y + a.z * b.z;}
+        inline Vector4 cross(const Vector4& a, const Vector4& b){
+            return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+        }
+        inline Quaternion4 multiply(const Quaternion4& p, const Quaternion4& q){
+            return {p.w * q.x + p.x * q.w + p.y * q.z - p.z * q.y,
+                    p.w * q.y + p.y * q.w + p.z * q.x - p.x * q.z,
+                    p.w * q.z + p.z * q.w + p.x * q.y - p.y * q.x,
+                    p.w * q.w - p.x * q.x - p.y * q.y - p.z * q.z};
+        }
+        inline Quaternion4 conjugate(const Quaternion4& q){
+            float4 zero = simd::splat(0.0f);
+            return {zero - q.x, zero - q.y, zero - q.z, q.w};
+        }
+        inline Quaternion4 normalize(const Quaternion4& q){
+            float4 inverseLength = simd::rsqrt(simd::max(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w, simd::splat(EPSILON * EPSILON)));
+            return {q.x * inverseLength, q.y * inverseLength, q.z * inverseLength, q.w * inverseLength};
+        }
+        //v + 2w(q x v) + 2q x (q x v), same as glm's quat * vec3
+        inline Vector4 rotate(const Quaternion4& q, const Vector4& v){
+            Vector4 axis{q.x, q.y, q.z};
+            Vector4 uv = cross(axis, v);
+            Vector4 uuv = cross(axis, uv);
+            float4 two = simd::splat(2.0f);
+            return v + (uv * q.w + uuv) * two;
+        }
+        inline Quaternion4 fromTo(const Vector4& u, const Vector4& v){
+            Vector4 axis = cross(u, v);
+            float4 w = simd::sqrt(dot(u, u) * dot(v, v)) + dot(u, v);
+            return normalize({axis.x, axis.y, axis.z, w});
+        }
+        inline Quaternion4 weighted(const Quaternion4& q, float4 weight){
+            return normalize({q.x * weight, q.y * weight, q.z * weight, simd::madd(q.w - simd::splat(1.0f), weight, simd::splat(1.0f))});
+        }
+
+        // inputs and outputs of simd::WIDTH chains, component major so every row loads as one float4
+        struct Lanes{
+            float root[3][4];
+            float mid[3][4];
+            float end[3][4];
+            float target[3][4];
+            float pole[3][4];
+            float weight[4];
+            float rootParentRotation[4][4];
+            float midParentRotation[4][4];
+            float rootLocal[4][4];
+            float midLocal[4][4];
+        };
+
+        void gather(const Skeleton& skeleton, const TwoBoneChain& chain, const TwoBoneGoal& goal, Lanes& lanes, size_t lane){
+            auto put3 = [lane](float (&row)[3][4], const glm::vec3& v){
+                row[0][lane] = v.x;
+                row[1][lane] = v.y;
+                row[2][lane] = v.z;
+            };
+            auto put4 = [lane](float (&row)[4][4], const glm::quat& q){
+                row[0][lane] = q.x;
+                row[1][lane] = q.y;
+                row[2][lane] = q.z;
+                row[3][lane] = q.w;
+            };
+            put3(lanes.root, jointPosition(skeleton, chain.root));
+            put3(lanes.mid, jointPosition(skeleton, chain.mid));
+            put3(lanes.end, jointPosition(skeleton, chain.end));
+            put3(lanes.target, goal.target);
+            put3(lanes.pole, goal.pole);
+            lanes.weight[lane] = std::clamp(goal.weight, 0.0f, 1.0f);
+            put4(lanes.rootParentRotation, globalRotation(skeleton, skeleton.joints[chain.root].parentIndex));
+            put4(lanes.midParentRotation, globalRotation(skeleton, skeleton.joints[chain.mid].parentIndex));
+            put4(lanes.rootLocal, skeleton.joints[chain.root].rotation);
+            put4(lanes.midLocal, skeleton.joints[chain.mid].rotation);
+        }
+
+        Vector4 load3(const float (&row)[3][4]){
+            return {simd::load(row[0]), simd::load(row[1]), simd::load(row[2])};
+        }
+        Quaternion4 load4(const float (&row)[4][4]){
+            return {simd::load(row[0]), simd::load(row[1]), simd::load(row[2]), simd::load(row[3])};
+        }
+        void store4(float (&row)[4][4], const Quaternion4& q){
+            simd::store(row[0], q.x);
+            simd::store(row[1], q.y);
+            simd::store(row[2], q.z);
+            simd::store(row[3], q.w);
+        }
+
+        //the scalar solve written out over four lanes, results replace rootLocal and midLocal
+        void solveLanes(Lanes& lanes){
+            Vector4 a = load3(lanes.root);
+            Vector4 b = load3(lanes.mid);
+            Vector4 c = load3(lanes.end);
+            Vector4 t = load3(lanes.target);
+            Vector4 p = load3(lanes.pole);
+            float4 epsilon = simd::splat(EPSILON);
+            float4 epsilon2 = simd::splat(EPSILON * EPSILON);
+
+            Vector4 upperBone = b - a;
+            Vector4 lowerBone = c - b;
+            float4 upper2 = dot(upperBone, upperBone);
+            float4 lower2 = dot(lowerBone, lowerBone);
+            float4 upper = simd::sqrt(upper2);
+            float4 lower = simd::sqrt(lower2);
+
+            Vector4 toTarget = t - a;
+            float4 distance2 = simd::max(dot(toTarget, toTarget), epsilon2);
+            float4 inverseDistance = simd::rsqrt(distance2);
+            Vector4 direction = toTarget * inverseDistance;
+            float4 distance = distance2 * inverseDistance;
+            distance = simd::min(simd::max(distance, simd::max(simd::abs(upper - lower), epsilon)), upper + lower);
+            inverseDistance = simd::rsqrt(distance * distance);
+
+            float4 along = (upper2 - lower2 + distance * distance) * simd::splat(0.5f) * inverseDistance;
+            float4 height = simd::sqrt(upper2 - along * along);
+            Vector4 offset = p - a;
+            Vector4 bend = offset - direction * dot(offset, direction);
+            bend = bend * simd::rsqrt(simd::max(dot(bend, bend), epsilon2));
+
+            Vector4 knee = a + direction * along + bend * height;
+            Vector4 paw = a + direction * distance;
+            float4 weight = simd::load(lanes.weight);
+            Quaternion4 q0 = fromTo(upperBone, knee - a);
+            Quaternion4 q1 = fromTo(rotate(q0, lowerBone), paw - knee);
+            q0 = weighted(q0, weight);
+            q1 = weighted(q1, weight);
+
+            //a global delta q on a joint with parent rotation P: local' = P^-1 * q * P * local
+            Quaternion4 rootParent = load4(lanes.rootParentRotation);
+            Quaternion4 rootLocal = multiply(multiply(conjugate(rootParent), multiply(q0, rootParent)), load4(lanes.rootLocal));
+            Quaternion4 midParent = multiply(q0, load4(lanes.midParentRotation));
+            Quaternion4 midLocal = multiply(multiply(conjugate(midParent), multiply(q1, midParent)), load4(lanes.midLocal));
+            store4(lanes.rootLocal, normalize(rootLocal));
+            store4(lanes.midLocal, normalize(midLocal));
+        }
+    }
+
+    namespace twoBoneIK{
+        TwoBoneChain findChain(const Skeleton& skeleton, const std::string& endJoint){
+            TwoBoneChain chain;
+            for(size_t i = 0; i < skeleton.joints.size(); i++){
+                if(skeleton.joints[i].name == endJoint){
+                    chain.end = static_cast<int>(i);
+                    break;
+                }
+            }
+            if(chain.end == -1)
+                return chain;
+            chain.mid = skeleton.joints[chain.end].parentIndex;
+            if(chain.mid != NO_PARENT)
+                chain.root = skeleton.joints[chain.mid].parentIndex;
+            return chain;
+        }
+
+        bool isValid(const Skeleton& skeleton, const TwoBoneChain& chain){
+            int jointCount = static_cast<int>(skeleton.joints.size());
+            auto inRange = [jointCount](int joint){return joint >= 0 && joint < jointCount;};
+            if(!inRange(chain.root) || !inRange(chain.mid) || !inRange(chain.end))
+                return false;
+            auto descends = [&](int child, int ancestor){
+                for(int joint = skeleton.joints[child].parentIndex; joint != NO_PARENT; joint = skeleton.joints[joint].parentIndex){
+                    if(joint == ancestor)
+                        return true;
+                }
+                return false;
+            };
+            return descends(chain.end, chain.mid) && descends(chain.mid, chain.root);
+        }
+
+        void solve(Skeleton& skeleton, const TwoBoneChain& chain, const TwoBoneGoal& goal){
+            if(!isValid(skeleton, chain)){
+                LOGE("Skeleton %s: invalid two bone chain %d %d %d", skeleton.name.c_str(), chain.root, chain.mid, chain.end);
+                return;
+            }
+            glm::vec3 a = jointPosition(skeleton, chain.root);
+            glm::vec3 b = jointPosition(skeleton, chain.mid);
+            glm::vec3 c = jointPosition(skeleton, chain.end);
+            float upper = glm::length(b - a);
+            float lower = glm::length(c - b);
+
+            glm::vec3 toTarget = goal.target - a;
+            float distance = std::max(glm::length(toTarget), EPSILON);
+            glm::vec3 direction = toTarget / distance;
+            distance = std::min(std::max(distance, std::max(std::abs(upper - lower), EPSILON)), upper + lower);
+
+            //law of cosines: distance from the root to the knee's foot point along the root-target line
+            float along = (upper * upper - lower * lower + distance * distance) / (2.0f * distance);
+            float height = std::sqrt(std::max(upper * upper - along * along, 0.0f));
+            glm::vec3 offset = goal.pole - a;
+            glm::vec3 bend = offset - direction * glm::dot(offset, direction);
+            bend /= std::max(glm::length(bend), EPSILON);
+
+            glm::vec3 knee = a + direction * along + bend * height;
+            glm::vec3 paw = a + direction * distance;
+            float weight = std::clamp(goal.weight, 0.0f, 1.0f);
+            glm::quat q0 = ikMath::rotationBetween(b - a, knee - a);
+            glm::quat q1 = ikMath::rotationBetween(q0 * (c - b), paw - knee);
+            q0 = ikMath::scaleRotation(q0, weight);
+            q1 = ikMath::scaleRotation(q1, weight);
+
+            auto& root = skeleton.joints[chain.root];
+            auto& mid = skeleton.joints[chain.mid];
+            glm::quat rootParent = globalRotation(skeleton, root.parentIndex);
+            glm::quat midParent = q0 * globalRotation(skeleton, mid.parentIndex);
+            root.rotation = glm::normalize(glm::conjugate(rootParent) * q0 * rootParent * root.rotation);
+            mid.rotation = glm::normalize(glm::conjugate(midParent) * q1 * midParent * mid.rotation);
+            skeleton.markDirty(chain.root);
+        }
+
+        void solveBatch(Skeleton& skeleton, const TwoBoneChain* chains, const TwoBoneGoal* goals, size_t count){
+            Lanes lanes;
+            size_t solved[simd::WIDTH];
+            for(size_t begin = 0; begin < count; begin += simd::WIDTH){
+                size_t used = 0;
+                for(size_t i = begin; i < std::min(begin + simd::WIDTH, count); i++){
+                    if(!isValid(skeleton, chains[i])){
+                        LOGE("Skeleton %s: invalid two bone chain %d %d %d", skeleton.name.c_str(), chains[i].root, chains[i].mid, chains[i].end);
+                        continue;
+                    }
+                    gather(skeleton, chains[i], goals[i], lanes, used);
+                    solved[used++] = i;
+                }
+                if(used == 0)
+                    continue;
+                //unused lanes repeat the first chain and are not written back
+                for(size_t lane = used; lane < simd::WIDTH; lane++)
+                    gather(skeleton, chains[solved[0]], goals[solved[0]], lanes, lane);
+                solveLanes(lanes);
+                for(size_t lane = 0; lane < used; lane++){
+                    const auto& chain = chains[solved[lane]];
+                    skeleton.joints[chain.root].rotation = glm::quat(lanes.rootLocal[3][lane], lanes.rootLocal[0][lane], lanes.rootLocal[1][lane], lanes.rootLocal[2][lane]);
+                    skeleton.joints[chain.mid].rotation = glm::quat(lanes.midLocal[3][lane], lanes.midLocal[0][lane], lanes.midLocal[1][lane], lanes.midLocal[2][lane]);
+                    skeleton.markDirty(chain.root);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,1912 @@
+#include "benchmarks.hpp"
+#include "debug.hpp"
+#include "clip_library.hpp"
+#include "animation_lod.hpp"
+#include "skeleton_definition.hpp"
+#include "two_bone_ik.hpp"
+#include "fabrik.hpp"
+#include "ccd.hpp"
+#include "dls_ik.hpp"
+#include "foot_placement.hpp"
+#include "collision_bvh.hpp"
+#include "aim_constraint.hpp"
+#include "ik_drag.hpp"
+#include "cpu_skinning.hpp"
+#include "dual_quaternion.hpp"
+#include "vertex_packing.hpp"
+#include "simd_math.hpp"
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ve::benchmarks{
+    namespace{
+        using Clock = std::chrono::steady_clock;
+        constexpr float CLIP_RATE = 30.0f;
+        constexpr float FRAME_TIME = 1.0f / 60.0f;
+
+        double elapsedNs(Clock::time_point start, Clock::time_point end){
+            return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+
+        //failed checks since the last runAll
+        int failures = 0;
+        const char* verdict(bool passed){
+            if(!passed){
+                failures++;
+            }
+            return passed ? "PASS" : "FAIL";
+        }
+    }
+
+    std::unique_ptr<Skeleton> createChainSkeleton(int numJoints){
+        auto skeleton = std::make_unique<Skeleton>();
+        skeleton->name = "benchmark_chain";
+        skeleton->joints.resize(numJoints);
+        skeleton->jointMatrices.resize(numJoints);
+        for(int i = 0; i < numJoints; i++){
+            auto& joint = skeleton->joints[i];
+            joint.name = "joint_" + std::to_string(i);
+            joint.parentIndex = i - 1;
+            if(i + 1 < numJoints)
+                joint.childrenIndices.push_back(i + 1);
+            joint.inverseBindMatrix = glm::mat4(1.0f);
+            joint.translation = glm::vec3(0.0f, 0.1f, 0.0f);
+            skeleton->nodeJointMap[i] = i;
+        }
+        return skeleton;
+    }
+
+    std::unique_ptr<Skeleton> createQuadrupedSkeleton(){
+        auto skeleton = std::make_unique<Skeleton>();
+        skeleton->name = "benchmark_quadruped";
+        auto addJoint = [&](const std::string& name, int parent, const glm::vec3& translation){
+            int index = static_cast<int>(skeleton->joints.size());
+            skeleton->joints.emplace_back();
+            auto& joint = skeleton->joints.back();
+            joint.name = name;
+            joint.parentIndex = parent;
+            joint.translation = translation;
+            joint.inverseBindMatrix = glm::mat4(1.0f);
+            if(parent != NO_PARENT)
+                skeleton->joints[parent].childrenIndices.push_back(index);
+            skeleton->nodeJointMap[index] = index;
+            return index;
+        };
+        int pelvis = addJoint("pelvis", NO_PARENT, glm::vec3(0.0f, 0.45f, 0.0f));
+        //depth first like a sorted glTF rig, knees slightly bent forward
+        const glm::vec3 hips[4] = {{-0.1f, 0.0f, 0.25f}, {0.1f, 0.0f, 0.25f}, {-0.1f, 0.0f, -0.25f}, {0.1f, 0.0f, -0.25f}};
+        for(int leg = 0; leg < 4; leg++){
+            int hip = addJoint("hip_" + std::to_string(leg), pelvis, hips[leg]);
+            int knee = addJoint("knee_" + std::to_string(leg), hip, glm::vec3(0.0f, -0.2f, 0.03f));
+            int paw = addJoint("paw_" + std::to_string(leg), knee, glm::vec3(0.0f, -0.2f, -0.03f));
+            addJoint("toe_" + std::to_string(leg) + "_0", paw, glm::vec3(-0.01f, -0.01f, 0.04f));
+            addJoint("toe_" + std::to_string(leg) + "_1", paw, glm::vec3(0.01f, -0.01f, 0.04f));
+        }
+        int parent = pelvis;
+        for(int i = 0; i < 3; i++)
+            parent = addJoint("spine_" + std::to_string(i), parent, glm::vec3(0.0f, 0.02f, 0.1f));
+        for(int i = 0; i < 2; i++)
+            parent = addJoint("neck_" + std::to_string(i), parent, glm::vec3(0.0f, 0.08f, 0.05f));
+        int head = addJoint("head", parent, glm::vec3(0.0f, 0.06f, 0.04f));
+        addJoint("ear_l", head, glm::vec3(-0.04f, 0.05f, 0.0f));
+        addJoint("ear_r", head, glm::vec3(0.04f, 0.05f, 0.0f));
+        addJoint("jaw", head, glm::vec3(0.0f, -0.03f, 0.06f));
+        parent = pelvis;
+        for(int i = 0; i < 20; i++)
+            parent = addJoint("tail_" + std::to_string(i), parent, glm::vec3(0.0f, 0.005f, -0.02f));
+        skeleton->jointMatrices.resize(skeleton->joints.size());
+        return skeleton;
+    }
+
+    std::shared_ptr<Animation> createSyntheticClip(int numJoints, int keysPerChannel){
+        auto animation = std::make_shared<Animation>("benchmark_" + std::to_string(keysPerChannel));
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+        animation->samplers.resize(numJoints * 3);
+        animation->channels.resize(numJoints * 3);
+        for(int joint = 0; joint < numJoints; joint++){
+            for(int path = 0; path < 3; path++){
+                int index = joint * 3 + path;
+                auto& sampler = animation->samplers[index];
+                sampler.interpolationMethod = Animation::InterpolationMethod::LINEAR;
+                sampler.timeStamps.resize(keysPerChannel);
+                sampler.TRSoutputValues.resize(keysPerChannel);
+                //small random steps per key so consecutive rotations stay close like real motion data
+                glm::vec4 value = path == 1 ? glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) : glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+                for(int key = 0; key < keysPerChannel; key++){
+                    sampler.timeStamps[key] = static_cast<float>(key) / CLIP_RATE;
+                    glm::vec4 step(dist(rng), dist(rng), dist(rng), dist(rng));
+                    if(path == 1){
+                        value = glm::normalize(value + step * 0.1f);
+                    }else{
+                        value += glm::vec4(glm::vec3(step) * 0.05f, 0.0f);
+                    }
+                    sampler.TRSoutputValues[key] = value;
+                }
+                auto& channel = animation->channels[index];
+                channel.pathType = static_cast<Animation::PathType>(path);
+                channel.samplerIndex = index;
+                channel.node = joint;
+            }
+        }
+        animation->setFirstKeyFrameTime(0.0f);
+        animation->setLastKeyFrameTime(static_cast<float>(keysPerChannel - 1) / CLIP_RATE);
+        return animation;
+    }
+
+    void runKeyframeLookupBenchmark(){
+        constexpr int NUM_JOINTS = 60;
+        constexpr int NUM_FRAMES = 2000;
+        constexpr int NUM_SEEKS = 500;
+        const int keyCounts[] = {30, 300, 3000, 30000};
+
+        auto skeleton = createChainSkeleton(NUM_JOINTS);
+        LOGI("[bench] keyframe lookup: %d joints, %d channels", NUM_JOINTS, NUM_JOINTS * 3);
+        for(int keys : keyCounts){
+            auto animation = createSyntheticClip(NUM_JOINTS, keys);
+            animation->start();
+
+            //playback: the cursor advances by at most one interval per frame
+            auto start = Clock::now();
+            for(int frame = 0; frame < NUM_FRAMES; frame++){
+                animation->update(FRAME_TIME, *skeleton);
+            }
+            double playbackNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+
+            //seeking: every sample falls back to the binary search
+            std::mt19937 rng(42);
+            std::uniform_real_distribution<float> seek(0.0f, animation->getDuration());
+            start = Clock::now();
+            for(int i = 0; i < NUM_SEEKS; i++){
+                animation->currentKeyFrameTime = seek(rng);
+                animation->updatePose(*skeleton);
+            }
+            double seekNs = elapsedNs(start, Clock::now()) / NUM_SEEKS;
+
+            //the cursor must land on the same interval as a fresh binary search during playback, after seeks and across wraps
+            std::vector<size_t> cursors(animation->samplers.size(), Animation::NO_KEYFRAME);
+            size_t checks = 0;
+            size_t mismatches = 0;
+            auto compare = [&](float time){
+                for(size_t i = 0; i < cursors.size(); i++){
+                    size_t fresh = Animation::NO_KEYFRAME;
+                    size_t expected = Animation::findKeyframe(animation->samplers[i], time, fresh);
+                    mismatches += Animation::findKeyframe(animation->samplers[i], time, cursors[i]) != expected ? 1 : 0;
+                    checks++;
+                }
+            };
+            float time = 0.0f;
+            for(int frame = 0; frame < NUM_FRAMES; frame++){
+                time = animation->wrapTime(time + FRAME_TIME);
+                compare(time);
+            }
+            for(int i = 0; i < NUM_SEEKS; i++){
+                //a seek followed by a few frames of playback from there
+                time = seek(rng);
+                for(int frame = 0; frame < 4; frame++){
+                    compare(time);
+                    time = animation->wrapTime(time + FRAME_TIME);
+                }
+            }
+            for(int wrap = 0; wrap < 4; wrap++){
+                time = animation->getDuration() - 5.5f * FRAME_TIME;
+                for(int frame = 0; frame < 12; frame++){
+                    compare(time);
+                    time = animation->wrapTime(time + FRAME_TIME);
+                }
+            }
+            //the last key and just past it
+            compare(animation->getDuration());
+            compare(animation->getDuration() + 0.5f * FRAME_TIME);
+
+            LOGI("[bench]   %6d keys/channel: playback %8.0f ns/frame, seek %8.0f ns/frame, cursor vs binary search %zu/%zu mismatches -> %s",
+                 keys, playbackNs, seekNs, mismatches, checks, verdict(mismatches == 0));
+        }
+    }
+
+    void runCompressionBenchmark(){
+        constexpr int NUM_JOINTS = 60;
+        constexpr int KEYS_PER_CHANNEL = 300;
+        constexpr int NUM_FRAMES = 2000;
+
+        auto rawSkeleton = createChainSkeleton(NUM_JOINTS);
+        auto compressedSkeleton = createChainSkeleton(NUM_JOINTS);
+        auto raw = createSyntheticClip(NUM_JOINTS, KEYS_PER_CHANNEL);
+        auto compressed = createSyntheticClip(NUM_JOINTS, KEYS_PER_CHANNEL);
+        compressed->compress(CLIP_RATE);
+
+        size_t rawBytes = raw->getMemoryUsage();
+        size_t compressedBytes = compressed->getMemoryUsage();
+        LOGI("[bench] compression: %d joints, %d keys/channel: %zu -> %zu bytes per clip (%.1fx)",
+             NUM_JOINTS, KEYS_PER_CHANNEL, rawBytes, compressedBytes,
+             static_cast<double>(rawBytes) / static_cast<double>(compressedBytes));
+
+        raw->start();
+        compressed->start();
+        auto start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            raw->update(FRAME_TIME, *rawSkeleton);
+        }
+        double rawNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+        start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            compressed->update(FRAME_TIME, *compressedSkeleton);
+        }
+        double compressedNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+
+        //compare the sampled local poses of both clips at the same times
+        float maxAngle = 0.0f;
+        float maxDistance = 0.0f;
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> seek(0.0f, raw->getDuration());
+        for(int i = 0; i < 200; i++){
+            float time = seek(rng);
+            raw->currentKeyFrameTime = time;
+            compressed->currentKeyFrameTime = time;
+            raw->updatePose(*rawSkeleton);
+            compressed->updatePose(*compressedSkeleton);
+            for(int joint = 0; joint < NUM_JOINTS; joint++){
+                const auto& a = rawSkeleton->joints[joint];
+                const auto& b = compressedSkeleton->joints[joint];
+                glm::quat other = glm::dot(a.rotation, b.rotation) < 0.0f ? -b.rotation : b.rotation;
+                float chord = glm::length(a.rotation - other);
+                maxAngle = std::max(maxAngle, 4.0f * std::asin(std::min(1.0f, chord * 0.5f)));
+                maxDistance = std::max(maxDistance, glm::length(a.translation - b.translation));
+                maxDistance = std::max(maxDistance, glm::length(a.scale - b.scale));
+            }
+        }
+        float maxRotationBound = 0.0f;
+        float maxLinearBound = 0.0f;
+        for(size_t channel = 0; channel < compressed->channels.size(); channel++){
+            float& bound = compressed->channels[channel].pathType == Animation::PathType::ROTATION ? maxRotationBound : maxLinearBound;
+            bound = std::max(bound, compressed->getChannelError(channel));
+        }
+        //decoding quantized keys costs time, compression trades playback speed for memory
+        LOGI("[bench]   playback raw %8.0f ns/frame, compressed %8.0f ns/frame (%.2fx the cost)", rawNs, compressedNs,
+             compressedNs / std::max(rawNs, 1.0));
+        //blending two keys stays within their error, the linear bound is per component so a vec3 may reach sqrt(3) of it
+        bool withinBound = maxAngle <= maxRotationBound * 1.01f + 1e-5f && maxDistance <= maxLinearBound * 1.7321f + 1e-5f;
+        LOGI("[bench]   pose error: %f rad, %f units (channel bounds %f rad, %f units) -> %s", maxAngle, maxDistance,
+             maxRotationBound, maxLinearBound, verdict(withinBound));
+
+        //a last key off the frame grid must still be reachable at its true time, and keys closer than the finest
+        //frame step must not be quantized onto the same frame
+        Animation edges("compression edges");
+        Animation::Sampler offGrid;
+        offGrid.interpolationMethod = Animation::InterpolationMethod::LINEAR;
+        offGrid.timeStamps = {0.0f, 0.5f, 1.01f};
+        offGrid.TRSoutputValues = {glm::vec4(0.0f), glm::vec4(1.0f), glm::vec4(2.0f)};
+        Animation::Sampler crowded = offGrid;
+        crowded.timeStamps = {0.0f, 1e-6f, 1.01f};
+        edges.samplers = {offGrid, crowded};
+        edges.channels.push_back({Animation::PathType::TRANSLATION, 0, 0});
+        edges.channels.push_back({Animation::PathType::TRANSLATION, 1, 1});
+        edges.compress(CLIP_RATE);
+        size_t cursor = Animation::NO_KEYFRAME;
+        bool endReachable = edges.samplers[0].compressed && Animation::findKeyframe(edges.samplers[0], 1.01f, cursor) == 1;
+        bool crowdedKept = !edges.samplers[1].compressed && edges.samplers[1].keyCount() == 3;
+        LOGI("[bench]   off grid last key reachable: %s, colliding keys kept as floats: %s -> %s",
+             endReachable ? "yes" : "no", crowdedKept ? "yes" : "no", verdict(endReachable && crowdedKept));
+
+        //decompress bakes retarget remaps into the keys: a sampler shared by three channels, two of them with
+        //the same remap, must be compensated once per distinct remap
+        Animation shared("shared sampler");
+        Animation::Sampler sampler;
+        sampler.interpolationMethod = Animation::InterpolationMethod::LINEAR;
+        sampler.timeStamps = {0.0f, 1.0f};
+        sampler.TRSoutputValues = {glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f)};
+        shared.samplers.push_back(sampler);
+        for(int node = 0; node < 3; node++)
+            shared.channels.push_back({Animation::PathType::TRANSLATION, 0, node});
+        Animation::ChannelRemap doubled;
+        doubled.factor = glm::vec3(2.0f);
+        Animation::ChannelRemap tripled;
+        tripled.factor = glm::vec3(3.0f);
+        shared.channelRemaps = {doubled, tripled, doubled};
+        shared.decompress();
+        auto keyOf = [&](int channel){return shared.samplers[shared.channels[channel].samplerIndex].TRSoutputValues[0].x;};
+        bool remapsOnce = keyOf(0) == 2.0f && keyOf(1) == 3.0f && keyOf(2) == 2.0f && shared.samplers.size() == 2 &&
+                          shared.channels[0].samplerIndex == shared.channels[2].samplerIndex;
+        LOGI("[bench]   decompress of a sampler shared by channels with different remaps: keys %g / %g / %g, %zu samplers -> %s",
+             keyOf(0), keyOf(1), keyOf(2), shared.samplers.size(), verdict(remapsOnce));
+    }
+
+    void runBakeBenchmark(){
+        constexpr int NUM_JOINTS = 60;
+        constexpr int KEYS_PER_CHANNEL = 3000;
+        constexpr int NUM_FRAMES = 2000;
+        constexpr int NUM_SEEKS = 500;
+        const float bakeRates[] = {0.0f, 30.0f, 60.0f};
+
+        auto skeleton = createChainSkeleton(NUM_JOINTS);
+        LOGI("[bench] uniform baking: %d joints, %d keys/channel", NUM_JOINTS, KEYS_PER_CHANNEL);
+        for(float rate : bakeRates){
+            auto animation = createSyntheticClip(NUM_JOINTS, KEYS_PER_CHANNEL);
+            //a tolerance of 1 rad / 1 unit: report the error rather than reject samplers
+            auto report = animation->bake(rate, 1.0f, 1.0f);
+            animation->start();
+
+            auto start = Clock::now();
+            for(int frame = 0; frame < NUM_FRAMES; frame++){
+                animation->update(FRAME_TIME, *skeleton);
+            }
+            double playbackNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+
+            std::mt19937 rng(42);
+            std::uniform_real_distribution<float> seek(0.0f, animation->getDuration());
+            start = Clock::now();
+            for(int i = 0; i < NUM_SEEKS; i++){
+                animation->currentKeyFrameTime = seek(rng);
+                animation->updatePose(*skeleton);
+            }
+            double seekNs = elapsedNs(start, Clock::now()) / NUM_SEEKS;
+
+            LOGI("[bench]   %s %2.0f Hz: playback %8.0f ns/frame, seek %8.0f ns/frame, %zu bytes, error %f rad / %f units",
+                 rate > 0.0f ? "baked" : "authored", rate, playbackNs, seekNs, report.bytesAfter,
+                 report.maxRotationError, report.maxLinearError);
+        }
+    }
+
+    bool validateBatchSampler(){
+        //the batch path blends with a corrected nlerp, the scalar path with glm::slerp
+        constexpr float ROTATION_TOLERANCE = 1e-3f;     //radians
+        constexpr float LINEAR_TOLERANCE = 1e-5f;
+        constexpr int NUM_JOINTS = 60;
+
+        auto skeleton = createChainSkeleton(NUM_JOINTS);
+        auto animation = createSyntheticClip(NUM_JOINTS, 300);
+        PoseBuffer buffer(NUM_JOINTS);
+        Pose& pose = buffer.pose();
+
+        float maxAngle = 0.0f;
+        float maxDistance = 0.0f;
+        std::mt19937 rng(99);
+        std::uniform_real_distribution<float> seek(0.0f, animation->getDuration());
+        for(int i = 0; i < 500; i++){
+            float time = seek(rng);
+            animation->currentKeyFrameTime = time;
+            animation->updatePose(*skeleton);
+            animation->sample(time, *skeleton, pose);
+            for(int joint = 0; joint < NUM_JOINTS; joint++){
+                const auto& expected = skeleton->joints[joint];
+                glm::quat rotation = pose.getRotation(joint);
+                if(glm::dot(rotation, expected.rotation) < 0.0f)
+                    rotation = -rotation;
+                float chord = glm::length(rotation - expected.rotation);
+                maxAngle = std::max(maxAngle, 4.0f * std::asin(std::min(1.0f, chord * 0.5f)));
+                maxDistance = std::max(maxDistance, glm::length(pose.getTranslation(joint) - expected.translation));
+                maxDistance = std::max(maxDistance, glm::length(pose.getScale(joint) - expected.scale));
+            }
+        }
+        bool passed = maxAngle <= ROTATION_TOLERANCE && maxDistance <= LINEAR_TOLERANCE;
+        LOGI("[bench] batch sampler vs scalar path: %f rad, %g units -> %s", maxAngle, maxDistance, verdict(passed));
+        return passed;
+    }
+
+    void runBatchSamplingBenchmark(){
+        constexpr int NUM_JOINTS = 60;
+        constexpr int NUM_FRAMES = 2000;
+
+        auto skeleton = createChainSkeleton(NUM_JOINTS);
+        auto animation = createSyntheticClip(NUM_JOINTS, 300);
+        PoseBuffer buffer(NUM_JOINTS);
+
+        animation->start();
+        auto start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            animation->update(FRAME_TIME, *skeleton);
+        }
+        double scalarNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+
+        float time = 0.0f;
+        start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            time += FRAME_TIME;
+            if(time > animation->getLastKeyFrameTime())
+                time = 0.0f;
+            animation->sample(time, *skeleton, buffer.pose());
+        }
+        double batchNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+        LOGI("[bench] batch sampling: %d joints, scalar %8.0f ns/frame, batch %8.0f ns/frame", NUM_JOINTS, scalarNs, batchNs);
+        validateBatchSampler();
+    }
+
+    void runPosePoolBenchmark(){
+        constexpr int NUM_JOINTS = 60;
+        constexpr int NUM_INSTANCES = 32;
+        constexpr int NUM_FRAMES = 200;
+        constexpr int NUM_THREADS = 4;
+
+        auto skeleton = createChainSkeleton(NUM_JOINTS);
+        auto animation = createSyntheticClip(NUM_JOINTS, 300);
+        //every instance samples the clip at its own time offset into a pose from the frame pool
+        PosePool pool(NUM_JOINTS, NUM_INSTANCES);
+        std::vector<Animation::SamplingState> states(NUM_INSTANCES);
+        const auto& binding = animation->getBinding(*skeleton);
+        auto sampleInstances = [&](int first, int last, int frame){
+            for(int instance = first; instance < last; instance++){
+                Pose pose = pool.acquire();
+                pose.readFrom(*skeleton);
+                float time = std::fmod(frame * FRAME_TIME + instance * 0.37f, animation->getDuration());
+                animation->sample(time, binding, pose, states[instance]);
+            }
+        };
+
+        auto start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            pool.reset();
+            sampleInstances(0, NUM_INSTANCES, frame);
+        }
+        double singleNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+
+        //same work split over worker threads, each with its own instances and sampling states
+        start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            pool.reset();
+            std::vector<std::thread> workers;
+            workers.reserve(NUM_THREADS);
+            for(int t = 0; t < NUM_THREADS; t++){
+                int first = t * NUM_INSTANCES / NUM_THREADS;
+                int last = (t + 1) * NUM_INSTANCES / NUM_THREADS;
+                workers.emplace_back(sampleInstances, first, last, frame);
+            }
+            for(auto& worker : workers){
+                worker.join();
+            }
+        }
+        double threadedNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+        LOGI("[bench] pose pool: %d instances x %d joints, 1 thread %8.0f ns/frame, %d threads %8.0f ns/frame (incl. thread start)",
+             NUM_INSTANCES, NUM_JOINTS, singleNs, NUM_THREADS, threadedNs);
+    }
+
+    void runClipLibraryBenchmark(){
+        constexpr int NUM_JOINTS = 60;
+        constexpr int NUM_BREEDS = 20;
+        constexpr int NUM_CLIPS = 6;
+
+        //every breed uses the same joint names, bone lengths differ per breed
+        auto source = createChainSkeleton(NUM_JOINTS);
+        ClipLibrary library;
+        size_t perBreedBytes = 0;
+        //clips are named after their key count, so vary it to get distinct clips
+        const std::string clipSet = "chain";
+        for(int clip = 0; clip < NUM_CLIPS; clip++){
+            auto animation = createSyntheticClip(NUM_JOINTS, 300 + clip);
+            perBreedBytes += animation->getMemoryUsage();
+            library.add(clipSet, animation, *source);
+        }
+
+        size_t instanceBytes = 0;
+        auto start = Clock::now();
+        std::vector<std::shared_ptr<Animation>> instances;
+        for(int breed = 1; breed < NUM_BREEDS; breed++){
+            auto target = createChainSkeleton(NUM_JOINTS);
+            for(auto& joint : target->joints){
+                joint.translation *= 1.0f + 0.05f * static_cast<float>(breed);
+            }
+            for(int clip = 0; clip < NUM_CLIPS; clip++){
+                auto instance = library.instantiate(clipSet, "benchmark_" + std::to_string(300 + clip), *target);
+                if(instance){
+                    instanceBytes += sizeof(Animation) + instance->channels.capacity() * sizeof(Animation::Channel) +
+                                     instance->channelRemaps.capacity() * sizeof(Animation::ChannelRemap) +
+                                     instance->samplers.capacity() * sizeof(Animation::Sampler);
+                    instances.push_back(instance);
+                }
+            }
+        }
+        double bindNs = elapsedNs(start, Clock::now()) / static_cast<double>(std::max<size_t>(1, instances.size()));
+
+        //an instance bound to an identical skeleton must reproduce the source clip exactly
+        auto reference = createSyntheticClip(NUM_JOINTS, 300);
+        auto copy = library.instantiate(clipSet, reference->getName(), *source);
+        //a clip of the same name from another clip set must not get the registered one
+        bool keptApart = !library.instantiate("other", reference->getName(), *source) && !library.contains("other", reference->getName());
+        auto expected = createChainSkeleton(NUM_JOINTS);
+        auto actual = createChainSkeleton(NUM_JOINTS);
+        float maxDifference = 0.0f;
+        for(int i = 0; copy && i < 100; i++){
+            float time = static_cast<float>(i) * 0.097f;
+            reference->currentKeyFrameTime = time;
+            copy->currentKeyFrameTime = time;
+            reference->updatePose(*expected);
+            copy->updatePose(*actual);
+            for(int joint = 0; joint < NUM_JOINTS; joint++){
+                maxDifference = std::max(maxDifference, glm::length(expected->joints[joint].translation - actual->joints[joint].translation));
+                maxDifference = std::max(maxDifference, std::abs(1.0f - std::abs(glm::dot(expected->joints[joint].rotation, actual->joints[joint].rotation))));
+            }
+        }
+        LOGI("[bench] clip library: %d breeds x %d clips, without library %zu bytes, with library %zu + %zu bytes, %.0f ns per bind",
+             NUM_BREEDS, NUM_CLIPS, perBreedBytes * NUM_BREEDS, library.getMemoryUsage(), instanceBytes, bindNs);
+        LOGI("[bench]   identity retarget difference %g -> %s", maxDifference, verdict(copy && maxDifference < 1e-5f));
+        LOGI("[bench]   same name, other clip set: %s -> %s", keptApart ? "not shared" : "shared", verdict(keptApart));
+    }
+
+    void runSamplerDedupBenchmark(){
+        constexpr int NUM_JOINTS = 60;
+        constexpr int NUM_MODELS = 5;
+
+        //synthetic clips are deterministic, so every model after the first hits the store for every sampler
+        auto before = SamplerStore::global().getStats();
+        std::vector<std::shared_ptr<Animation>> clips;
+        size_t rawBytes = 0;
+        auto start = Clock::now();
+        for(int model = 0; model < NUM_MODELS; model++){
+            auto clip = createSyntheticClip(NUM_JOINTS, 300);
+            rawBytes += clip->getMemoryUsage();
+            for(auto& sampler : clip->samplers){
+                sampler.share();
+            }
+            clips.push_back(clip);
+        }
+        double internMs = elapsedNs(start, Clock::now()) * 1e-6;
+        auto after = SamplerStore::global().getStats();
+        LOGI("[bench] sampler dedup: %d models x %zu samplers, %zu hits, %zu of %zu bytes saved, interning took %.2f ms",
+             NUM_MODELS, clips.front()->samplers.size(), after.hits - before.hits,
+             after.bytesSaved - before.bytesSaved, rawBytes, internMs);
+    }
+
+    void runKeyReductionBenchmark(){
+        constexpr int NUM_JOINTS = 60;
+        constexpr int KEYS_PER_CHANNEL = 600;
+        constexpr int NUM_FRAMES = 2000;
+        constexpr int NUM_SEEKS = 500;
+
+        //exported motion is mostly smooth curves sampled per frame, the random walk clip is the worst case
+        auto createSmoothClip = [](){
+            auto animation = createSyntheticClip(NUM_JOINTS, KEYS_PER_CHANNEL);
+            for(size_t index = 0; index < animation->channels.size(); index++){
+                auto& channel = animation->channels[index];
+                auto& sampler = animation->samplers[channel.samplerIndex];
+                float phase = static_cast<float>(channel.node) * 0.3f;
+                for(size_t key = 0; key < sampler.timeStamps.size(); key++){
+                    float t = sampler.timeStamps[key];
+                    glm::vec4 value(1.0f, 1.0f, 1.0f, 0.0f);
+                    if(channel.pathType == Animation::PathType::ROTATION){
+                        glm::quat q = glm::angleAxis(0.4f * std::sin(1.7f * t + phase), glm::normalize(glm::vec3(1.0f, 0.5f, 0.2f)));
+                        value = glm::vec4(q.x, q.y, q.z, q.w);
+                    }else if(channel.pathType == Animation::PathType::TRANSLATION){
+                        value = glm::vec4(0.0f, 0.1f + 0.02f * std::sin(2.3f * t + phase), 0.0f, 0.0f);
+                    }
+                    sampler.TRSoutputValues[key] = value;
+                }
+            }
+            return animation;
+        };
+
+        Animation::ReductionSettings settings;
+        LOGI("[bench] key reduction: %d joints, %d keys/channel, tolerance %g rad / %g units",
+             NUM_JOINTS, KEYS_PER_CHANNEL, settings.maxAngularError, settings.maxDistanceError);
+        for(int smooth = 1; smooth >= 0; smooth--){
+            auto skeleton = createChainSkeleton(NUM_JOINTS);
+            auto original = smooth ? createSmoothClip() : createSyntheticClip(NUM_JOINTS, KEYS_PER_CHANNEL);
+            auto reduced = smooth ? createSmoothClip() : createSyntheticClip(NUM_JOINTS, KEYS_PER_CHANNEL);
+            auto report = reduced->reduceKeys(*skeleton, settings);
+
+            reduced->start();
+            auto start = Clock::now();
+            for(int frame = 0; frame < NUM_FRAMES; frame++){
+                reduced->update(FRAME_TIME, *skeleton);
+            }
+            double playbackNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+
+            //error in model space, where a reduced root rotation shows up at the end of the chain
+            auto expectedSkeleton = createChainSkeleton(NUM_JOINTS);
+            float maxDistance = 0.0f;
+            std::mt19937 rng(7);
+            std::uniform_real_distribution<float> seek(0.0f, original->getDuration());
+            for(int i = 0; i < NUM_SEEKS; i++){
+                float time = seek(rng);
+                original->currentKeyFrameTime = time;
+                original->updatePose(*expectedSkeleton);
+                expectedSkeleton->update();
+                reduced->currentKeyFrameTime = time;
+                reduced->updatePose(*skeleton);
+                skeleton->update();
+                for(int joint = 0; joint < NUM_JOINTS; joint++){
+                    glm::vec3 expected(expectedSkeleton->jointMatrices[joint][3]);
+                    glm::vec3 actual(skeleton->jointMatrices[joint][3]);
+                    maxDistance = std::max(maxDistance, glm::length(expected - actual));
+                }
+            }
+            LOGI("[bench]   %s: %zu -> %zu keys, %zu -> %zu bytes, playback %8.0f ns/frame, max joint drift %g units",
+                 smooth ? "smooth curves" : "random walk", report.keysBefore, report.keysAfter,
+                 report.bytesBefore, report.bytesAfter, playbackNs, maxDistance);
+        }
+    }
+
+    void runAnimationLodBenchmark(){
+        constexpr int NUM_JOINTS = 60;
+        constexpr int NUM_INSTANCES = 32;
+        //long enough to wrap the 10 s clip once
+        constexpr int NUM_FRAMES = 700;
+
+        //one model: the instances share its clip and rig and keep their clock, LOD state and pose, like
+        //objects created with VeGameObject::createAnimatedObject
+        auto skeleton = createChainSkeleton(NUM_JOINTS);
+        //the last third of the chain stands in for ears and tail
+        skeleton->setLodMask({"joint_" + std::to_string(NUM_JOINTS * 2 / 3)});
+        auto animation = createSyntheticClip(NUM_JOINTS, 300);
+        auto reference = createChainSkeleton(NUM_JOINTS);
+        auto referenceAnimation = createSyntheticClip(NUM_JOINTS, 300);
+        animation->start();
+        struct Instance{
+            float time = 0.0f;
+            PoseBuffer pose;
+            AnimationLodState lod;
+            bool changed = false;
+        };
+        std::vector<Instance> instances(NUM_INSTANCES);
+
+        const AnimationLodLevel levels[] = {
+            {0.0f, 0.0f, false},
+            {0.0f, 30.0f, false},
+            {0.0f, 15.0f, false},
+            {0.0f, 15.0f, true},
+        };
+        LOGI("[bench] animation LOD: %d instances x %d joints, %d masked", NUM_INSTANCES, NUM_JOINTS,
+             static_cast<int>(std::count(skeleton->lodMask.begin(), skeleton->lodMask.end(), 1)));
+        for(int level = -1; level < 4; level++){
+            const AnimationLodLevel* lod = level < 0 ? nullptr : &levels[level];
+            //instance 0 plays in step with the reference, the others are spread over the clip
+            for(int i = 0; i < NUM_INSTANCES; i++){
+                auto& instance = instances[i];
+                instance.time = animation->getDuration() * static_cast<float>(i) / NUM_INSTANCES;
+                instance.pose.resize(NUM_JOINTS);
+                instance.pose.pose().readFrom(*skeleton);
+                instance.lod.reset();
+            }
+            referenceAnimation->currentKeyFrameTime = 0.0f;
+            referenceAnimation->start();
+            double samplingNs = 0.0;
+            double matrixNs = 0.0;
+            float maxAngle = 0.0f;
+            float wrapAngle = 0.0f;
+            int sinceWrap = NUM_FRAMES;
+            for(int frame = 0; frame < NUM_FRAMES; frame++){
+                auto start = Clock::now();
+                for(auto& instance : instances){
+                    float step = animation->playbackStep(FRAME_TIME);
+                    instance.time = animation->wrapTime(instance.time + step);
+                    instance.changed = instance.lod.update(FRAME_TIME, *animation, instance.time, step, *skeleton, instance.pose.pose(), lod);
+                }
+                auto sampled = Clock::now();
+                //the model's skeleton composes each changed pose in turn
+                for(auto& instance : instances){
+                    if(instance.changed){
+                        instance.pose.pose().writeTo(*skeleton);
+                        skeleton->update();
+                    }
+                }
+                samplingNs += elapsedNs(start, sampled);
+                matrixNs += elapsedNs(sampled, Clock::now());
+                //error of the first instance against full rate playback, masked joints excluded
+                const Pose& pose = instances[0].pose.pose();
+                float referenceTime = referenceAnimation->currentKeyFrameTime;
+                referenceAnimation->update(FRAME_TIME, *reference);
+                sinceWrap = referenceAnimation->currentKeyFrameTime < referenceTime ? 0 : sinceWrap + 1;
+                if(!lod)
+                    continue;
+                for(int joint = 0; joint < NUM_JOINTS; joint++){
+                    if(!skeleton->lodMask[joint] || !lod->skipMaskedJoints){
+                        glm::quat a = reference->joints[joint].rotation;
+                        glm::quat b = pose.getRotation(joint);
+                        if(glm::dot(a, b) < 0.0f)
+                            b = -b;
+                        float angle = 4.0f * std::asin(std::min(1.0f, glm::length(a - b) * 0.5f));
+                        maxAngle = std::max(maxAngle, angle);
+                        //the frames of one 15 Hz interval after the clip wrapped
+                        if(sinceWrap < 4)
+                            wrapAngle = std::max(wrapAngle, angle);
+                    }
+                }
+            }
+            if(!lod){
+                LOGI("[bench]   frozen:           sampling %8.0f ns/frame, matrices %8.0f ns/frame", samplingNs / NUM_FRAMES, matrixNs / NUM_FRAMES);
+            }else{
+                LOGI("[bench]   %2.0f Hz %s: sampling %8.0f ns/frame, matrices %8.0f ns/frame, max rotation error vs full rate %f rad, %f rad at the wrap",
+                     lod->updateRate > 0.0f ? lod->updateRate : 60.0f, lod->skipMaskedJoints ? "masked    " : "all joints",
+                     samplingNs / NUM_FRAMES, matrixNs / NUM_FRAMES, maxAngle, wrapAngle);
+            }
+        }
+    }
+
+    void runHierarchyBenchmark(){
+        constexpr int NUM_SKELETONS = 64;
+        constexpr int NUM_FRAMES = 200;
+
+        //branching rig: a spine with a few limbs of branchLength joints hanging off every fourth spine joint
+        auto createBranchingSkeleton = [](int spineLength, int branchLength){
+            auto skeleton = createChainSkeleton(spineLength);
+            for(int spine = 0; spine < spineLength; spine += 4){
+                int parent = spine;
+                for(int i = 0; i < branchLength; i++){
+                    int index = static_cast<int>(skeleton->joints.size());
+                    Joint joint;
+                    joint.name = "branch_" + std::to_string(index);
+                    joint.parentIndex = parent;
+                    joint.inverseBindMatrix = glm::mat4(1.0f);
+                    joint.translation = glm::vec3(0.05f, 0.0f, 0.0f);
+                    skeleton->joints[parent].childrenIndices.push_back(index);
+                    skeleton->joints.push_back(joint);
+                    parent = index;
+                }
+            }
+            skeleton->jointMatrices.resize(skeleton->joints.size());
+            return skeleton;
+        };
+        const std::pair<const char*, std::function<std::unique_ptr<Skeleton>()>> rigs[] = {
+            {"chain 60", []{return createChainSkeleton(60);}},
+            {"chain 250", []{return createChainSkeleton(250);}},
+            {"branching", [&]{return createBranchingSkeleton(32, 6);}},
+        };
+        for(const auto& rig : rigs){
+            std::vector<std::unique_ptr<Skeleton>> skeletons;
+            std::mt19937 rng(5);
+            std::uniform_real_distribution<float> angle(-0.5f, 0.5f);
+            for(int i = 0; i < NUM_SKELETONS; i++){
+                skeletons.push_back(rig.second());
+                for(auto& joint : skeletons.back()->joints)
+                    joint.rotation = glm::angleAxis(angle(rng), glm::normalize(glm::vec3(1.0f, 2.0f, 0.5f)));
+            }
+            size_t numJoints = skeletons[0]->joints.size();
+
+            auto start = Clock::now();
+            for(int frame = 0; frame < NUM_FRAMES; frame++){
+                for(auto& skeleton : skeletons)
+                    skeleton->updateRecursive();
+            }
+            double recursiveNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+            std::vector<glm::mat4> expected = skeletons[0]->jointMatrices;
+
+            start = Clock::now();
+            for(int frame = 0; frame < NUM_FRAMES; frame++){
+                for(auto& skeleton : skeletons)
+                    skeleton->update();
+            }
+            double flatNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+
+            float maxDifference = 0.0f;
+            for(size_t joint = 0; joint < numJoints; joint++){
+                for(int c = 0; c < 4; c++){
+                    glm::vec4 difference = glm::abs(expected[joint][c] - skeletons[0]->jointMatrices[joint][c]);
+                    maxDifference = std::max(maxDifference, std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)));
+                }
+            }
+            LOGI("[bench] hierarchy %s (%zu joints) x %d: recursive %8.0f ns/frame, flat %8.0f ns/frame, difference %g -> %s",
+                 rig.first, numJoints, NUM_SKELETONS, recursiveNs, flatNs, maxDifference,
+                 verdict(skeletons[0]->isTopological && maxDifference <= 1e-5f));
+        }
+    }
+
+    void runDirtyUpdateBenchmark(){
+        constexpr int NUM_JOINTS = 250;
+        constexpr int NUM_EDITS = 2000;
+        const int editedJoints[] = {NUM_JOINTS - 5, NUM_JOINTS / 2, 0};
+
+        auto skeleton = createChainSkeleton(NUM_JOINTS);
+        auto reference = createChainSkeleton(NUM_JOINTS);
+        skeleton->update();
+        LOGI("[bench] dirty subtree update: chain of %d joints", NUM_JOINTS);
+        for(int edited : editedJoints){
+            auto& joint = skeleton->joints[edited];
+            auto start = Clock::now();
+            for(int i = 0; i < NUM_EDITS; i++){
+                joint.rotation = glm::angleAxis(0.001f * static_cast<float>(i), glm::vec3(0.0f, 0.0f, 1.0f));
+                skeleton->update();
+            }
+            double fullNs = elapsedNs(start, Clock::now()) / NUM_EDITS;
+            start = Clock::now();
+            for(int i = 0; i < NUM_EDITS; i++){
+                joint.rotation = glm::angleAxis(0.002f * static_cast<float>(i), glm::vec3(0.0f, 0.0f, 1.0f));
+                skeleton->markDirty(edited);
+                skeleton->updateDirty();
+            }
+            double dirtyNs = elapsedNs(start, Clock::now()) / NUM_EDITS;
+
+            //the incremental result has to match a full update of the same pose
+            reference->joints[edited].rotation = joint.rotation;
+            reference->update();
+            float maxDifference = 0.0f;
+            for(int j = 0; j < NUM_JOINTS; j++){
+                for(int c = 0; c < 4; c++){
+                    glm::vec4 difference = glm::abs(reference->jointMatrices[j][c] - skeleton->jointMatrices[j][c]);
+                    maxDifference = std::max(maxDifference, std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)));
+                }
+            }
+            reference->joints[edited].rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+            joint.rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+            skeleton->markDirty(edited);
+            skeleton->updateDirty();
+            LOGI("[bench]   edit joint %3d (%3u joint subtree): full %8.0f ns, dirty %8.0f ns, difference %g -> %s",
+                 edited, skeleton->subtreeEnd[edited] - edited, fullNs, dirtyNs, maxDifference, verdict(maxDifference <= 1e-5f));
+        }
+    }
+
+    void runSkeletonInstanceBenchmark(){
+        constexpr int NUM_JOINTS = 60;
+        constexpr int NUM_INSTANCES = 32;
+        constexpr int NUM_FRAMES = 200;
+
+        auto skeletonBytes = [](const Skeleton& skeleton){
+            size_t bytes = sizeof(Skeleton) + skeleton.joints.capacity() * sizeof(Joint);
+            for(const auto& joint : skeleton.joints)
+                bytes += joint.name.capacity() + joint.childrenIndices.capacity() * sizeof(int);
+            bytes += skeleton.jointMatrices.capacity() * sizeof(glm::mat4) * 2;   //palette and model space
+            bytes += skeleton.nodeJointMap.size() * (sizeof(std::pair<const int, int>) + 4 * sizeof(void*));
+            bytes += skeleton.parentIndices.capacity() * sizeof(int16_t) + skeleton.subtreeEnd.capacity() * sizeof(uint32_t);
+            return bytes;
+        };
+
+        //one skeleton per dog, as when every object loads its own model
+        std::vector<std::unique_ptr<Skeleton>> copies;
+        size_t copyBytes = 0;
+        for(int i = 0; i < NUM_INSTANCES; i++){
+            copies.push_back(createChainSkeleton(NUM_JOINTS));
+            copies.back()->update();
+            copyBytes += skeletonBytes(*copies.back());
+        }
+        //one shared rig, a pose and a palette per dog
+        auto definition = SkeletonDefinition::create(*copies[0]);
+        SkeletonInstancePool pool(definition, NUM_INSTANCES);
+        std::vector<SkeletonInstancePool::Handle> instances;
+        for(int i = 0; i < NUM_INSTANCES; i++)
+            instances.push_back(pool.acquire());
+        size_t instanceBytes = definition->getMemoryUsage() + pool.getMemoryUsage();
+
+        auto animation = createSyntheticClip(NUM_JOINTS, 300);
+        Animation::SamplingState state;
+        float duration = animation->getDuration();
+        auto start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            for(int i = 0; i < NUM_INSTANCES; i++){
+                animation->currentKeyFrameTime = std::fmod(frame * FRAME_TIME + i * 0.1f, duration);
+                animation->updatePose(*copies[i]);
+                copies[i]->update();
+            }
+        }
+        double copyNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+        const auto& binding = animation->getBinding(*definition);
+        start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            for(int i = 0; i < NUM_INSTANCES; i++){
+                animation->sample(std::fmod(frame * FRAME_TIME + i * 0.1f, duration), binding, instances[i]->local, state);
+                instances[i]->updatePalette();
+            }
+        }
+        double instanceNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+
+        //both paths ended on the same clip times, the palettes have to agree
+        float maxDifference = 0.0f;
+        for(int i = 0; i < NUM_INSTANCES; i++){
+            for(int joint = 0; joint < NUM_JOINTS; joint++){
+                for(int c = 0; c < 4; c++){
+                    glm::vec4 difference = glm::abs(copies[i]->jointMatrices[joint][c] - instances[i]->palette[joint][c]);
+                    maxDifference = std::max(maxDifference, std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)));
+                }
+            }
+        }
+        bool passed = maxDifference <= 1e-3f;
+        LOGI("[bench] skeleton instances: %d x %d joints, skeleton copies %zu bytes %8.0f ns/frame, shared rig %zu bytes %8.0f ns/frame, palette difference %g -> %s",
+             NUM_INSTANCES, NUM_JOINTS, copyBytes, copyNs, instanceBytes, instanceNs, maxDifference, verdict(passed));
+    }
+
+    void runTwoBoneIKBenchmark(){
+        constexpr int NUM_TARGETS = 256;
+        constexpr int NUM_FRAMES = 20000;
+
+        auto scalar = createQuadrupedSkeleton();
+        auto batch = createQuadrupedSkeleton();
+        scalar->update();
+        batch->update();
+        TwoBoneChain chains[4];
+        glm::vec3 restPaws[4];
+        for(int leg = 0; leg < 4; leg++){
+            chains[leg] = twoBoneIK::findChain(*scalar, "paw_" + std::to_string(leg));
+            restPaws[leg] = glm::vec3(scalar->getModelMatrix(chains[leg].end)[3]);
+        }
+        std::vector<glm::quat> sampled(scalar->joints.size());
+        for(size_t j = 0; j < sampled.size(); j++)
+            sampled[j] = scalar->joints[j].rotation;
+        //reachable paw targets around the rest stance: lifted, shifted, knees pointing forward
+        std::mt19937 rng(99);
+        std::uniform_real_distribution<float> shift(-0.06f, 0.06f);
+        std::uniform_real_distribution<float> lift(0.02f, 0.15f);
+        std::vector<TwoBoneGoal> goals(NUM_TARGETS * 4);
+        for(int i = 0; i < NUM_TARGETS; i++){
+            for(int leg = 0; leg < 4; leg++){
+                auto& goal = goals[i * 4 + leg];
+                goal.target = restPaws[leg] + glm::vec3(shift(rng), lift(rng), shift(rng));
+                goal.pole = glm::vec3(scalar->getModelMatrix(chains[leg].mid)[3]) + glm::vec3(0.0f, 0.0f, 1.0f);
+            }
+        }
+
+        //both paths solve the same targets in the same order, poses have to stay identical
+        float maxError = 0.0f;
+        float maxDifference = 0.0f;
+        for(int i = 0; i < NUM_TARGETS; i++){
+            const TwoBoneGoal* frameGoals = goals.data() + i * 4;
+            for(int leg = 0; leg < 4; leg++)
+                twoBoneIK::solve(*scalar, chains[leg], frameGoals[leg]);
+            twoBoneIK::solveBatch(*batch, chains, frameGoals, 4);
+            scalar->updateDirty();
+            batch->updateDirty();
+            for(int leg = 0; leg < 4; leg++){
+                glm::vec3 scalarPaw(scalar->getModelMatrix(chains[leg].end)[3]);
+                glm::vec3 batchPaw(batch->getModelMatrix(chains[leg].end)[3]);
+                maxError = std::max(maxError, glm::length(scalarPaw - frameGoals[leg].target));
+                maxError = std::max(maxError, glm::length(batchPaw - frameGoals[leg].target));
+                maxDifference = std::max(maxDifference, glm::length(scalarPaw - batchPaw));
+            }
+        }
+
+        //solve cost only: every frame starts from the sampled pose again, so the model matrices stay valid
+        auto restore = [&](Skeleton& skeleton){
+            for(const auto& chain : chains){
+                skeleton.joints[chain.root].rotation = sampled[chain.root];
+                skeleton.joints[chain.mid].rotation = sampled[chain.mid];
+            }
+        };
+        restore(*scalar);
+        restore(*batch);
+        scalar->update();
+        batch->update();
+        auto start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            const TwoBoneGoal* frameGoals = goals.data() + (frame % NUM_TARGETS) * 4;
+            restore(*scalar);
+            for(int leg = 0; leg < 4; leg++)
+                twoBoneIK::solve(*scalar, chains[leg], frameGoals[leg]);
+        }
+        double scalarNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+        start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            restore(*batch);
+            twoBoneIK::solveBatch(*batch, chains, goals.data() + (frame % NUM_TARGETS) * 4, 4);
+        }
+        double batchNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+        //and the same with the refresh of the legs' matrices a frame needs afterwards
+        start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            restore(*batch);
+            twoBoneIK::solveBatch(*batch, chains, goals.data() + (frame % NUM_TARGETS) * 4, 4);
+            batch->updateDirty();
+        }
+        double refreshNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+
+        bool passed = maxError <= 1e-3f && maxDifference <= 1e-3f;
+        LOGI("[bench] two bone IK: 4 legs, scalar %5.0f ns (%5.2f M solves/s), simd %5.0f ns (%5.2f M solves/s), simd + updateDirty %5.0f ns, paw error %g, scalar/simd difference %g -> %s",
+             scalarNs, 4000.0 / scalarNs, batchNs, 4000.0 / batchNs, refreshNs, maxError, maxDifference, verdict(passed));
+    }
+
+    void runFabrikBenchmark(){
+        constexpr int NUM_JOINTS = 12;
+        constexpr int NUM_FRAMES = 600;
+        constexpr float TOLERANCE = 1e-3f;
+
+        auto skeleton = createChainSkeleton(NUM_JOINTS);
+        skeleton->update();
+        LOGI("[bench] FABRIK: chain of %d joints, %d frames, target moving at 1 rad/s", NUM_JOINTS, NUM_FRAMES);
+        for(bool warmStart : {false, true}){
+            FabrikSolver solver;
+            solver.init(*skeleton, 0, NUM_JOINTS - 1);
+            FabrikSettings settings;
+            settings.tolerance = TOLERANCE;
+            settings.warmStart = warmStart;
+            int totalIterations = 0;
+            int maxIterations = 0;
+            uint64_t totalNs = 0;
+            float maxError = 0.0f;
+            for(int frame = 0; frame < NUM_FRAMES; frame++){
+                //the sampled pose: a straight chain every frame
+                for(auto& joint : skeleton->joints)
+                    joint.rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+                skeleton->update();
+                float angle = frame * FRAME_TIME;
+                glm::vec3 target(0.4f + 0.3f * std::cos(angle), 0.5f + 0.3f * std::sin(angle), 0.15f * std::sin(angle));
+                const auto& stats = solver.solve(*skeleton, target, settings);
+                totalIterations += stats.iterations;
+                maxIterations = std::max(maxIterations, stats.iterations);
+                totalNs += stats.nanoseconds;
+                //the rotations written back have to put the effector where the solver did
+                skeleton->updateDirty();
+                glm::vec3 effector(skeleton->getModelMatrix(NUM_JOINTS - 1)[3]);
+                if(frame > 0)
+                    maxError = std::max(maxError, glm::length(effector - target));
+            }
+            float averageIterations = static_cast<float>(totalIterations) / NUM_FRAMES;
+            //warm starting has to settle on one or two iterations per frame
+            bool passed = maxError <= 2.0f * TOLERANCE && (!warmStart || averageIterations <= 2.0f);
+            LOGI("[bench]   %s start: %5.2f iterations/solve (max %2d), %6.0f ns/solve, effector error %g -> %s",
+                 warmStart ? "warm" : "cold", averageIterations, maxIterations, static_cast<double>(totalNs) / NUM_FRAMES, maxError, verdict(passed));
+        }
+    }
+
+    void runCCDBenchmark(){
+        constexpr int NUM_JOINTS = 10;
+        constexpr int NUM_TARGETS = 500;
+        const float MAX_SWING = glm::radians(25.0f);
+        const float MAX_TWIST = glm::radians(10.0f);
+        constexpr float TOLERANCE = 5e-3f;
+
+        auto skeleton = createChainSkeleton(NUM_JOINTS);
+        for(int i = 0; i < NUM_JOINTS; i++)
+            skeleton->setJointLimit(i, MAX_SWING, MAX_TWIST, 0.8f);
+        //targets the limited chain can reach: effector positions of random curls inside the limits
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<glm::vec3> targets(NUM_TARGETS);
+        for(auto& target : targets){
+            glm::vec3 curl = glm::normalize(glm::vec3(unit(rng), 0.0f, unit(rng)) + glm::vec3(1e-3f, 0.0f, 0.0f));
+            for(auto& joint : skeleton->joints){
+                glm::vec3 axis = glm::normalize(curl + 0.3f * glm::vec3(unit(rng), 0.0f, unit(rng)));
+                joint.rotation = glm::angleAxis(MAX_SWING * (0.6f + 0.3f * unit(rng)), axis);
+            }
+            skeleton->update();
+            target = glm::vec3(skeleton->getModelMatrix(NUM_JOINTS - 1)[3]);
+        }
+        //every solve starts from the same slightly bent animated pose
+        const glm::quat sampled = glm::angleAxis(glm::radians(5.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+
+        LOGI("[bench] CCD: chain of %d joints, swing %.0f deg, twist %.0f deg, %d reachable targets, tolerance %g", NUM_JOINTS,
+             glm::degrees(MAX_SWING), glm::degrees(MAX_TWIST), NUM_TARGETS, TOLERANCE);
+        CCDSolver solver;
+        solver.init(*skeleton, 0, NUM_JOINTS - 1);
+        for(bool useLimits : {false, true}){
+            CCDSettings settings;
+            settings.tolerance = TOLERANCE;
+            settings.useLimits = useLimits;
+            int totalIterations = 0;
+            int converged = 0;
+            int violations = 0;
+            uint64_t totalNs = 0;
+            for(const auto& target : targets){
+                for(auto& joint : skeleton->joints)
+                    joint.rotation = sampled;
+                skeleton->update();
+                const auto& stats = solver.solve(*skeleton, target, settings);
+                totalIterations += stats.iterations;
+                converged += stats.converged ? 1 : 0;
+                totalNs += stats.nanoseconds;
+                //a joint is outside its limit when clamping would move it noticeably
+                for(int i = 0; i < NUM_JOINTS; i++){
+                    glm::quat clamped = skeleton->joints[i].rotation;
+                    skeleton->jointLimits[i].clamp(clamped);
+                    if(std::abs(glm::dot(clamped, skeleton->joints[i].rotation)) < 1.0f - 1e-5f)
+                        violations++;
+                }
+            }
+            float convergedRatio = static_cast<float>(converged) / NUM_TARGETS;
+            //the limited solver must never leave a joint outside its limits and still reach nearly every target
+            bool passed = !useLimits || (violations == 0 && convergedRatio >= 0.9f);
+            LOGI("[bench]   %s: %5.2f iterations/solve, %6.0f ns/solve, %5.1f%% converged, %d joints outside limits%s%s",
+                 useLimits ? "limited  " : "unlimited", static_cast<float>(totalIterations) / NUM_TARGETS, static_cast<double>(totalNs) / NUM_TARGETS,
+                 convergedRatio * 100.0f, violations, useLimits ? " -> " : "", useLimits ? verdict(passed) : "");
+        }
+    }
+
+    void runDLSBenchmark(){
+        constexpr int NUM_TARGETS = 300;
+        constexpr float TOLERANCE = 2e-3f;
+
+        auto skeleton = createQuadrupedSkeleton();
+        skeleton->update();
+        auto find = [&](const std::string& name){
+            for(size_t i = 0; i < skeleton->joints.size(); i++){
+                if(skeleton->joints[i].name == name)
+                    return static_cast<int>(i);
+            }
+            return -1;
+        };
+        std::vector<IKEffector> effectors;
+        for(int leg = 0; leg < 4; leg++)
+            effectors.push_back({find("paw_" + std::to_string(leg)), 1.0f});
+        effectors.push_back({find("head"), 1.0f});
+        int pelvis = find("pelvis");
+        DLSSolver solver;
+        solver.init(*skeleton, effectors, pelvis);
+        //the body stays where the animation put it
+        solver.setJointWeight(pelvis, 0.0f);
+
+        //reachable targets: effector positions of random poses of the joints between pelvis and effectors
+        std::vector<glm::quat> rest(skeleton->joints.size());
+        for(size_t j = 0; j < rest.size(); j++)
+            rest[j] = skeleton->joints[j].rotation;
+        std::vector<bool> moved(skeleton->joints.size(), false);
+        for(const auto& effector : effectors){
+            for(int joint = skeleton->joints[effector.joint].parentIndex; joint != pelvis; joint = skeleton->joints[joint].parentIndex)
+                moved[joint] = true;
+        }
+        std::mt19937 rng(17);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<glm::vec3> targets(NUM_TARGETS * effectors.size());
+        for(int i = 0; i < NUM_TARGETS; i++){
+            for(size_t j = 0; j < rest.size(); j++){
+                glm::vec3 axis = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+                skeleton->joints[j].rotation = moved[j] ? glm::angleAxis(glm::radians(20.0f) * unit(rng), axis) : rest[j];
+            }
+            skeleton->update();
+            for(size_t e = 0; e < effectors.size(); e++)
+                targets[i * effectors.size() + e] = glm::vec3(skeleton->getModelMatrix(effectors[e].joint)[3]);
+        }
+
+        DLSSettings settings;
+        settings.tolerance = TOLERANCE;
+        int totalIterations = 0;
+        int converged = 0;
+        bool untouched = true;
+        uint64_t totalNs = 0;
+        float maxError = 0.0f;
+        for(int i = 0; i < NUM_TARGETS; i++){
+            for(size_t j = 0; j < rest.size(); j++)
+                skeleton->joints[j].rotation = rest[j];
+            skeleton->update();
+            const auto& stats = solver.solve(*skeleton, targets.data() + i * effectors.size(), settings);
+            totalIterations += stats.iterations;
+            converged += stats.converged ? 1 : 0;
+            totalNs += stats.nanoseconds;
+            maxError = std::max(maxError, stats.error);
+            //joints outside the effector chains and the zero weight pelvis keep the animated pose
+            for(size_t j = 0; j < rest.size(); j++){
+                if(!moved[j] && skeleton->joints[j].rotation != rest[j])
+                    untouched = false;
+            }
+            skeleton->updateDirty();
+        }
+        size_t activeJoints = solver.getActiveJointCount();
+        float convergedRatio = static_cast<float>(converged) / NUM_TARGETS;
+        bool passed = untouched && convergedRatio >= 0.95f;
+        LOGI("[bench] DLS IK: %zu effectors on %zu joints, %zu active joints, %zu of %zu Jacobian blocks, %5.2f iterations/solve, %6.0f ns/solve, %5.1f%% within %g (max error %g), other joints untouched %s -> %s",
+             effectors.size(), skeleton->joints.size(), activeJoints, solver.getJacobianBlockCount(), activeJoints * effectors.size(),
+             static_cast<float>(totalIterations) / NUM_TARGETS, static_cast<double>(totalNs) / NUM_TARGETS, convergedRatio * 100.0f, TOLERANCE, maxError,
+             untouched ? "yes" : "no", verdict(passed));
+    }
+
+    void runFootPlacementBenchmark(){
+        constexpr int GRID = 128;
+        constexpr float TERRAIN_SIZE = 100.0f;
+        constexpr int NUM_DOGS = 256;
+        constexpr int NUM_FRAMES = 120;
+        constexpr int NUM_REPEATS = 50;
+
+        //rolling heightfield like the scaled ground quad with some relief, GRID x GRID cells
+        auto height = [](float x, float z){return 0.08f * std::sin(x * 1.3f) * std::cos(z * 0.9f) + 0.04f * std::sin(z * 2.7f + 1.0f);};
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        for(int z = 0; z <= GRID; z++){
+            for(int x = 0; x <= GRID; x++){
+                float px = (static_cast<float>(x) / GRID - 0.5f) * TERRAIN_SIZE;
+                float pz = (static_cast<float>(z) / GRID - 0.5f) * TERRAIN_SIZE;
+                positions.emplace_back(px, height(px, pz), pz);
+            }
+        }
+        for(int z = 0; z < GRID; z++){
+            for(int x = 0; x < GRID; x++){
+                uint32_t corner = static_cast<uint32_t>(z * (GRID + 1) + x);
+                for(uint32_t index : {corner, corner + GRID + 1, corner + 1, corner + 1, corner + GRID + 1, corner + GRID + 2})
+                    indices.push_back(index);
+            }
+        }
+        CollisionBVH collision;
+        auto start = Clock::now();
+        collision.addTriangles(positions, indices, glm::mat4(1.0f));
+        collision.build();
+        double buildMs = elapsedNs(start, Clock::now()) / 1e6;
+
+        //four paw rays per dog, dogs scattered over the terrain
+        auto skeleton = createQuadrupedSkeleton();
+        skeleton->update();
+        std::mt19937 rng(18);
+        std::uniform_real_distribution<float> place(-0.45f * TERRAIN_SIZE, 0.45f * TERRAIN_SIZE);
+        std::vector<glm::mat4> dogs(NUM_DOGS);
+        for(auto& dog : dogs){
+            dog = glm::mat4(1.0f);
+            dog[3] = glm::vec4(place(rng), 0.0f, place(rng), 1.0f);
+        }
+        FootPlacement prototype;
+        prototype.init(*skeleton);
+        std::vector<FootPlacement> placements(NUM_DOGS, prototype);
+        std::vector<Ray> rays;
+        for(int dog = 0; dog < NUM_DOGS; dog++)
+            placements[dog].appendRays(*skeleton, dogs[dog], rays);
+
+        //brute force reference, single rays and the batch have to agree with it
+        auto bruteForce = [&](const Ray& ray){
+            float closest = ray.maxDistance;
+            bool found = false;
+            for(size_t i = 0; i + 2 < indices.size(); i += 3){
+                glm::vec3 a = positions[indices[i]];
+                glm::vec3 edge1 = positions[indices[i + 1]] - a;
+                glm::vec3 edge2 = positions[indices[i + 2]] - a;
+                glm::vec3 p = glm::cross(ray.direction, edge2);
+                float inverse = 1.0f / glm::dot(edge1, p);
+                glm::vec3 s = ray.origin - a;
+                float u = glm::dot(s, p) * inverse;
+                glm::vec3 q = glm::cross(s, edge1);
+                float v = glm::dot(ray.direction, q) * inverse;
+                float t = glm::dot(edge2, q) * inverse;
+                if(u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < closest){
+                    closest = t;
+                    found = true;
+                }
+            }
+            return found ? closest : -1.0f;
+        };
+        std::vector<RayHit> singleHits(rays.size());
+        std::vector<RayHit> batchHits(rays.size());
+        RaycastStats singleStats;
+        RaycastStats batchStats;
+        for(size_t i = 0; i < rays.size(); i++)
+            singleHits[i] = collision.raycast(rays[i], &singleStats);
+        collision.raycast(rays.data(), batchHits.data(), rays.size(), &batchStats);
+        float maxDifference = 0.0f;
+        bool allHit = true;
+        for(size_t i = 0; i < rays.size(); i++){
+            float reference = bruteForce(rays[i]);
+            allHit = allHit && reference >= 0.0f && singleHits[i].hit() && batchHits[i].hit();
+            maxDifference = std::max(maxDifference, std::abs(singleHits[i].distance - reference));
+            maxDifference = std::max(maxDifference, std::abs(batchHits[i].distance - reference));
+        }
+
+        start = Clock::now();
+        for(int repeat = 0; repeat < NUM_REPEATS; repeat++){
+            for(size_t i = 0; i < rays.size(); i++)
+                singleHits[i] = collision.raycast(rays[i]);
+        }
+        double singleNs = elapsedNs(start, Clock::now()) / (NUM_REPEATS * rays.size());
+        start = Clock::now();
+        for(int repeat = 0; repeat < NUM_REPEATS; repeat++)
+            collision.raycast(rays.data(), batchHits.data(), rays.size());
+        double batchNs = elapsedNs(start, Clock::now()) / (NUM_REPEATS * rays.size());
+
+        //one dog planted over a few seconds: every frame starts from the sampled pose, paws settle on the ground
+        std::vector<glm::quat> sampled(skeleton->joints.size());
+        for(size_t j = 0; j < sampled.size(); j++)
+            sampled[j] = skeleton->joints[j].rotation;
+        FootPlacement& placement = placements[0];
+        float pawError = 0.0f;
+        uint64_t placementNs = 0;
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            for(size_t j = 0; j < sampled.size(); j++)
+                skeleton->joints[j].rotation = sampled[j];
+            skeleton->update();
+            std::vector<glm::vec3> animated;
+            for(const auto& joint : skeleton->joints){
+                if(joint.name.rfind("paw_", 0) == 0)
+                    animated.push_back(glm::vec3(skeleton->getModelMatrix(static_cast<int>(&joint - skeleton->joints.data()))[3]));
+            }
+            auto solveStart = Clock::now();
+            placement.update(*skeleton, dogs[0], collision, FRAME_TIME);
+            skeleton->updateDirty();
+            placementNs += static_cast<uint64_t>(elapsedNs(solveStart, Clock::now()));
+            if(frame < NUM_FRAMES - 1)
+                continue;
+            //the paw keeps its animated lift above the terrain under it
+            size_t paw = 0;
+            for(const auto& joint : skeleton->joints){
+                if(joint.name.rfind("paw_", 0) != 0)
+                    continue;
+                glm::vec3 position(dogs[0] * skeleton->getModelMatrix(static_cast<int>(&joint - skeleton->joints.data()))[3]);
+                glm::vec3 animatedWorld(dogs[0] * glm::vec4(animated[paw++], 1.0f));
+                Ray down{glm::vec3(animatedWorld.x, 10.0f, animatedWorld.z), glm::vec3(0.0f, -1.0f, 0.0f), 20.0f};
+                float expected = animatedWorld.y + collision.raycast(down).position.y;
+                pawError = std::max(pawError, std::abs(position.y - expected));
+            }
+        }
+
+        bool passed = allHit && maxDifference <= 1e-4f && placement.getFootCount() == 4 && pawError <= 0.01f;
+        LOGI("[bench] foot placement: %zu triangles, %zu BVH nodes, built in %5.2f ms", collision.getTriangleCount(), collision.getNodeCount(), buildMs);
+        LOGI("[bench]   %d dogs, %zu paw rays: single %5.0f ns/ray (%5.1f nodes/ray), batched %5.0f ns/ray (%5.1f node loads/ray), %5.1f triangle tests/ray, brute force difference %g",
+             NUM_DOGS, rays.size(), singleNs, static_cast<float>(singleStats.nodeVisits) / rays.size(), batchNs,
+             static_cast<float>(batchStats.nodeVisits) / rays.size(), static_cast<float>(batchStats.triangleTests) / rays.size(), maxDifference);
+        LOGI("[bench]   %zu legs planted, %6.0f ns/frame with updateDirty, paw to ground error %g -> %s",
+             placement.getFootCount(), static_cast<double>(placementNs) / NUM_FRAMES, pawError, verdict(passed));
+    }
+
+    void runAimConstraintBenchmark(){
+        constexpr int NUM_TARGETS = 500;
+        constexpr int NUM_REPEATS = 2000;
+
+        //spine bends a little towards the target, neck and head finish the aim. The head constraint reads the
+        //spine's result, so it has to see the spine's matrices refreshed in the same pass
+        auto skeleton = createQuadrupedSkeleton();
+        skeleton->update();
+        const float spineLimit = glm::radians(10.0f);
+        AimConstraintSet constraints;
+        int head = constraints.add(*skeleton, "neck_0", "head", glm::vec3(0.0f, 0.0f, 1.0f), glm::radians(180.0f));
+        int spine = constraints.add(*skeleton, "spine_0", "spine_2", glm::vec3(0.0f, 0.0f, 1.0f), spineLimit);
+        constraints.get(spine).weight = 0.5f;
+        int headJoint = constraints.get(head).chain.back().joint;
+        std::vector<glm::quat> sampled(skeleton->joints.size());
+        for(size_t j = 0; j < sampled.size(); j++)
+            sampled[j] = skeleton->joints[j].rotation;
+
+        std::mt19937 rng(19);
+        std::uniform_real_distribution<float> side(-1.5f, 1.5f);
+        std::uniform_real_distribution<float> ahead(0.5f, 3.0f);
+        float maxAimError = 0.0f;
+        float maxSpineAngle = 0.0f;
+        for(int i = 0; i < NUM_TARGETS; i++){
+            glm::vec3 target(side(rng), side(rng), ahead(rng));
+            constraints.get(head).target = target;
+            constraints.get(spine).target = target;
+            for(size_t j = 0; j < sampled.size(); j++)
+                skeleton->joints[j].rotation = sampled[j];
+            skeleton->update();
+            constraints.apply(*skeleton);
+            skeleton->updateDirty();
+            glm::vec3 forward = ikMath::globalRotation(*skeleton, headJoint) * glm::vec3(0.0f, 0.0f, 1.0f);
+            glm::vec3 toTarget = glm::normalize(target - ikMath::jointPosition(*skeleton, headJoint));
+            maxAimError = std::max(maxAimError, std::acos(std::min(glm::dot(forward, toTarget), 1.0f)));
+            for(const auto& aim : constraints.get(spine).chain){
+                glm::quat change = skeleton->joints[aim.joint].rotation * glm::conjugate(sampled[aim.joint]);
+                maxSpineAngle = std::max(maxSpineAngle, 2.0f * std::acos(std::min(std::abs(change.w), 1.0f)));
+            }
+        }
+        bool passed = maxAimError <= 1e-3f && maxSpineAngle <= spineLimit + 1e-3f;
+        LOGI("[bench] aim constraints: spine (3 joints, %4.1f deg limit) + neck/head (3 joints) in one pass, head aim error %g rad, largest spine joint rotation %4.2f deg -> %s",
+             glm::degrees(spineLimit), maxAimError, glm::degrees(maxSpineAngle), verdict(passed));
+
+        //cost per chain length, no iteration so it has to grow linearly
+        for(int length : {4, 8, 16, 32}){
+            auto chain = createChainSkeleton(length);
+            chain->update();
+            AimConstraintSet aim;
+            aim.add(*chain, 0, length - 1, glm::vec3(0.0f, 1.0f, 0.0f), glm::radians(30.0f));
+            aim.get(0).target = glm::vec3(1.0f, 0.5f, 0.5f);
+            std::vector<glm::quat> rest(length, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+            auto start = Clock::now();
+            for(int repeat = 0; repeat < NUM_REPEATS; repeat++){
+                for(int j = 0; j < length; j++)
+                    chain->joints[j].rotation = rest[j];
+                aim.apply(*chain);
+            }
+            double ns = elapsedNs(start, Clock::now()) / NUM_REPEATS;
+            LOGI("[bench]   chain of %2d joints: %6.0f ns/constraint, %5.1f ns/joint", length, ns, ns / length);
+        }
+    }
+
+    void runIKDragBenchmark(){
+        constexpr int NUM_EVENTS = 240;
+        constexpr int SETTLE_EVENTS = 20;
+        //a drag event has to leave most of a 60 Hz frame to rendering
+        constexpr double EVENT_BUDGET_NS = 1e6;
+
+        auto skeleton = createQuadrupedSkeleton();
+        skeleton->update();
+        auto find = [&](const std::string& name){
+            for(size_t i = 0; i < skeleton->joints.size(); i++){
+                if(skeleton->joints[i].name == name)
+                    return static_cast<int>(i);
+            }
+            return -1;
+        };
+        struct DragCase{
+            const char* effector;
+            int chainLength;
+            glm::vec3 offset;
+        };
+        //a paw lifted forward and the head pulled to the side, finger moves of a millimetre or less per event
+        const DragCase cases[] = {{"paw_0", 2, glm::vec3(0.0f, 0.12f, 0.1f)}, {"head", 5, glm::vec3(0.12f, -0.05f, 0.05f)}};
+        for(const auto& dragCase : cases){
+            int effector = find(dragCase.effector);
+            IKDrag drag;
+            drag.begin(*skeleton, effector, dragCase.chainLength);
+            std::vector<glm::mat4> before(skeleton->joints.size());
+            for(size_t j = 0; j < before.size(); j++)
+                before[j] = skeleton->getModelMatrix(static_cast<int>(j));
+            glm::vec3 start = ikMath::jointPosition(*skeleton, effector);
+            int totalIterations = 0;
+            //the finger stops for the last events, the chain settles on the target
+            for(int event = 1; event <= NUM_EVENTS; event++){
+                float t = std::min(1.0f, static_cast<float>(event) / (NUM_EVENTS - SETTLE_EVENTS));
+                totalIterations += drag.drag(*skeleton, start + dragCase.offset * t).iterations;
+            }
+            const IKDragTiming& timing = drag.getTiming();
+            float error = glm::length(ikMath::jointPosition(*skeleton, effector) - (start + dragCase.offset));
+
+            //only the chain root's subtree may move, and its incremental update has to match a full one
+            bool outsideUntouched = true;
+            std::vector<glm::mat4> incremental(skeleton->joints.size());
+            for(size_t j = 0; j < before.size(); j++){
+                bool inSubtree = false;
+                for(int joint = static_cast<int>(j); joint != NO_PARENT && !inSubtree; joint = skeleton->joints[joint].parentIndex)
+                    inSubtree = joint == drag.getRoot();
+                incremental[j] = skeleton->getModelMatrix(static_cast<int>(j));
+                if(!inSubtree && incremental[j] != before[j])
+                    outsideUntouched = false;
+            }
+            skeleton->update();
+            float maxDifference = 0.0f;
+            for(size_t j = 0; j < incremental.size(); j++)
+                maxDifference = std::max(maxDifference, glm::length(glm::vec3(incremental[j][3]) - ikMath::jointPosition(*skeleton, static_cast<int>(j))));
+
+            bool passed = error <= 2e-3f && outsideUntouched && maxDifference <= 1e-5f && timing.averageTotalNanoseconds() <= EVENT_BUDGET_NS;
+            LOGI("[bench] IK drag %s (%d joints): %d events, %4.2f iterations/event, solve + subtree update %6.0f ns avg, %6.0f ns max, final error %g, rest of rig untouched %s -> %s",
+                 dragCase.effector, dragCase.chainLength, timing.events, static_cast<double>(totalIterations) / NUM_EVENTS, timing.averageTotalNanoseconds(),
+                 static_cast<double>(timing.maxTotalNanoseconds), error, outsideUntouched ? "yes" : "no", verdict(passed));
+        }
+    }
+
+    void runCpuSkinningBenchmark(){
+        constexpr size_t NUM_VERTICES = 60000;
+        constexpr int NUM_REPEATS = 30;
+        //same members and layout as VeModel::Vertex, which needs the Vulkan headers
+        struct Vertex{
+            glm::vec3 position;
+            glm::vec3 color;
+            glm::vec3 normal;
+            glm::vec2 uv;
+            glm::vec3 tangent;
+            glm::ivec4 jointIndices;
+            glm::vec4 jointWeights;
+        };
+        static_assert(sizeof(Vertex) == 88, "vertex layout differs from VeModel::Vertex");
+        const auto layout = SkinningLayout::of<Vertex>();
+#if defined(VE_SIMD_NEON)
+        const char* path = "NEON";
+#elif defined(VE_SIMD_SSE)
+        const char* path = "SSE2";
+#else
+        const char* path = "scalar";
+#endif
+
+        //posed dog, every joint bent a little
+        auto skeleton = createQuadrupedSkeleton();
+        std::mt19937 rng(22);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        for(auto& joint : skeleton->joints)
+            joint.rotation = glm::angleAxis(0.4f * unit(rng), glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 1e-3f)));
+        skeleton->update();
+        const auto& palette = skeleton->jointMatrices;
+        int jointCount = static_cast<int>(palette.size());
+
+        //one to four influences, weights normalized except every 97th vertex, an out of range joint every 1009th
+        std::vector<Vertex> vertices(NUM_VERTICES);
+        std::uniform_int_distribution<int> pickJoint(0, jointCount - 1);
+        std::uniform_int_distribution<int> pickCount(1, 4);
+        for(size_t v = 0; v < vertices.size(); v++){
+            auto& vertex = vertices[v];
+            vertex.position = glm::vec3(unit(rng), unit(rng), unit(rng));
+            vertex.color = glm::vec3(1.0f);
+            vertex.normal = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 1e-3f, 0.0f));
+            vertex.uv = glm::vec2(unit(rng), unit(rng));
+            vertex.tangent = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(1e-3f, 0.0f, 0.0f));
+            vertex.jointIndices = glm::ivec4(0);
+            vertex.jointWeights = glm::vec4(0.0f);
+            int influences = pickCount(rng);
+            float sum = 0.0f;
+            for(int i = 0; i < influences; i++){
+                vertex.jointIndices[i] = pickJoint(rng);
+                vertex.jointWeights[i] = 0.1f + 0.5f * (unit(rng) + 1.0f);
+                sum += vertex.jointWeights[i];
+            }
+            if(v % 97 != 0){
+                for(int i = 0; i < influences; i++)
+                    vertex.jointWeights[i] /= sum;
+            }
+            if(v % 1009 == 0)
+                vertex.jointIndices[0] = jointCount + 5;
+        }
+
+        std::vector<Vertex> reference = vertices;
+        std::vector<Vertex> single = vertices;
+        std::vector<Vertex> threaded = vertices;
+        auto start = Clock::now();
+        for(int r = 0; r < NUM_REPEATS; r++)
+            CpuSkinning::skinReference(vertices.data(), reference.data(), vertices.size(), layout, palette.data(), palette.size());
+        double referenceNs = elapsedNs(start, Clock::now()) / NUM_REPEATS;
+
+        CpuSkinning oneThread(0);
+        double singleNs = 0.0;
+        for(int r = 0; r < NUM_REPEATS; r++)
+            singleNs += static_cast<double>(oneThread.skin(vertices.data(), single.data(), vertices.size(), layout, palette.data(), palette.size()).nanoseconds);
+        singleNs /= NUM_REPEATS;
+
+        CpuSkinning workers;
+        //first job wakes the threads up, not counted
+        workers.skin(vertices.data(), threaded.data(), vertices.size(), layout, palette.data(), palette.size());
+        double threadedNs = 0.0;
+        for(int r = 0; r < NUM_REPEATS; r++)
+            threadedNs += static_cast<double>(workers.skin(vertices.data(), threaded.data(), vertices.size(), layout, palette.data(), palette.size()).nanoseconds);
+        threadedNs /= NUM_REPEATS;
+
+        float positionError = 0.0f;
+        float normalError = 0.0f;
+        bool threadsMatch = true;
+        bool untouchedKept = true;
+        for(size_t v = 0; v < vertices.size(); v++){
+            positionError = std::max(positionError, glm::length(single[v].position - reference[v].position));
+            normalError = std::max(normalError, std::max(glm::length(single[v].normal - reference[v].normal), glm::length(single[v].tangent - reference[v].tangent)));
+            threadsMatch = threadsMatch && std::memcmp(&single[v], &threaded[v], sizeof(Vertex)) == 0;
+            untouchedKept = untouchedKept && single[v].color == vertices[v].color && single[v].uv == vertices[v].uv &&
+                            single[v].jointIndices == vertices[v].jointIndices && single[v].jointWeights == vertices[v].jointWeights;
+        }
+        //an invalid joint keeps the bind pose
+        bool bindPoseKept = single[1009].position == vertices[1009].position && single[1009].normal == vertices[1009].normal;
+
+        auto perMs = [](double nanoseconds){return NUM_VERTICES * 1e6 / std::max(nanoseconds, 1.0);};
+        bool passed = positionError <= 1e-4f && normalError <= 1e-4f && threadsMatch && untouchedKept && bindPoseKept;
+        LOGI("[bench] CPU skinning %zu vertices, %d joints: glm reference %8.0f vertices/ms, %s 1 thread %8.0f vertices/ms (%4.2fx), %u threads %8.0f vertices/ms (%4.2fx)",
+             NUM_VERTICES, jointCount, perMs(referenceNs), path, perMs(singleNs), referenceNs / std::max(singleNs, 1.0),
+             workers.getThreadCount(), perMs(threadedNs), referenceNs / std::max(threadedNs, 1.0));
+        LOGI("[bench] CPU skinning against the reference: position error %g, normal/tangent error %g, threads bit identical %s, other attributes kept %s, invalid joint in bind pose %s -> %s",
+             positionError, normalError, threadsMatch ? "yes" : "no", untouchedKept ? "yes" : "no", bindPoseKept ? "yes" : "no", verdict(passed));
+    }
+
+    void runDualQuaternionSkinningBenchmark(){
+        constexpr size_t NUM_VERTICES = 60000;
+        constexpr int NUM_REPEATS = 30;
+        constexpr int NUM_CONVERSIONS = 2000;
+        struct Vertex{
+            glm::vec3 position;
+            glm::vec3 color;
+            glm::vec3 normal;
+            glm::vec2 uv;
+            glm::vec3 tangent;
+            glm::ivec4 jointIndices;
+            glm::vec4 jointWeights;
+        };
+        static_assert(sizeof(Vertex) == 88, "vertex layout differs from VeModel::Vertex");
+        const auto layout = SkinningLayout::of<Vertex>();
+
+        auto skeleton = createQuadrupedSkeleton();
+        std::mt19937 rng(23);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        for(auto& joint : skeleton->joints)
+            joint.rotation = glm::angleAxis(0.4f * unit(rng), glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 1e-3f)));
+        skeleton->update();
+        const auto& palette = skeleton->jointMatrices;
+        size_t jointCount = palette.size();
+
+        //what VeGameObject::writeJointPalette does every frame for a dual quaternion model
+        std::vector<DualQuaternion> dualQuaternions(jointCount);
+        float scaleError = 0.0f;
+        auto start = Clock::now();
+        for(int r = 0; r < NUM_CONVERSIONS; r++)
+            scaleError = dualQuaternion::fromMatrices(palette.data(), jointCount, dualQuaternions.data());
+        double conversionNs = elapsedNs(start, Clock::now()) / NUM_CONVERSIONS;
+
+        //every 4th vertex has a single influence: rigid, both methods must agree there
+        std::vector<Vertex> vertices(NUM_VERTICES);
+        std::uniform_int_distribution<int> pickJoint(0, static_cast<int>(jointCount) - 1);
+        std::uniform_int_distribution<int> pickCount(1, 4);
+        for(size_t v = 0; v < vertices.size(); v++){
+            auto& vertex = vertices[v];
+            vertex.position = glm::vec3(unit(rng), unit(rng), unit(rng));
+            vertex.color = glm::vec3(1.0f);
+            vertex.normal = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 1e-3f, 0.0f));
+            vertex.uv = glm::vec2(unit(rng), unit(rng));
+            vertex.tangent = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(1e-3f, 0.0f, 0.0f));
+            vertex.jointIndices = glm::ivec4(0);
+            vertex.jointWeights = glm::vec4(0.0f);
+            int influences = v % 4 == 0 ? 1 : pickCount(rng);
+            float sum = 0.0f;
+            for(int i = 0; i < influences; i++){
+                vertex.jointIndices[i] = pickJoint(rng);
+                vertex.jointWeights[i] = 0.1f + 0.5f * (unit(rng) + 1.0f);
+                sum += vertex.jointWeights[i];
+            }
+            for(int i = 0; i < influences; i++)
+                vertex.jointWeights[i] /= sum;
+        }
+
+        std::vector<Vertex> linear = vertices;
+        std::vector<Vertex> dual = vertices;
+        std::vector<Vertex> dualReference = vertices;
+        start = Clock::now();
+        for(int r = 0; r < NUM_REPEATS; r++)
+            CpuSkinning::skinRange(vertices.data(), linear.data(), 0, vertices.size(), layout, palette.data(), jointCount);
+        double linearNs = elapsedNs(start, Clock::now()) / NUM_REPEATS;
+        start = Clock::now();
+        for(int r = 0; r < NUM_REPEATS; r++)
+            CpuSkinning::skinRange(vertices.data(), dual.data(), 0, vertices.size(), layout, dualQuaternions.data(), jointCount);
+        double dualNs = elapsedNs(start, Clock::now()) / NUM_REPEATS;
+        CpuSkinning::skinReference(vertices.data(), dualReference.data(), vertices.size(), layout, dualQuaternions.data(), jointCount);
+
+        float rigidError = 0.0f;
+        float referenceError = 0.0f;
+        for(size_t v = 0; v < vertices.size(); v++){
+            referenceError = std::max(referenceError, glm::length(dual[v].position - dualReference[v].position));
+            if(v % 4 != 0)
+                continue;
+            rigidError = std::max(rigidError, glm::length(dual[v].position - linear[v].position));
+            rigidError = std::max(rigidError, glm::length(dual[v].normal - linear[v].normal));
+        }
+
+        //twisted forearm: a ring of unit radius halfway between a joint and one twisted 150 degrees about the bone,
+        //linear blend collapses it towards the bone (candy wrapper), dual quaternions keep the radius
+        glm::mat4 twist[2] = {glm::mat4(1.0f), glm::rotate(glm::mat4(1.0f), glm::radians(150.0f), glm::vec3(1.0f, 0.0f, 0.0f))};
+        DualQuaternion twistDq[2];
+        dualQuaternion::fromMatrices(twist, 2, twistDq);
+        constexpr int RING = 64;
+        std::vector<Vertex> ring(RING);
+        for(int i = 0; i < RING; i++){
+            float angle = glm::two_pi<float>() * i / RING;
+            ring[i] = vertices[1];
+            ring[i].position = glm::vec3(0.0f, std::cos(angle), std::sin(angle));
+            ring[i].jointIndices = glm::ivec4(0, 1, 0, 0);
+            ring[i].jointWeights = glm::vec4(0.5f, 0.5f, 0.0f, 0.0f);
+        }
+        std::vector<Vertex> ringLinear = ring, ringDual = ring;
+        CpuSkinning::skinReference(ring.data(), ringLinear.data(), RING, layout, twist, 2);
+        CpuSkinning::skinReference(ring.data(), ringDual.data(), RING, layout, twistDq, 2);
+        float linearRadius = 0.0f, dualRadius = 0.0f;
+        for(int i = 0; i < RING; i++){
+            linearRadius += glm::length(glm::vec2(ringLinear[i].position.y, ringLinear[i].position.z)) / RING;
+            dualRadius += glm::length(glm::vec2(ringDual[i].position.y, ringDual[i].position.z)) / RING;
+        }
+
+        //bytes the shaders fetch from the joint buffer for a four influence vertex, the main per vertex cost
+        //difference on the GPU besides the blend arithmetic the CPU kernels below stand in for
+        auto perMs = [](double nanoseconds){return NUM_VERTICES * 1e6 / std::max(nanoseconds, 1.0);};
+        bool passed = rigidError <= 1e-4f && referenceError <= 1e-4f && scaleError <= 1e-4f &&
+                      std::abs(dualRadius - 1.0f) <= 1e-3f && linearRadius < 0.5f;
+        LOGI("[bench] Dual quaternion palette, %zu joints: %zu bytes per frame upload against %zu for matrices (%zu vs %zu per joint), conversion %.2f us per frame",
+             jointCount, jointCount * sizeof(DualQuaternion), jointCount * sizeof(glm::mat4), sizeof(DualQuaternion), sizeof(glm::mat4), conversionNs / 1e3);
+        LOGI("[bench] Dual quaternion skinning %zu vertices: linear blend %8.0f vertices/ms, dual quaternion %8.0f vertices/ms (%4.2fx the cost), joint buffer reads per 4 influence vertex %zu vs %zu bytes",
+             NUM_VERTICES, perMs(linearNs), perMs(dualNs), dualNs / std::max(linearNs, 1.0), 4 * sizeof(DualQuaternion), 4 * sizeof(glm::mat4));
+        LOGI("[bench] Dual quaternion skinning: rigid vertices off linear blend by %g, off the reference by %g, scale dropped %g, 150 degree twist ring radius %.3f linear blend vs %.3f dual quaternion -> %s",
+             rigidError, referenceError, scaleError, linearRadius, dualRadius, verdict(passed));
+    }
+
+    void runJointPaletteBenchmark(){
+        constexpr int NUM_FRAMES = 200;
+        constexpr size_t FRAMES_IN_FLIGHT = 2;
+        //what createAnimatedObject used to allocate per object and frame in flight
+        constexpr size_t FIXED_JOINTS = 200;
+        constexpr size_t NUM_ANIMATED = 32;
+        //animated objects whose model has no clips: 200 identity matrices a frame before, nothing now
+        constexpr size_t NUM_STATIC = 8;
+        constexpr size_t ENTRY_SIZE = 16;
+
+        auto skeleton = createQuadrupedSkeleton();
+        skeleton->update();
+        const auto& palette = skeleton->jointMatrices;
+        size_t jointCount = palette.size();
+        std::vector<DualQuaternion> dualQuaternions(jointCount);
+        dualQuaternion::fromMatrices(palette.data(), jointCount, dualQuaternions.data());
+
+        //before: a 200 matrix uniform buffer per object and frame in flight
+        std::vector<std::vector<glm::mat4>> fixedBuffers(NUM_ANIMATED + NUM_STATIC, std::vector<glm::mat4>(FIXED_JOINTS));
+        size_t fixedUpload = 0;
+        auto start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            fixedUpload = 0;
+            for(size_t object = 0; object < NUM_ANIMATED; object++){
+                std::memcpy(fixedBuffers[object].data(), palette.data(), jointCount * sizeof(glm::mat4));
+                fixedUpload += jointCount * sizeof(glm::mat4);
+            }
+            for(size_t object = NUM_ANIMATED; object < fixedBuffers.size(); object++){
+                std::vector<glm::mat4> identities(FIXED_JOINTS, glm::mat4(1.0f));
+                std::memcpy(fixedBuffers[object].data(), identities.data(), FIXED_JOINTS * sizeof(glm::mat4));
+                fixedUpload += FIXED_JOINTS * sizeof(glm::mat4);
+            }
+        }
+        double fixedNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+        size_t fixedMemory = fixedBuffers.size() * FRAMES_IN_FLIGHT * FIXED_JOINTS * sizeof(glm::mat4);
+
+        //after: JointPaletteRing, every palette behind the previous one in one buffer, base index in vec4s.
+        //Half the objects use dual quaternions to check mixed packing
+        std::vector<uint8_t> ring(NUM_ANIMATED * jointCount * sizeof(glm::mat4));
+        std::vector<uint32_t> bases(NUM_ANIMATED);
+        size_t used = 0;
+        start = Clock::now();
+        for(int frame = 0; frame < NUM_FRAMES; frame++){
+            used = 0;
+            for(size_t object = 0; object < NUM_ANIMATED; object++){
+                bool dual = object % 2 == 1;
+                size_t size = dual ? jointCount * sizeof(DualQuaternion) : jointCount * sizeof(glm::mat4);
+                std::memcpy(ring.data() + used, dual ? static_cast<const void*>(dualQuaternions.data()) : palette.data(), size);
+                bases[object] = static_cast<uint32_t>(used / ENTRY_SIZE);
+                used += (size + ENTRY_SIZE - 1) / ENTRY_SIZE * ENTRY_SIZE;
+            }
+        }
+        double ringNs = elapsedNs(start, Clock::now()) / NUM_FRAMES;
+        size_t ringMemory = FRAMES_IN_FLIGHT * used;
+
+        //read back the way the shaders index jointData[]
+        bool packed = true;
+        const auto* entries = reinterpret_cast<const glm::vec4*>(ring.data());
+        for(size_t object = 0; object < NUM_ANIMATED; object++){
+            for(size_t joint = 0; joint < jointCount; joint++){
+                if(object % 2 == 1){
+                    packed = packed && entries[bases[object] + joint * 2] == dualQuaternions[joint].real &&
+                             entries[bases[object] + joint * 2 + 1] == dualQuaternions[joint].dual;
+                }else{
+                    for(int column = 0; column < 4; column++)
+                        packed = packed && entries[bases[object] + joint * 4 + column] == palette[joint][column];
+                }
+            }
+        }
+
+        bool passed = packed && used < fixedUpload && ringMemory < fixedMemory;
+        LOGI("[bench] Joint palettes, %zu animated objects (%zu joints) + %zu without clips: fixed 200 joint buffers %zu KB, %zu KB uploaded per frame in %.1f us",
+             NUM_ANIMATED, jointCount, NUM_STATIC, fixedMemory / 1024, fixedUpload / 1024, fixedNs / 1e3);
+        LOGI("[bench] Joint palettes in a shared ring (half dual quaternion): %zu KB, %zu KB uploaded per frame in %.1f us, shader reads back every palette %s -> %s",
+             ringMemory / 1024, used / 1024, ringNs / 1e3, packed ? "yes" : "no", verdict(passed));
+    }
+
+    void runPackedVertexBenchmark(){
+        constexpr size_t NUM_VERTICES = 60000;
+        constexpr int NUM_REPEATS = 30;
+        //a closed mesh has about two triangles per vertex
+        constexpr size_t NUM_INDICES = NUM_VERTICES * 6;
+        struct Vertex{
+            glm::vec3 position;
+            glm::vec3 color;
+            glm::vec3 normal;
+            glm::vec2 uv;
+            glm::vec3 tangent;
+            glm::ivec4 jointIndices;
+            glm::vec4 jointWeights;
+        };
+        static_assert(sizeof(Vertex) == 88, "vertex layout differs from VeModel::Vertex");
+
+        auto skeleton = createQuadrupedSkeleton();
+        std::mt19937 rng(25);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        for(auto& joint : skeleton->joints)
+            joint.rotation = glm::angleAxis(0.4f * unit(rng), glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 1e-3f)));
+        skeleton->update();
+        const auto& palette = skeleton->jointMatrices;
+        int jointCount = static_cast<int>(palette.size());
+
+        //one to four normalized influences, uvs in [0, 1], an out of range joint every 1009th vertex
+        std::vector<Vertex> vertices(NUM_VERTICES);
+        std::uniform_int_distribution<int> pickJoint(0, jointCount - 1);
+        std::uniform_int_distribution<int> pickCount(1, 4);
+        for(size_t v = 0; v < vertices.size(); v++){
+            auto& vertex = vertices[v];
+            vertex.position = glm::vec3(unit(rng), unit(rng), unit(rng));
+            vertex.color = glm::vec3(1.0f);
+            vertex.normal = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 1e-3f, 0.0f));
+            vertex.uv = glm::vec2(unit(rng), unit(rng)) * 0.5f + glm::vec2(0.5f);
+            vertex.tangent = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(1e-3f, 0.0f, 0.0f));
+            vertex.jointIndices = glm::ivec4(0);
+            vertex.jointWeights = glm::vec4(0.0f);
+            int influences = pickCount(rng);
+            float sum = 0.0f;
+            for(int i = 0; i < influences; i++){
+                vertex.jointIndices[i] = pickJoint(rng);
+                vertex.jointWeights[i] = 0.1f + 0.5f * (unit(rng) + 1.0f);
+                sum += vertex.jointWeights[i];
+            }
+            for(int i = 0; i < influences; i++)
+                vertex.jointWeights[i] /= sum;
+            if(v % 1009 == 0)
+                vertex.jointIndices[0] = jointCount + 5;
+        }
+
+        auto start = Clock::now();
+        std::vector<PackedVertex> packed(vertices.size());
+        for(size_t v = 0; v < vertices.size(); v++)
+            packed[v] = vertexPacking::pack(vertices[v]);
+        double packNs = elapsedNs(start, Clock::now());
+
+        //encoding error, directions in degrees. atan2 because acos of a float dot product cannot resolve less than ~0.02 degrees
+        auto degreesBetween = [](const glm::vec3& a, const glm::vec3& b){
+            return glm::degrees(std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+        };
+        float normalError = 0.0f;
+        float uvError = 0.0f;
+        float weightError = 0.0f;
+        bool jointsKept = true;
+        for(size_t v = 0; v < vertices.size(); v++){
+            const auto& vertex = vertices[v];
+            normalError = std::max(normalError, std::max(degreesBetween(vertex.normal, vertexPacking::unpackOctahedral(packed[v].normal)),
+                                                         degreesBetween(vertex.tangent, vertexPacking::unpackOctahedral(packed[v].tangent))));
+            glm::vec2 uv = vertexPacking::unpackHalf2(packed[v].uv);
+            uvError = std::max(uvError, std::max(std::abs(uv.x - vertex.uv.x), std::abs(uv.y - vertex.uv.y)));
+            glm::vec4 weights = vertexPacking::unpackWeights(packed[v].jointWeights);
+            for(int i = 0; i < 4; i++)
+                weightError = std::max(weightError, std::abs(weights[i] - vertex.jointWeights[i]));
+            jointsKept = jointsKept && vertexPacking::unpackJoints(packed[v].jointIndices) == vertex.jointIndices;
+        }
+        //indices a byte cannot hold become the invalid joint, they keep the bind pose like any out of range joint
+        bool outOfRangeInvalid = vertexPacking::unpackJoints(vertexPacking::packJoints(glm::ivec4(300, -1, 3, 254))) ==
+                                 glm::ivec4(vertexPacking::INVALID_JOINT, vertexPacking::INVALID_JOINT, 3, 254);
+
+        //through CpuSkinning on one thread: float to float, packed to packed, and the SkinningVertex bind pose
+        //decoded from the packed vertices to packed the way SkinningSystem runs it
+        const auto floatLayout = SkinningLayout::of<Vertex>();
+        const auto packedLayout = SkinningLayout::of<PackedVertex>();
+        const auto bindPoseLayout = SkinningLayout::of<SkinningVertex>();
+        std::vector<SkinningVertex> bindPose(vertices.size());
+        for(size_t v = 0; v < vertices.size(); v++)
+            bindPose[v] = SkinningVertex::of(packed[v]);
+        std::vector<Vertex> floatSkinned = vertices;
+        std::vector<PackedVertex> packedOnly = packed;
+        std::vector<PackedVertex> packedSkinned = packed;
+        CpuSkinning oneThread(0);
+        double floatNs = 0.0;
+        double packedOnlyNs = 0.0;
+        double packedNs = 0.0;
+        for(int r = 0; r < NUM_REPEATS; r++){
+            floatNs += static_cast<double>(oneThread.skin(vertices.data(), floatSkinned.data(), vertices.size(), floatLayout, palette.data(), palette.size()).nanoseconds);
+            packedOnlyNs += static_cast<double>(oneThread.skin(packed.data(), packedOnly.data(), packed.size(), packedLayout, palette.data(), palette.size()).nanoseconds);
+            packedNs += static_cast<double>(oneThread.skin(bindPose.data(), bindPoseLayout, packedSkinned.data(), bindPose.size(), packedLayout,
+                                                           palette.data(), palette.size()).nanoseconds);
+        }
+        floatNs /= NUM_REPEATS;
+        packedOnlyNs /= NUM_REPEATS;
+        packedNs /= NUM_REPEATS;
+        std::vector<PackedVertex> packedReference = packed;
+        CpuSkinning::skinReference(bindPose.data(), bindPoseLayout, packedReference.data(), bindPose.size(), packedLayout, palette.data(), palette.size());
+
+        float skinnedPositionError = 0.0f;
+        float skinnedNormalError = 0.0f;
+        bool referenceMatches = true;
+        for(size_t v = 0; v < vertices.size(); v++){
+            skinnedPositionError = std::max(skinnedPositionError, glm::length(packedSkinned[v].position - floatSkinned[v].position));
+            skinnedNormalError = std::max(skinnedNormalError, degreesBetween(floatSkinned[v].normal, vertexPacking::unpackOctahedral(packedSkinned[v].normal)));
+            referenceMatches = referenceMatches && glm::length(packedSkinned[v].position - packedReference[v].position) <= 1e-4f;
+        }
+        bool bindPoseKept = std::memcmp(&packedSkinned[1009], &packed[1009], sizeof(PackedVertex)) == 0;
+
+        //what a draw fetches: the vertex stream (+ 4 byte color stream for colored models) and 16 bit indices
+        size_t floatBytes = NUM_VERTICES * sizeof(Vertex) + NUM_INDICES * sizeof(uint32_t);
+        size_t packedBytes = NUM_VERTICES * sizeof(PackedVertex) + NUM_INDICES * sizeof(uint16_t);
+        size_t coloredBytes = packedBytes + NUM_VERTICES * sizeof(uint32_t);
+        auto perMs = [](double nanoseconds){return NUM_VERTICES * 1e6 / std::max(nanoseconds, 1.0);};
+        bool passed = sizeof(PackedVertex) + sizeof(uint32_t) < sizeof(Vertex) / 2 && coloredBytes < floatBytes / 2 &&
+                      normalError <= 0.01f && uvError <= 1e-3f && weightError <= 1e-5f && jointsKept && outOfRangeInvalid &&
+                      skinnedPositionError <= 1e-3f && skinnedNormalError <= 0.02f && referenceMatches && bindPoseKept;
+        LOGI("[bench] Packed vertices, %zu vertices %zu indices: %zu -> %zu bytes per vertex (%zu with vertex colors), mesh %zu -> %zu KB (%zu KB colored, %.0f%% less), packed in %.2f ms",
+             NUM_VERTICES, NUM_INDICES, sizeof(Vertex), sizeof(PackedVertex), sizeof(PackedVertex) + sizeof(uint32_t), floatBytes / 1024, packedBytes / 1024,
+             coloredBytes / 1024, 100.0 * (1.0 - static_cast<double>(coloredBytes) / floatBytes), packNs / 1e6);
+        LOGI("[bench] Packed vertices: normal/tangent error %.4f deg, uv error %g, weight error %g, joints kept %s, out of range joints invalid %s",
+             normalError, uvError, weightError, jointsKept ? "yes" : "no", outOfRangeInvalid ? "yes" : "no");
+        LOGI("[bench] Packed vertices skinned on the CPU: float %8.0f vertices/ms, packed to packed %8.0f vertices/ms, float bind pose to packed %8.0f vertices/ms",
+             perMs(floatNs), perMs(packedOnlyNs), perMs(packedNs));
+        LOGI("[bench] Packed vertices skinned on the CPU: position error %g, normal error %.4f deg, matches reference %s, invalid joint in bind pose %s -> %s",
+             skinnedPositionError, skinnedNormalError, referenceMatches ? "yes" : "no", bindPoseKept ? "yes" : "no",
+             verdict(passed));
+    }
+
+    int runAll(){
+        LOGI("[bench] running animation benchmarks");
+        failures = 0;
+        runKeyframeLookupBenchmark();
+        runCompressionBenchmark();
+        runBakeBenchmark();
+        runBatchSamplingBenchmark();
+        runPosePoolBenchmark();
+        runClipLibraryBenchmark();
+        runSamplerDedupBenchmark();
+        runKeyReductionBenchmark();
+        runAnimationLodBenchmark();
+        runHierarchyBenchmark();
+        runDirtyUpdateBenchmark();
+        runSkeletonInstanceBenchmark();
+        runTwoBoneIKBenchmark();
+        runFabrikBenchmark();
+        runCCDBenchmark();
+        runDLSBenchmark();
+        runFootPlacementBenchmark();
+        runAimConstraintBenchmark();
+        runIKDragBenchmark();
+        runCpuSkinningBenchmark();
+        runDualQuaternionSkinningBenchmark();
+        runJointPaletteBenchmark();
+        runPackedVertexBenchmark();
+        if(failures > 0){
+            LOGE("[bench] %d benchmark checks FAILED", failures);
+        }else{
+            LOGI("[bench] all benchmark checks passed");
+        }
+        return failures;
+    }
+}
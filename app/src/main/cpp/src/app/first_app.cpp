@@ -2,6 +2,9 @@
 #include "ve_imgui.hpp"
 #include "utility.hpp"
 #include "debug.hpp"
+#ifdef VE_RUN_BENCHMARKS
+#include "benchmarks.hpp"
+#endif
 
 #include "ImGuizmo.h"
 #define GLM_FORCE_RADIANS
@@ -48,6 +51,7 @@ namespace ve {
         }
         // Clean up game objects
         gameObjects.clear();
+        jointPalettes.reset();
 
         // Clean up render systems
         pbrRenderSystem.reset();
@@ -55,6 +59,7 @@ namespace ve {
         outlineHighlightSystem.reset();
         cubeMapRenderSystem.reset();
         skeletonSystem.reset();
+        skinningSystem.reset();
 
 
         // Clean up renderer (this should clean up its owned swapchain)
@@ -89,15 +94,21 @@ namespace ve {
             LOGE("FirstApp::init() called before having both ANativeWindow and AAssetManager");
             return;
         }
+#ifdef VE_RUN_BENCHMARKS
+        benchmarks::runAll();
+#endif
         //setup descriptor pools
         globalPool = VeDescriptorPool::Builder(*veDevice)
                 .setMaxSets(20000)
                 .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 10000)
                 .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 10000)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000)
         #ifdef MACOS
                 .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
         #endif
                 .build();
+        //before the animated objects, they write their palettes to it
+        jointPalettes = std::make_unique<JointPaletteRing>(*veDevice, *globalPool);
         //Dear ImGui DescriptorPool
         imGuiPool = VeImGui::createDescriptorPool(veDevice->device());
         //load assets
@@ -161,10 +172,10 @@ namespace ve {
                 .build(shadowDescriptorSet);
         shadowRenderSystem = std::make_unique<ShadowRenderSystem>(*veDevice, assetManager.get(),
                                                                   shadowManager->getShadowRenderPass(0),
-                                                                  std::vector<VkDescriptorSetLayout>{gameObjects.at(engineInfo.animatedObjIndex).animationComponent->animationSetLayout->getDescriptorSetLayout()});
+                                                                  std::vector<VkDescriptorSetLayout>{jointPalettes->getSetLayout()});
         pbrRenderSystem = std::make_unique<PbrRenderSystem>(*veDevice, assetManager.get(), veRenderer->getSwapChainRenderPass(),
             std::vector<VkDescriptorSetLayout>{globalSetLayout->getDescriptorSetLayout(), /*textureSetLayout->getDescriptorSetLayout(),*/
-                               gameObjects.at(engineInfo.animatedObjIndex).animationComponent->animationSetLayout->getDescriptorSetLayout(),
+                               jointPalettes->getSetLayout(),
                                gameObjects.at(engineInfo.selectedObject).model->materialComponent->materialSetLayout->getDescriptorSetLayout(),
                                shadowSetLayout->getDescriptorSetLayout()});
         pointLightSystem = std::make_unique<PointLightSystem>(*veDevice, assetManager.get(), veRenderer->getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
@@ -172,6 +183,7 @@ namespace ve {
 //        cubeMapRenderSystem = std::make_unique<CubeMapRenderSystem>(*veDevice, assetManager.get(), veRenderer->getSwapChainRenderPass(),
 //            std::vector<VkDescriptorSetLayout>{globalSetLayout->getDescriptorSetLayout(), gameObjects.at(engineInfo.cubeMapIndex).cubeMapComponent->descriptorSetLayout->getDescriptorSetLayout()});
         skeletonSystem = std::make_unique<SkeletonSystem>(*veDevice, assetManager.get(), veRenderer->getSwapChainRenderPass(), std::vector<VkDescriptorSetLayout>{globalSetLayout->getDescriptorSetLayout()}, veRenderer->getAspectRatio());
+        skinningSystem = std::make_unique<SkinningSystem>(*veDevice, assetManager.get(), jointPalettes->getSetLayout());
         //imgui
         imGuiRenderPass = VeImGui::createRenderPass(veDevice->device(), veRenderer->getSwapChainImageFormat(), veRenderer->getSwapChainDepthFormat());
         VeImGui::createImGuiContext(*veDevice, *veWindow, imGuiPool, imGuiRenderPass, VeSwapChain::MAX_FRAMES_IN_FLIGHT);
@@ -227,7 +239,7 @@ namespace ve {
             //record frame data
             engineInfo.numLights = getNumLights(); //multiple point lights
             engineInfo.frameIndex = veRenderer->getFrameIndex();
-            FrameInfo frameInfo{engineInfo.frameIndex, engineInfo.frameTime, engineInfo.elapsedTime, commandBuffer, engineInfo.camera, globalDescriptorSets[engineInfo.frameIndex], gameObjects.at(engineInfo.animatedObjIndex).animationComponent->animationDescriptorSets[engineInfo.frameIndex], gameObjects, engineInfo.animatedObjIndex, engineInfo.selectedJointIndex,  engineInfo.numLights, engineInfo.showOutlignHighlight};
+            FrameInfo frameInfo{engineInfo.frameIndex, engineInfo.frameTime, engineInfo.elapsedTime, commandBuffer, engineInfo.camera, globalDescriptorSets[engineInfo.frameIndex], jointPalettes->getDescriptorSet(engineInfo.frameIndex), gameObjects, engineInfo.animatedObjIndex, engineInfo.selectedJointIndex,  engineInfo.numLights, engineInfo.showOutlignHighlight};
             //update global UBO
             GlobalUbo globalUbo{};
             globalUbo.projection = engineInfo.camera.getProjectionMatrix();
@@ -238,8 +250,14 @@ namespace ve {
             pointLightSystem->update(frameInfo, globalUbo);
             uniformBuffers[engineInfo.frameIndex]->writeToBuffer(&globalUbo);
             uniformBuffers[engineInfo.frameIndex]->flush();
-            //update animation
-            gameObjects.at(engineInfo.animatedObjIndex).updateAnimation(engineInfo.frameTime, engineInfo.frameCount, engineInfo.frameIndex);
+            //update animation, every palette of the frame is written to the ring, then flushed once
+            jointPalettes->beginFrame(engineInfo.frameIndex);
+            //no foot placement while editing joints, the editor poses the legs by hand
+            gameObjects.at(engineInfo.animatedObjIndex).updateAnimation(engineInfo.frameTime, engineInfo.frameCount, engineInfo.frameIndex, engineInfo.camera,
+                                                                        engineInfo.showEditJointMode ? nullptr : &collision);
+            jointPalettes->flush(engineInfo.frameIndex);
+            //skin once, the shadow faces and the scene pass draw the result
+            skinningSystem->skinGameObjects(frameInfo, *globalPool);
             std::vector<PointLight> pointLightsVec(std::begin(globalUbo.pointLights), std::end(globalUbo.pointLights));
 
             if(engineInfo.frameCount%2==0){
@@ -263,11 +281,11 @@ namespace ve {
 
             if(engineInfo.showOutlignHighlight) {
 //                outlineHighlightSystem->renderGameObjects(frameInfo);
-                pbrRenderSystem->renderGameObjects(frameInfo, /*shadowRenderSystem.getShadowDescriptorSet(frameIndex),*/ {globalDescriptorSets[engineInfo.frameIndex], /*textureDescriptorSet,*/ gameObjects.at(engineInfo.animatedObjIndex).animationComponent->animationDescriptorSets[engineInfo.frameIndex], gameObjects.at(engineInfo.selectedObject).model->materialComponent->materialDescriptorSets, shadowDescriptorSet});
+                pbrRenderSystem->renderGameObjects(frameInfo, /*shadowRenderSystem.getShadowDescriptorSet(frameIndex),*/ {globalDescriptorSets[engineInfo.frameIndex], /*textureDescriptorSet,*/ frameInfo.animatedDescriptorSet, gameObjects.at(engineInfo.selectedObject).model->materialComponent->materialDescriptorSets, shadowDescriptorSet});
                 skeletonSystem->renderJoints(frameInfo, {globalDescriptorSets[engineInfo.frameIndex]});
                 skeletonSystem->renderJointConnections(frameInfo, {globalDescriptorSets[engineInfo.frameIndex]});
             }else
-                pbrRenderSystem->renderGameObjects(frameInfo, /*shadowRenderSystem.getShadowDescriptorSet(frameIndex),*/ {globalDescriptorSets[engineInfo.frameIndex], /*textureDescriptorSet,*/ gameObjects.at(engineInfo.animatedObjIndex).animationComponent->animationDescriptorSets[engineInfo.frameIndex], gameObjects.at(engineInfo.selectedObject).model->materialComponent->materialDescriptorSets, shadowDescriptorSet});
+                pbrRenderSystem->renderGameObjects(frameInfo, /*shadowRenderSystem.getShadowDescriptorSet(frameIndex),*/ {globalDescriptorSets[engineInfo.frameIndex], /*textureDescriptorSet,*/ frameInfo.animatedDescriptorSet, gameObjects.at(engineInfo.selectedObject).model->materialComponent->materialDescriptorSets, shadowDescriptorSet});
             pointLightSystem->render(frameInfo);
 //            cubeMapRenderSystem->renderGameObjects(frameInfo);
 
@@ -305,7 +323,8 @@ namespace ve {
 
     void FirstApp::loadGameObjects() {
         auto model = g_modelManager->getModel("Akita Inu");
-        auto fox = VeGameObject::createAnimatedObject(*veDevice, *globalPool, model);
+        //the timeline and the joint editor drive the model's clip and skeleton, not an instance of its own
+        auto fox = VeGameObject::createAnimatedObject(*jointPalettes, model);
 //        auto fox = VeGameObject::createGameObject();
         fox.setTextureIndex(1);
 //        fox.model = preLoadedModels["Cute_Demon"];
@@ -340,9 +359,20 @@ namespace ve {
 //        skybox.setTitle("Skybox");
 //        gameObjects.emplace(skybox.getId(),std::move(skybox));
 //        engineInfo.cubeMapIndex = skybox.getId();
+        buildCollision();
 
         LOGI("Successfully loaded game objects");
     }
+    void FirstApp::buildCollision(){
+        collision.clear();
+        for(auto& [id, object] : gameObjects){
+            if(!object.model || object.model->getCollisionIndices().empty()){
+                continue;
+            }
+            collision.addTriangles(object.model->getCollisionPositions(), object.model->getCollisionIndices(), object.transform.mat4());
+        }
+        collision.build();
+    }
     void FirstApp::loadTextures(){
         textures.push_back(std::make_unique<VeTexture>(*veDevice, assetManager.get(),"textures/stone.png"));
         textures.push_back(std::make_unique<VeTexture>(*veDevice, assetManager.get(),"textures/tile.png"));
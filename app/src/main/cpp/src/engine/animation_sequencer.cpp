@@ -220,11 +220,10 @@ namespace ve {
             if (channel.node != jointIndex) continue;
 
             const auto& sampler = animation.samplers[channel.samplerIndex];
-            const auto& times = sampler.timeStamps;
 
-            for (size_t i = 0; i + 1 < times.size(); ++i) {
-                float t0 = times[i];
-                float t1 = times[i + 1];
+            for (size_t i = 0; i + 1 < sampler.keyCount(); ++i) {
+                float t0 = sampler.keyTime(i);
+                float t1 = sampler.keyTime(i + 1);
 
                 // Sample 3 intermediate points: start, mid, end
                 std::vector<float> sampleTimes = { t0, (t0 + t1) * 0.5f, t1 };
@@ -234,8 +233,8 @@ namespace ve {
                     int frame = static_cast<int>(sampleTime * 30.0f);
                     frameMax = std::max(frameMax, frame);
 
-                    glm::vec4 v0 = sampler.TRSoutputValues[i];
-                    glm::vec4 v1 = sampler.TRSoutputValues[i + 1];
+                    glm::vec4 v0 = sampler.keyValue(i);
+                    glm::vec4 v1 = sampler.keyValue(i + 1);
 
                     TRS& trs = frameToTRSMap[frame];
 
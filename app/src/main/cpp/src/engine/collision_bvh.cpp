@@ -0,0 +1,285 @@
+#include "collision_bvh.hpp"
+#include "debug.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace ve{
+    namespace{
+        constexpr float MISS = std::numeric_limits<float>::infinity();
+        //deep enough for any median split tree, each level leaves at most one node pending
+        constexpr size_t STACK_SIZE = 64;
+
+        //10 bits per axis interleaved, rays with close origins get close keys
+        uint32_t spreadBits(uint32_t value){
+            value = (value | (value << 16)) & 0x030000FFu;
+            value = (value | (value << 8)) & 0x0300F00Fu;
+            value = (value | (value << 4)) & 0x030C30C3u;
+            value = (value | (value << 2)) & 0x09249249u;
+            return value;
+        }
+        uint32_t mortonKey(const glm::vec3& point, const glm::vec3& boundsMin, const glm::vec3& extent){
+            glm::vec3 cell = glm::clamp((point - boundsMin) / extent, 0.0f, 1.0f) * 1023.0f;
+            return spreadBits(static_cast<uint32_t>(cell.x)) | (spreadBits(static_cast<uint32_t>(cell.y)) << 1) | (spreadBits(static_cast<uint32_t>(cell.z)) << 2);
+        }
+    }
+
+    void CollisionBVH::clear(){
+        triangles.clear();
+        nodes.clear();
+    }
+
+    void CollisionBVH::addTriangles(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const glm::mat4& transform){
+        triangles.reserve(triangles.size() + indices.size() / 3);
+        for(size_t i = 0; i + 2 < indices.size(); i += 3){
+            if(indices[i] >= positions.size() || indices[i + 1] >= positions.size() || indices[i + 2] >= positions.size())
+                continue;
+            glm::vec3 a(transform * glm::vec4(positions[indices[i]], 1.0f));
+            glm::vec3 b(transform * glm::vec4(positions[indices[i + 1]], 1.0f));
+            glm::vec3 c(transform * glm::vec4(positions[indices[i + 2]], 1.0f));
+            Triangle triangle{a, b - a, c - a};
+            //degenerate triangles can never be hit
+            if(glm::length(glm::cross(triangle.edge1, triangle.edge2)) <= 0.0f)
+                continue;
+            triangles.push_back(triangle);
+        }
+    }
+
+    void CollisionBVH::build(){
+        nodes.clear();
+        if(triangles.empty())
+            return;
+        std::vector<glm::vec3> centroids(triangles.size());
+        for(size_t i = 0; i < triangles.size(); i++){
+            const auto& triangle = triangles[i];
+            centroids[i] = triangle.vertex + (triangle.edge1 + triangle.edge2) / 3.0f;
+        }
+        std::vector<uint32_t> order(triangles.size());
+        std::iota(order.begin(), order.end(), 0u);
+        nodes.reserve(2 * triangles.size() / LEAF_TRIANGLES + 1);
+        buildNode(order, 0, static_cast<uint32_t>(triangles.size()), centroids);
+        //leaves reference contiguous ranges of the sorted triangles
+        std::vector<Triangle> sorted(triangles.size());
+        for(size_t i = 0; i < order.size(); i++)
+            sorted[i] = triangles[order[i]];
+        triangles.swap(sorted);
+        LOGI("Collision BVH: %zu triangles, %zu nodes", triangles.size(), nodes.size());
+    }
+
+    uint32_t CollisionBVH::buildNode(std::vector<uint32_t>& order, uint32_t begin, uint32_t end, const std::vector<glm::vec3>& centroids){
+        uint32_t index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+        glm::vec3 centroidMin = boundsMin;
+        glm::vec3 centroidMax = boundsMax;
+        for(uint32_t i = begin; i < end; i++){
+            const auto& triangle = triangles[order[i]];
+            glm::vec3 b = triangle.vertex + triangle.edge1;
+            glm::vec3 c = triangle.vertex + triangle.edge2;
+            boundsMin = glm::min(boundsMin, glm::min(triangle.vertex, glm::min(b, c)));
+            boundsMax = glm::max(boundsMax, glm::max(triangle.vertex, glm::max(b, c)));
+            centroidMin = glm::min(centroidMin, centroids[order[i]]);
+            centroidMax = glm::max(centroidMax, centroids[order[i]]);
+        }
+        nodes[index].boundsMin = boundsMin;
+        nodes[index].boundsMax = boundsMax;
+
+        glm::vec3 extent = centroidMax - centroidMin;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        //small ranges and triangles sharing one centroid stay together
+        if(end - begin <= LEAF_TRIANGLES || extent[axis] <= 0.0f){
+            nodes[index].offset = begin;
+            nodes[index].count = end - begin;
+            return index;
+        }
+        uint32_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                         [&](uint32_t a, uint32_t b){return centroids[a][axis] < centroids[b][axis];});
+        buildNode(order, begin, middle, centroids);
+        uint32_t right = buildNode(order, middle, end, centroids);
+        nodes[index].offset = right;
+        nodes[index].count = 0;
+        return index;
+    }
+
+    CollisionBVH::TraversalRay CollisionBVH::prepare(const Ray& ray){
+        TraversalRay traversal{ray.origin, ray.direction, glm::vec3(0.0f)};
+        for(int axis = 0; axis < 3; axis++){
+            //axis parallel rays get a huge but finite inverse, 0 * inf would poison the slab test
+            float component = ray.direction[axis];
+            if(std::abs(component) < 1e-20f)
+                component = std::copysign(1e-20f, component);
+            traversal.inverseDirection[axis] = 1.0f / component;
+        }
+        return traversal;
+    }
+
+    float CollisionBVH::intersectBounds(const Node& node, const TraversalRay& ray, float limit){
+        glm::vec3 t0 = (node.boundsMin - ray.origin) * ray.inverseDirection;
+        glm::vec3 t1 = (node.boundsMax - ray.origin) * ray.inverseDirection;
+        glm::vec3 near = glm::min(t0, t1);
+        glm::vec3 far = glm::max(t0, t1);
+        float enter = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+        float exit = std::min(std::min(far.x, far.y), std::min(far.z, limit));
+        return enter <= exit ? enter : MISS;
+    }
+
+    bool CollisionBVH::intersectTriangle(uint32_t index, const TraversalRay& ray, RayHit& hit) const{
+        //Moller-Trumbore, both faces
+        const auto& triangle = triangles[index];
+        glm::vec3 p = glm::cross(ray.direction, triangle.edge2);
+        float determinant = glm::dot(triangle.edge1, p);
+        if(std::abs(determinant) < 1e-12f)
+            return false;
+        float inverse = 1.0f / determinant;
+        glm::vec3 s = ray.origin - triangle.vertex;
+        float u = glm::dot(s, p) * inverse;
+        if(u < 0.0f || u > 1.0f)
+            return false;
+        glm::vec3 q = glm::cross(s, triangle.edge1);
+        float v = glm::dot(ray.direction, q) * inverse;
+        if(v < 0.0f || u + v > 1.0f)
+            return false;
+        float distance = glm::dot(triangle.edge2, q) * inverse;
+        if(distance < 0.0f || distance >= hit.distance)
+            return false;
+        hit.distance = distance;
+        hit.triangle = static_cast<int>(index);
+        return true;
+    }
+
+    void CollisionBVH::finishHit(const Triangle& triangle, const TraversalRay& ray, RayHit& hit){
+        hit.position = ray.origin + ray.direction * hit.distance;
+        glm::vec3 normal = glm::normalize(glm::cross(triangle.edge1, triangle.edge2));
+        hit.normal = glm::dot(normal, ray.direction) > 0.0f ? -normal : normal;
+    }
+
+    RayHit CollisionBVH::raycast(const Ray& ray, RaycastStats* stats) const{
+        RayHit hit;
+        if(nodes.empty())
+            return hit;
+        TraversalRay traversal = prepare(ray);
+        hit.distance = ray.maxDistance;
+        if(intersectBounds(nodes[0], traversal, hit.distance) == MISS)
+            return RayHit{};
+        //node and entry distance, the nearer child is pushed last and visited first
+        uint32_t stack[STACK_SIZE];
+        float entries[STACK_SIZE];
+        size_t top = 0;
+        stack[top] = 0;
+        entries[top++] = 0.0f;
+        size_t visits = 0;
+        size_t tests = 0;
+        while(top > 0){
+            top--;
+            if(entries[top] > hit.distance)
+                continue;
+            uint32_t index = stack[top];
+            const Node& node = nodes[index];
+            visits++;
+            if(node.count > 0){
+                for(uint32_t i = node.offset; i < node.offset + node.count; i++)
+                    intersectTriangle(i, traversal, hit);
+                tests += node.count;
+                continue;
+            }
+            uint32_t children[2] = {index + 1, node.offset};
+            float enter[2] = {intersectBounds(nodes[children[0]], traversal, hit.distance),
+                              intersectBounds(nodes[children[1]], traversal, hit.distance)};
+            int nearer = enter[1] < enter[0] ? 1 : 0;
+            for(int child : {1 - nearer, nearer}){
+                if(enter[child] == MISS)
+                    continue;
+                stack[top] = children[child];
+                entries[top++] = enter[child];
+            }
+        }
+        if(stats){
+            stats->nodeVisits += visits;
+            stats->triangleTests += tests;
+        }
+        if(!hit.hit())
+            return RayHit{};
+        finishHit(triangles[hit.triangle], traversal, hit);
+        return hit;
+    }
+
+    void CollisionBVH::raycast(const Ray* rays, RayHit* hits, size_t count, RaycastStats* stats) const{
+        for(size_t i = 0; i < count; i++)
+            hits[i] = RayHit{};
+        if(nodes.empty() || count == 0)
+            return;
+        //packets of rays with nearby origins: dogs standing close together share most of their path
+        const Node& root = nodes[0];
+        glm::vec3 extent = glm::max(root.boundsMax - root.boundsMin, glm::vec3(1e-6f));
+        std::vector<std::pair<uint32_t, uint32_t>> sorted(count);
+        for(size_t i = 0; i < count; i++)
+            sorted[i] = {mortonKey(rays[i].origin, root.boundsMin, extent), static_cast<uint32_t>(i)};
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<TraversalRay> traversals(std::min(count, PACKET_SIZE));
+
+        struct Entry{
+            uint32_t node;
+            uint64_t mask;
+        };
+        Entry stack[STACK_SIZE];
+        size_t visits = 0;
+        size_t tests = 0;
+        for(size_t first = 0; first < count; first += PACKET_SIZE){
+            size_t packetSize = std::min(PACKET_SIZE, count - first);
+            const auto* packet = sorted.data() + first;
+            for(size_t i = 0; i < packetSize; i++){
+                traversals[i] = prepare(rays[packet[i].second]);
+                hits[packet[i].second].distance = rays[packet[i].second].maxDistance;
+            }
+            size_t top = 0;
+            stack[top++] = {0, packetSize == 64 ? ~0ull : (1ull << packetSize) - 1};
+            while(top > 0){
+                Entry entry = stack[--top];
+                const Node& node = nodes[entry.node];
+                visits++;
+                //rays of the packet that still enter this node before their closest hit
+                uint64_t active = 0;
+                for(uint64_t mask = entry.mask; mask; mask &= mask - 1){
+                    size_t i = static_cast<size_t>(__builtin_ctzll(mask));
+                    float distance = hits[packet[i].second].distance;
+                    if(intersectBounds(node, traversals[i], distance) <= distance)
+                        active |= 1ull << i;
+                }
+                if(!active)
+                    continue;
+                if(node.count > 0){
+                    for(uint64_t mask = active; mask; mask &= mask - 1){
+                        size_t i = static_cast<size_t>(__builtin_ctzll(mask));
+                        for(uint32_t triangle = node.offset; triangle < node.offset + node.count; triangle++)
+                            intersectTriangle(triangle, traversals[i], hits[packet[i].second]);
+                        tests += node.count;
+                    }
+                    continue;
+                }
+                //front to back for the first active ray, the others mostly agree
+                size_t lead = static_cast<size_t>(__builtin_ctzll(active));
+                uint32_t left = entry.node + 1;
+                uint32_t right = node.offset;
+                float leadDistance = hits[packet[lead].second].distance;
+                bool rightFirst = intersectBounds(nodes[right], traversals[lead], leadDistance) < intersectBounds(nodes[left], traversals[lead], leadDistance);
+                stack[top++] = {rightFirst ? left : right, active};
+                stack[top++] = {rightFirst ? right : left, active};
+            }
+            for(size_t i = 0; i < packetSize; i++){
+                auto& hit = hits[packet[i].second];
+                if(hit.hit())
+                    finishHit(triangles[hit.triangle], traversals[i], hit);
+                else
+                    hit = RayHit{};
+            }
+        }
+        if(stats){
+            stats->nodeVisits += visits;
+            stats->triangleTests += tests;
+        }
+    }
+}
@@ -95,6 +95,24 @@ namespace ve{
             if (ImGui::RadioButton("Local", state.currentMode == ImGuizmo::LOCAL))
                 state.currentMode = ImGuizmo::LOCAL;
 
+            // IK drag mode: drag the joint as an end effector
+            bool ikChanged = ImGui::Checkbox("IK Drag", &state.ikDragMode);
+            if (state.ikDragMode) {
+                ImGui::SameLine();
+                ikChanged |= ImGui::SliderInt("Chain Length", &state.ikChainLength, 1, 8);
+            }
+            if (ikChanged) {
+                BeginIKDrag(gameObject);
+            }
+            if (state.ikDragMode && ikDrag.isActive()) {
+                const IKDragTiming& timing = ikDrag.getTiming();
+                ImGui::Text("Chain: %s -> %s", skeleton->joints[ikDrag.getRoot()].name.c_str(), skeleton->joints[ikDrag.getEffector()].name.c_str());
+                ImGui::Text("Last drag: %d iterations, error %.4f, solve %.1f us, solve + update %.1f us",
+                            timing.iterations, timing.error, timing.solveNanoseconds / 1000.0, timing.totalNanoseconds / 1000.0);
+                ImGui::Text("%d drag events: average %.1f us, max %.1f us",
+                            timing.events, timing.averageTotalNanoseconds() / 1000.0, timing.maxTotalNanoseconds / 1000.0);
+            }
+
             ImGui::Separator();
 
             // Control buttons
@@ -191,18 +209,49 @@ namespace ve{
                                        glm::vec3(-MAX_TRANSLATION),
                                        glm::vec3(MAX_TRANSLATION));
 
-        // Update the joint's transform matrices
-        skeleton->updateJoint(jointIndex);
+        // Recompute the matrices of the joint's subtree only
+        skeleton->markDirty(jointIndex);
+        skeleton->updateDirty();
+    }
 
-        // Update all child joints recursively
-        int numJoints = skeleton->joints.size();
-        for (int i = 0; i < numJoints; i++) {
-            if (skeleton->joints[i].parentIndex == jointIndex) {
-                skeleton->updateJoint(i);
+    void JointEditor::BeginIKDrag(VeGameObject& gameObject) {
+        auto* skeleton = gameObject.model->skeleton.get();
+        state.ikOriginalRotations.clear();
+        if (!state.ikDragMode || !skeleton || state.selectedJoint < 0 ||
+            !ikDrag.begin(*skeleton, state.selectedJoint, state.ikChainLength)) {
+            ikDrag.end();
+            return;
+        }
+        skeleton->updateDirty();
+        // The gizmo starts on the effector and stays under the finger when the target is out of reach
+        state.ikTarget = glm::vec3(skeleton->getModelMatrix(state.selectedJoint)[3]);
+        for (int joint = ikDrag.getEffector(); joint != ve::NO_PARENT; joint = skeleton->joints[joint].parentIndex) {
+            state.ikOriginalRotations.emplace_back(joint, skeleton->joints[joint].rotation);
+            if (joint == ikDrag.getRoot()) {
+                break;
             }
         }
     }
 
+    void JointEditor::RenderIKGizmo(VeGameObject& gameObject, EngineInfo& engineInfo) {
+        auto* skeleton = gameObject.model->skeleton.get();
+        glm::mat4 objectMatrix = gameObject.transform.mat4();
+        glm::mat4 gizmoTransform = objectMatrix * glm::translate(glm::mat4(1.0f), state.ikTarget);
+
+        bool wasManipulated = ImGuizmo::Manipulate(
+                glm::value_ptr(engineInfo.camera.getRotViewMatrix()),
+                glm::value_ptr(engineInfo.camera.getProjectionMatrix()),
+                ImGuizmo::TRANSLATE,
+                ImGuizmo::WORLD,
+                glm::value_ptr(gizmoTransform)
+        );
+        if (wasManipulated) {
+            state.ikTarget = glm::vec3(glm::inverse(objectMatrix) * gizmoTransform[3]);
+            // Incremental: the solve continues from the pose of the previous event, only the chain's subtree is updated
+            ikDrag.drag(*skeleton, state.ikTarget);
+        }
+    }
+
     void JointEditor::RenderGizmo(VeGameObject& gameObject, EngineInfo& engineInfo) {
         // Only render if we have a valid joint selected and are editing
         if (state.selectedJoint < 0 || !state.editingJoint) {
@@ -223,6 +272,11 @@ namespace ve{
         ImGuiIO& io = ImGui::GetIO();
         ImGuizmo::SetRect(0, 0, io.DisplaySize.x, io.DisplaySize.y);
 
+        if (state.ikDragMode && ikDrag.isActive()) {
+            RenderIKGizmo(gameObject, engineInfo);
+            return;
+        }
+
         auto& joint = skeleton->joints[state.selectedJoint];
         glm::mat4 jointWorldMatrix;
 
@@ -325,6 +379,7 @@ namespace ve{
         state.originalPosition = glm::vec3(globalTransform[3]);
         state.currentEditPosition = state.originalPosition;
         state.editingJoint = true;
+        BeginIKDrag(gameObject);
     }
 
     void JointEditor::RevertJointChanges(VeGameObject& gameObject, int jointIndex, EngineInfo& engineInfo) {
@@ -338,16 +393,17 @@ namespace ve{
         joint.translation = state.originalTranslation;
         joint.rotation = state.originalRotation;
         joint.scale = state.originalScale;
+        // IK drags moved the whole chain
+        for (const auto& [chainJoint, rotation] : state.ikOriginalRotations) {
+            skeleton->joints[chainJoint].rotation = rotation;
+            skeleton->markDirty(chainJoint);
+        }
 
-        // Update the joint's transform matrices
-        skeleton->updateJoint(jointIndex);
-
-        // Update all child joints recursively
-        int numJoints = skeleton->joints.size();
-        for (int i = 0; i < numJoints; i++) {
-            if (skeleton->joints[i].parentIndex == jointIndex) {
-                skeleton->updateJoint(i);
-            }
+        // Recompute the matrices of the joint's subtree only
+        skeleton->markDirty(jointIndex);
+        skeleton->updateDirty();
+        if (state.ikDragMode) {
+            BeginIKDrag(gameObject);
         }
 
         // Reset the editing state
@@ -367,6 +423,12 @@ namespace ve{
         float currentTime = animation.currentKeyFrameTime;
 
         SaveJointKeyframe(animation, skeleton, jointIndex, currentTime, true, true);
+        // IK drags changed the rotations of every joint above the effector as well
+        for (const auto& [chainJoint, rotation] : state.ikOriginalRotations) {
+            if (chainJoint != jointIndex) {
+                SaveJointKeyframe(animation, skeleton, chainJoint, currentTime, true, false);
+            }
+        }
 
         // Show success message
         state.showSaveSuccess = true;
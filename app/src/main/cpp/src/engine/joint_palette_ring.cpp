@@ -0,0 +1,77 @@
+#include "joint_palette_ring.hpp"
+#include "ve_swap_chain.hpp"
+#include "debug.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace ve{
+    JointPaletteRing::JointPaletteRing(VeDevice& device, VeDescriptorPool& descriptorPool, VkDeviceSize capacity)
+            : veDevice{device}, descriptorPool{descriptorPool}{
+        setLayout = VeDescriptorSetLayout::Builder(device)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT, 1)
+                .build();
+        frames.resize(VeSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for(auto& frame : frames){
+            frame.buffer = createBuffer(capacity);
+            auto bufferInfo = frame.buffer->descriptorInfo();
+            if(!VeDescriptorWriter(*setLayout, descriptorPool)
+                    .writeBuffer(0, &bufferInfo)
+                    .build(frame.descriptorSet)){
+                throw std::runtime_error("failed to allocate joint palette descriptor set!");
+            }
+        }
+    }
+
+    std::unique_ptr<VeBuffer> JointPaletteRing::createBuffer(VkDeviceSize capacity){
+        auto buffer = std::make_unique<VeBuffer>(veDevice, ENTRY_SIZE, static_cast<uint32_t>((capacity + ENTRY_SIZE - 1) / ENTRY_SIZE),
+                                                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        buffer->map();
+        return buffer;
+    }
+
+    void JointPaletteRing::beginFrame(int frameIndex){
+        auto& frame = frames[frameIndex];
+        frame.used = 0;
+        frame.serial = nextSerial++;
+    }
+
+    JointPaletteRing::Allocation JointPaletteRing::write(int frameIndex, const void* data, VkDeviceSize size, uint32_t jointCount){
+        auto& frame = frames[frameIndex];
+        VkDeviceSize alignedSize = (size + ENTRY_SIZE - 1) / ENTRY_SIZE * ENTRY_SIZE;
+        if(frame.used + alignedSize > frame.buffer->getBufferSize()){
+            grow(frame, frame.used + alignedSize);
+        }
+        std::memcpy(static_cast<uint8_t*>(frame.buffer->getMappedMemory()) + frame.used, data, size);
+        Allocation allocation{frame.serial, static_cast<uint32_t>(frame.used / ENTRY_SIZE), jointCount};
+        frame.used += alignedSize;
+        return allocation;
+    }
+
+    void JointPaletteRing::grow(Frame& frame, VkDeviceSize required){
+        VkDeviceSize capacity = std::max(frame.buffer->getBufferSize() * 2, required);
+        LOGI("Joint palette buffer grows from %llu to %llu bytes", static_cast<unsigned long long>(frame.buffer->getBufferSize()),
+             static_cast<unsigned long long>(capacity));
+        //the frame's fence was waited for, its old buffer and descriptor set are no longer in use
+        auto buffer = createBuffer(capacity);
+        std::memcpy(buffer->getMappedMemory(), frame.buffer->getMappedMemory(), frame.used);
+        frame.buffer = std::move(buffer);
+        auto bufferInfo = frame.buffer->descriptorInfo();
+        VeDescriptorWriter(*setLayout, descriptorPool)
+                .writeBuffer(0, &bufferInfo)
+                .overwrite(frame.descriptorSet);
+    }
+
+    void JointPaletteRing::flush(int frameIndex){
+        auto& frame = frames[frameIndex];
+        if(frame.used > 0){
+            frame.buffer->flush();
+        }
+    }
+
+    bool JointPaletteRing::isCurrent(const Allocation& allocation, int frameIndex) const{
+        return allocation.jointCount > 0 && allocation.serial == frames[frameIndex].serial;
+    }
+}
@@ -6,27 +6,35 @@
 #include <thread>
 
 namespace ve{
-    static const std::unordered_map<std::string, std::string> MODEL_PATHS = {
-            {"Akita Inu", "models/akita/akita.gltf"},
-            {"Beagle", "models/beagle/beagle.gltf"},
-            {"Border Collie", "models/border_collie/border_collie.gltf"},
-            {"Boxer", "models/boxer/boxer.gltf"},
-            {"Bulldog", "models/bulldog/bulldog.gltf"},
-            {"Corgi", "models/corgi/corgi.gltf"},
-            {"Dalmatian", "models/dalmatian/dalmatian.gltf"},
-            {"Doberman", "models/doberman/doberman.gltf"},
-            {"French Bulldog", "models/french_bulldog/french_bulldog.gltf"},
-            {"Golden Retriever", "models/golden_retriever/golden_retriever.gltf"},
-            {"Husky", "models/husky/husky.gltf"},
-            {"Jack Russell Terrier", "models/jack_russell_terrier/jack_russell_terrier.gltf"},
-            {"Labrador", "models/labrador/labrador.gltf"},
-            {"Pitbull", "models/pitbull/pitbull.gltf"},
-            {"Pomeranian Spitz", "models/pomeranian_spitz/pomeranian_spitz.gltf"},
-            {"Pug", "models/pug/pug.gltf"},
-            {"Rottweiler", "models/rottweiler/rottweiler.gltf"},
-            {"Shepherd", "models/shepherd/shepherd.gltf"},
-            {"Shiba Inu", "models/shiba_inu/shiba_inu.gltf"},
-            {"Toy Terrier", "models/toy_terrier/toy_terrier.gltf"},
+    namespace {
+        struct ModelSource{
+            std::string path;
+            //models of one clip set were animated from the same source, see AnimationImportSettings::clipSet
+            std::string clipSet;
+        };
+    }
+    //every breed is rigged on the same dog skeleton and ships the same clips
+    static const std::unordered_map<std::string, ModelSource> MODEL_PATHS = {
+            {"Akita Inu", {"models/akita/akita.gltf", "dog"}},
+            {"Beagle", {"models/beagle/beagle.gltf", "dog"}},
+            {"Border Collie", {"models/border_collie/border_collie.gltf", "dog"}},
+            {"Boxer", {"models/boxer/boxer.gltf", "dog"}},
+            {"Bulldog", {"models/bulldog/bulldog.gltf", "dog"}},
+            {"Corgi", {"models/corgi/corgi.gltf", "dog"}},
+            {"Dalmatian", {"models/dalmatian/dalmatian.gltf", "dog"}},
+            {"Doberman", {"models/doberman/doberman.gltf", "dog"}},
+            {"French Bulldog", {"models/french_bulldog/french_bulldog.gltf", "dog"}},
+            {"Golden Retriever", {"models/golden_retriever/golden_retriever.gltf", "dog"}},
+            {"Husky", {"models/husky/husky.gltf", "dog"}},
+            {"Jack Russell Terrier", {"models/jack_russell_terrier/jack_russell_terrier.gltf", "dog"}},
+            {"Labrador", {"models/labrador/labrador.gltf", "dog"}},
+            {"Pitbull", {"models/pitbull/pitbull.gltf", "dog"}},
+            {"Pomeranian Spitz", {"models/pomeranian_spitz/pomeranian_spitz.gltf", "dog"}},
+            {"Pug", {"models/pug/pug.gltf", "dog"}},
+            {"Rottweiler", {"models/rottweiler/rottweiler.gltf", "dog"}},
+            {"Shepherd", {"models/shepherd/shepherd.gltf", "dog"}},
+            {"Shiba Inu", {"models/shiba_inu/shiba_inu.gltf", "dog"}},
+            {"Toy Terrier", {"models/toy_terrier/toy_terrier.gltf", "dog"}},
     };
     // Available model names
     static const std::vector<std::string> AVAILABLE_MODELS = {
@@ -139,6 +147,7 @@ namespace ve{
         cache_.clear();
         accessOrder_.clear();
         loading_.clear();
+        clipLibrary_.clear();
     }
 
     void ModelManager::addToCache(const std::string& name, std::shared_ptr<VeModel> model) {
@@ -160,17 +169,30 @@ namespace ve{
     }
 
     std::shared_ptr<VeModel> ModelManager::loadModel(const std::string& name) {
-        std::string path = getModelPath(name);
-        if (path.empty()) return nullptr;
-
+        auto source = MODEL_PATHS.find(name);
+        if (source == MODEL_PATHS.end()) return nullptr;
+        const std::string& path = source->second.path;
+
+        AnimationImportSettings animationSettings;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            animationSettings = animationSettings_;
+        }
+        animationSettings.clipLibrary = &clipLibrary_;
+        animationSettings.clipSet = source->second.clipSet;
         try {
-            return VeModel::createModelFromFile(device_, assetManager_, *modelDescriptorPool, path);
+            return VeModel::createModelFromFile(device_, assetManager_, *modelDescriptorPool, path, animationSettings);
         } catch (...) {
             LOGE("Error: creating model %s", name.c_str());
             return nullptr;
         }
     }
 
+    void ModelManager::setAnimationImportSettings(const AnimationImportSettings& settings) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        animationSettings_ = settings;
+    }
+
     void ModelManager::startAsyncLoad(const std::string& name) {
         loading_[name] = std::async(std::launch::async, [this, name]() {
             return loadModel(name);
@@ -179,7 +201,7 @@ namespace ve{
 
     std::string ModelManager::getModelPath(const std::string& name) const {
         auto it = MODEL_PATHS.find(name);
-        return (it != MODEL_PATHS.end()) ? it->second : "";
+        return (it != MODEL_PATHS.end()) ? it->second.path : "";
     }
 
     void ModelManager::initializeModels(VeDevice& device, AAssetManager* assetManager) {
@@ -1,11 +1,16 @@
 #include "ve_game_object.hpp"
 #include "debug.hpp"
 #include "ve_swap_chain.hpp" //just to get the max frames in flight
+#include <algorithm>
 #include <iostream>
 
 //@todo: compile user defined constants to a separate file
 // (like frames inflight, max num lights, max joints
 namespace ve{
+    namespace{
+        //objects updated without a camera animate at full detail
+        const AnimationLodLevel FULL_DETAIL{};
+    }
     glm::mat4 TransformComponent::mat4() {
         const float c3 = glm::cos(rotation.z);
         const float s3 = glm::sin(rotation.z);
@@ -147,59 +152,185 @@ namespace ve{
         LOGI("Cubemap created");
         return cubeObj;
     }
-    VeGameObject VeGameObject::createAnimatedObject(VeDevice& device, VeDescriptorPool& descriptorPool, std::shared_ptr<VeModel> veModel){
+    VeGameObject VeGameObject::createAnimatedObject(JointPaletteRing& jointPalettes, std::shared_ptr<VeModel> veModel){
         VeGameObject cubeObj = VeGameObject::createGameObject();
         cubeObj.model = veModel;
         AnimationComponent animationComponent{};
-        uint32_t maxJoints = 200;  // Define the max number of joints
-//        uint32_t numJoints = std::min(static_cast<uint32_t>(veModel->skeleton->joints.size()), maxJoints);
-        uint32_t numJoints = maxJoints;
-        auto jointSize = static_cast<uint32_t>(sizeof(glm::mat4));
-        animationComponent.shaderJointsBuffer.resize(ve::VeSwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (int i = 0; i < animationComponent.shaderJointsBuffer.size(); i++) {
-            animationComponent.shaderJointsBuffer[i] = std::make_unique<VeBuffer>(device,
-                                                               numJoints * jointSize, 1,
-                                                               VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-                                                               device.properties.limits.minUniformBufferOffsetAlignment);
-            animationComponent.shaderJointsBuffer[i]->map();
-        }
-
-        animationComponent.animationSetLayout = VeDescriptorSetLayout::Builder(device)
-                .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1)
-                .build();
-        animationComponent.animationDescriptorSets.resize(VeSwapChain::MAX_FRAMES_IN_FLIGHT);
-        for(int i = 0; i < animationComponent.animationDescriptorSets.size(); i++){
-            auto bufferInfo2 = animationComponent.shaderJointsBuffer[i]->descriptorInfo();
-            VeDescriptorWriter(*animationComponent.animationSetLayout, descriptorPool)
-                    .writeBuffer(0,&bufferInfo2)
-                    .build(animationComponent.animationDescriptorSets[i]);
-        }
+        //palettes are sub-allocated from the shared ring every frame, sized by the model's joint count
+        animationComponent.jointPalettes = &jointPalettes;
+        animationComponent.jointPaletteAllocations.resize(VeSwapChain::MAX_FRAMES_IN_FLIGHT);
+        animationComponent.skinnedVertices.resize(VeSwapChain::MAX_FRAMES_IN_FLIGHT);
         cubeObj.animationComponent = std::make_unique<AnimationComponent>(std::move(animationComponent));
         LOGI("Animated Object created");
         return cubeObj;
     }
+    VeGameObject VeGameObject::createAnimatedInstance(JointPaletteRing& jointPalettes, std::shared_ptr<VeModel> veModel){
+        VeGameObject instanceObj = createAnimatedObject(jointPalettes, veModel);
+        instanceObj.animationComponent->skeletonInstance = veModel->acquireSkeletonInstance();
+        if(!instanceObj.animationComponent->skeletonInstance){
+            LOGE("No skeleton instance available, object %d plays on the model's skeleton", instanceObj.getId());
+        }
+        return instanceObj;
+    }
+    void VeGameObject::updateInstanceAnimation(float deltaTime, int frameCounter, int frameIndex, const AnimationLodLevel* lod,
+                                               const CollisionBVH* collision){
+        auto& component = *animationComponent;
+        auto& instance = *component.skeletonInstance;
+        Animation* clip = model->animationManager->currentAnimation;
+        bool poseChanged = false;
+        //a paused clip holds every instance at its last pose, a second update in one frame keeps the one solved
+        if(clip && clip->isRunning() && component.poseFrameCount != frameCounter){
+            component.poseFrameCount = frameCounter;
+            //same clock as Animation::advance, kept per object. A clip that does not repeat holds its last key
+            float step = clip->playbackStep(deltaTime);
+            float time = std::max(component.animationTime, clip->getFirstKeyFrameTime()) + step;
+            component.animationTime = std::min(clip->wrapTime(time), clip->getLastKeyFrameTime());
+            poseChanged = component.animationLod.update(deltaTime, *clip, component.animationTime, step, *instance.definition,
+                                                        instance.local, lod);
+        }
+        //frozen and paused poses keep their palette
+        if(poseChanged){
+            bool placeFeet = collision && !collision->empty() && component.footPlacementEnabled;
+            if(placeFeet || !model->aimConstraints.empty()){
+                //the post-processes solve on a Skeleton, the instance borrows the model's. Both hold the
+                //definition's joints in the same order and compose the same palette
+                solvePose(instance.local, deltaTime, placeFeet ? collision : nullptr);
+                std::copy_n(model->skeleton->jointMatrices.data(), instance.getJointCount(), instance.palette);
+            }else{
+                instance.updatePalette();
+            }
+        }
+        writeJointPalette(frameIndex, instance.palette, instance.getJointCount(), poseChanged);
+    }
+    void VeGameObject::updateModelAnimation(float deltaTime, int frameCounter, int frameIndex, const AnimationLodLevel* lod,
+                                            const CollisionBVH* collision){
+        auto& component = *animationComponent;
+        auto& skeleton = *model->skeleton;
+        Animation* clip = model->animationManager->currentAnimation;
+        float advanced = model->advanceAnimation(deltaTime, frameCounter);
+        //paused or stopped, the object shows the skeleton as the joint editor leaves it
+        if(!clip || !model->wasClipRunning()){
+            skeleton.update();
+            writeJointPalette(frameIndex, skeleton.jointMatrices.data(), skeleton.jointMatrices.size());
+            return;
+        }
+        auto& pose = component.pose.pose();
+        if(component.poseSkeleton != &skeleton || pose.jointCount != skeleton.joints.size()){
+            //joints without channels start from the rest pose, the skeleton may hold another object's solve
+            component.poseSkeleton = &skeleton;
+            component.pose.resize(skeleton.joints.size());
+            if(model->skeletonDefinition){
+                pose.copyFrom(model->skeletonDefinition->getRestPose());
+            }else{
+                pose.readFrom(skeleton);
+            }
+            component.jointMatrices = skeleton.jointMatrices;
+            component.animationLod.reset();
+        }
+        //once per frame and object: a second update (the joint editor's) draws the solved pose again instead of
+        //stepping the foot placement smoothing twice
+        if(component.poseFrameCount == frameCounter){
+            writeJointPalette(frameIndex, component.jointMatrices.data(), component.jointMatrices.size(), false);
+            return;
+        }
+        component.poseFrameCount = frameCounter;
+        //a frozen pose is not composed again, but the ring needs it every frame
+        if(!component.animationLod.update(deltaTime, *clip, clip->currentKeyFrameTime, advanced, skeleton, pose, lod)){
+            writeJointPalette(frameIndex, component.jointMatrices.data(), component.jointMatrices.size(), false);
+            return;
+        }
+        solvePose(pose, deltaTime, component.footPlacementEnabled ? collision : nullptr);
+        component.jointMatrices.assign(skeleton.jointMatrices.begin(), skeleton.jointMatrices.end());
+        writeJointPalette(frameIndex, component.jointMatrices.data(), component.jointMatrices.size());
+    }
+    void VeGameObject::solvePose(const Pose& pose, float deltaTime, const CollisionBVH* collision){
+        auto& component = *animationComponent;
+        auto& skeleton = *model->skeleton;
+        //objects sharing the model compose their pose on its skeleton in turn
+        pose.writeTo(skeleton);
+        skeleton.update();
+        glm::mat4 modelMatrix = transform.mat4();
+        model->aimConstraints.setObjectMatrix(modelMatrix);
+        model->applyAimConstraints();
+        //legs are solved on this object's freshly sampled pose, never on an earlier solve or on another object's
+        if(collision && !collision->empty()){
+            //a model change brings a different rig, legs are looked up again
+            if(!component.footPlacement.isBoundTo(skeleton)){
+                component.footPlacement.init(skeleton);
+            }
+            component.footPlacement.update(skeleton, modelMatrix, *collision, deltaTime);
+            skeleton.updateDirty();
+        }
+    }
+    void VeGameObject::writeJointPalette(int frameIndex, const glm::mat4* matrices, size_t count, bool poseChanged){
+        auto& component = *animationComponent;
+        auto jointCount = static_cast<uint32_t>(count);
+        if(model->skinningMethod == SkinningMethod::DualQuaternion){
+            auto& dualQuaternions = component.dualQuaternionPalette;
+            if(poseChanged || dualQuaternions.size() != count){
+                dualQuaternions.resize(count);
+                dualQuaternion::fromMatrices(matrices, count, dualQuaternions.data());
+            }
+            component.jointPaletteAllocations[frameIndex] = component.jointPalettes->write(frameIndex, dualQuaternions.data(),
+                                                                                           count * sizeof(DualQuaternion), jointCount);
+        }else{
+            component.jointPaletteAllocations[frameIndex] = component.jointPalettes->write(frameIndex, matrices,
+                                                                                           count * sizeof(glm::mat4), jointCount);
+        }
+    }
+    JointPaletteRing::Allocation VeGameObject::getJointPalette(int frameIndex) const{
+        if(!animationComponent || !animationComponent->jointPalettes ||
+           frameIndex >= static_cast<int>(animationComponent->jointPaletteAllocations.size())){
+            return {};
+        }
+        const auto& allocation = animationComponent->jointPaletteAllocations[frameIndex];
+        //written in an earlier round of this frame in flight, the ring has reused that space since
+        if(!animationComponent->jointPalettes->isCurrent(allocation, frameIndex)){
+            return {};
+        }
+        return allocation;
+    }
     void VeGameObject::updateAnimation(float deltaTime, int frameCounter, int frameIndex){
-        const uint32_t maxJoints = 200;
-        if(model->hasAnimationData()) {
-            model->updateAnimation(deltaTime, frameCounter, frameIndex);
-
-            uint32_t numJoints = std::min(
-                    static_cast<uint32_t>(model->skeleton->jointMatrices.size()), maxJoints);
-
-            animationComponent->shaderJointsBuffer[frameIndex]->writeToBuffer(
-                    static_cast<void *>(model->skeleton->jointMatrices.data()),
-                    numJoints * sizeof(glm::mat4)  // Only copy the required size
-            );
-        }else {
-            std::vector<glm::mat4> defaultIdentityMatrices(maxJoints, glm::identity<glm::mat4>());
-
-            // 2. Write these identity matrices to the shader buffer.
-            animationComponent->shaderJointsBuffer[frameIndex]->writeToBuffer(
-                    static_cast<void *>(defaultIdentityMatrices.data()), // Pointer to the data
-                    maxJoints * sizeof(glm::mat4)                      // Total size of the data
-            );
+        //without animation data the shaders do not skin and no palette is written
+        if(!model->hasAnimationData()){
+            return;
+        }
+        if(animationComponent->skeletonInstance){
+            updateInstanceAnimation(deltaTime, frameCounter, frameIndex, &FULL_DETAIL, nullptr);
+        }else{
+            updateModelAnimation(deltaTime, frameCounter, frameIndex, &FULL_DETAIL, nullptr);
+        }
+    }
+    void VeGameObject::updateAnimation(float deltaTime, int frameCounter, int frameIndex, const VeCamera& camera, const CollisionBVH* collision){
+        if(!model->hasAnimationData()){
+            return;
+        }
+        auto& component = *animationComponent;
+        glm::mat4 modelMatrix = transform.mat4();
+        glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(model->getBoundingCenter(), 1.0f));
+        float scale = std::max(std::abs(transform.scale.x), std::max(std::abs(transform.scale.y), std::abs(transform.scale.z)));
+        //the rendered view includes the surface pre-rotation
+        component.screenSize = computeScreenSize(center, model->getBoundingRadius() * scale,
+                                                 camera.getRotViewMatrix(), camera.getProjectionMatrix());
+        component.lodLevel = component.lodPolicy.select(component.screenSize, component.lodLevel);
+        const AnimationLodLevel* lod = component.lodPolicy.get(component.lodLevel);
+        if(component.skeletonInstance){
+            updateInstanceAnimation(deltaTime, frameCounter, frameIndex, lod, collision);
+        }else{
+            updateModelAnimation(deltaTime, frameCounter, frameIndex, lod, collision);
+        }
+    }
+    bool VeGameObject::bindModel(VkCommandBuffer commandBuffer, int frameIndex){
+        //no palette this frame (not updated, or no animation component) draws the bind pose
+        bool posed = model->hasAnimationData() && getJointPalette(frameIndex).jointCount > 0;
+        if(posed && frameIndex < static_cast<int>(animationComponent->skinnedVertices.size())){
+            auto& skinned = animationComponent->skinnedVertices[frameIndex];
+            if(skinned.model && skinned.model == model){
+                model->bind(commandBuffer, skinned.buffer->getBuffer());
+                return false;
+            }
         }
-        animationComponent->shaderJointsBuffer[frameIndex]->flush();
+        model->bind(commandBuffer);
+        return posed;
     }
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define TINYGLTF_NO_STB_IMAGE_WRITE
 
 #include "ve_model.hpp"
+#include "clip_library.hpp"
 #include "buffer.hpp"
 #include "ve_swap_chain.hpp"
 #include "utility.hpp"
@@ -16,6 +17,7 @@
 #include <glm/gtx/matrix_decompose.hpp>
 
 #include <vector>
+#include <algorithm>
 #include <functional>
 #include <cassert>
 #include <cstring>
@@ -60,17 +62,58 @@ namespace ve{
     void VeModel::createVertexBuffers(const std::vector<Vertex>& vertices){
         vertexCount = static_cast<uint32_t>(vertices.size());
         assert(vertexCount >= 3 && "Vertex count must be at least 3");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+        //bounding sphere around the box center, loose but cheap and good enough for LOD selection
+        glm::vec3 minPosition = vertices[0].position;
+        glm::vec3 maxPosition = vertices[0].position;
+        for(const auto& vertex : vertices){
+            minPosition = glm::min(minPosition, vertex.position);
+            maxPosition = glm::max(maxPosition, vertex.position);
+        }
+        boundingCenter = (minPosition + maxPosition) * 0.5f;
+        boundingRadius = 0.0f;
+        for(const auto& vertex : vertices){
+            boundingRadius = std::max(boundingRadius, glm::length(vertex.position - boundingCenter));
+        }
+        std::vector<PackedVertex> packedVertices;
+        packedVertices.reserve(vertices.size());
+        for(const auto& vertex : vertices){
+            packedVertices.push_back(vertexPacking::pack(vertex));
+        }
+        uint32_t vertexSize = sizeof(PackedVertex);
+        VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexSize) * vertexCount;
         //create staging buffer
-        uint32_t vertexSize = sizeof(vertices[0]);
         VeBuffer stagingBuffer{veDevice, vertexSize, vertexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
         stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)vertices.data());
+        stagingBuffer.writeToBuffer((void *)packedVertices.data());
 
-        vertexBuffer = std::make_unique<VeBuffer>(veDevice, vertexSize, vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, 
+        //storage and transfer source for SkinningSystem, which reads it and copies it into the skinned buffers
+        vertexBuffer = std::make_unique<VeBuffer>(veDevice, vertexSize, vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
         veDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+        createColorBuffer(vertices);
+    }
+    void VeModel::createColorBuffer(const std::vector<Vertex>& vertices){
+        vertexColors = std::any_of(vertices.begin(), vertices.end(), [](const Vertex& vertex){
+            return !vertexPacking::isWhite(vertex.color);
+        });
+        //all white models read this one entry for every vertex (binding stride 0)
+        std::vector<uint32_t> colors(vertexColors ? vertices.size() : 1, vertexPacking::packColor(glm::vec3(1.0f)));
+        if(vertexColors){
+            for(size_t i = 0; i < vertices.size(); i++){
+                colors[i] = vertexPacking::packColor(vertices[i].color);
+            }
+        }
+        uint32_t colorSize = sizeof(colors[0]);
+        uint32_t colorCount = static_cast<uint32_t>(colors.size());
+        VeBuffer stagingBuffer{veDevice, colorSize, colorCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+        stagingBuffer.map();
+        stagingBuffer.writeToBuffer((void *)colors.data());
+        colorBuffer = std::make_unique<VeBuffer>(veDevice, colorSize, colorCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        veDevice.copyBuffer(stagingBuffer.getBuffer(), colorBuffer->getBuffer(), static_cast<VkDeviceSize>(colorSize) * colorCount);
     }
     void VeModel::createIndexBuffers(const std::vector<uint32_t>& indices){
         indexCount = static_cast<uint32_t>(indices.size());
@@ -79,13 +122,23 @@ namespace ve{
         if(!hasIndexBuffer){
             return;
         }
-        VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
+        //half the index fetch for meshes up to 65536 vertices
+        std::vector<uint16_t> shortIndices;
+        const void* indexData = indices.data();
         uint32_t indexSize = sizeof(indices[0]);
+        indexType = VK_INDEX_TYPE_UINT32;
+        if(*std::max_element(indices.begin(), indices.end()) <= UINT16_MAX){
+            shortIndices.assign(indices.begin(), indices.end());
+            indexData = shortIndices.data();
+            indexSize = sizeof(shortIndices[0]);
+            indexType = VK_INDEX_TYPE_UINT16;
+        }
+        VkDeviceSize bufferSize = static_cast<VkDeviceSize>(indexSize) * indexCount;
         //create staging buffer
         VeBuffer stagingBuffer{veDevice, indexSize, indexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
         stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)indices.data());
+        stagingBuffer.writeToBuffer(const_cast<void*>(indexData));
         //create index buffer
         indexBuffer = std::make_unique<VeBuffer>(veDevice, indexSize, indexCount, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -93,11 +146,14 @@ namespace ve{
     }
 
     void VeModel::bind(VkCommandBuffer commandBuffer){
-        VkBuffer buffers[] = {vertexBuffer->getBuffer()};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        bind(commandBuffer, vertexBuffer->getBuffer());
+    }
+    void VeModel::bind(VkCommandBuffer commandBuffer, VkBuffer vertices){
+        VkBuffer buffers[] = {vertices, colorBuffer->getBuffer()};
+        VkDeviceSize offsets[] = {0, 0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
         if(hasIndexBuffer){
-            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, indexType);
         }
     }
     void VeModel::draw(VkCommandBuffer commandBuffer){
@@ -114,44 +170,85 @@ namespace ve{
             vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, 0);
         }
     }
-    void VeModel::updateAnimation(float deltaTime, int frameCounter, int frameIndex){
-        if(hasAnimation){
-            animationManager->update(deltaTime, *skeleton, frameCounter);
-            skeleton->update();
-
-
+    float VeModel::advanceAnimation(float deltaTime, int frameCounter){
+        if(!hasAnimation || !animationManager->currentAnimation){
+            clipRunning = false;
+            return 0.0f;
+        }
+        //objects sharing this model update it once per frame
+        if(advanceFrameCount != frameCounter){
+            advanceFrameCount = frameCounter;
+            clipRunning = animationManager->currentAnimation->isRunning();
+            frameAdvance = animationManager->currentAnimation->advance(deltaTime);
+        }
+        return frameAdvance;
+    }
+    void VeModel::applyAimConstraints(){
+        if(aimConstraints.empty()){
+            return;
         }
+        aimConstraints.apply(*skeleton);
+        skeleton->updateDirty();
     }
-    std::vector<VkVertexInputBindingDescription> VeModel::Vertex::getBindingDescriptions(){
-        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+    SkeletonInstancePool::Handle VeModel::acquireSkeletonInstance(){
+        if(!skeletonDefinition){
+            return SkeletonInstancePool::Handle(nullptr, SkeletonInstancePool::Releaser{});
+        }
+        if(!skeletonInstances){
+            skeletonInstances = std::make_unique<SkeletonInstancePool>(skeletonDefinition, MAX_SKELETON_INSTANCES);
+        }
+        return skeletonInstances->acquire();
+    }
+    std::vector<VkVertexInputBindingDescription> VeModel::getBindingDescriptions(bool vertexColors){
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(2);
         bindingDescriptions[0].binding = 0;
-        bindingDescriptions[0].stride = sizeof(Vertex);
+        bindingDescriptions[0].stride = sizeof(PackedVertex);
         bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        bindingDescriptions[1].binding = 1;
+        bindingDescriptions[1].stride = vertexColors ? sizeof(uint32_t) : 0;
+        bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
         return bindingDescriptions;
     }
-    std::vector<VkVertexInputAttributeDescription> VeModel::Vertex::getAttributeDescriptions(){
+    std::vector<VkVertexInputAttributeDescription> VeModel::getAttributeDescriptions(){
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
-        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)});
-        attributeDescriptions.push_back({1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color)});
-        attributeDescriptions.push_back({2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)});
-        attributeDescriptions.push_back({3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)});
-        attributeDescriptions.push_back({4, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tangent)});
-        attributeDescriptions.push_back({5, 0, VK_FORMAT_R32G32B32A32_SINT, offsetof(Vertex, jointIndices)});
-        attributeDescriptions.push_back({6, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, jointWeights)});
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(PackedVertex, position)});
+        attributeDescriptions.push_back({1, 1, VK_FORMAT_R8G8B8A8_UNORM, 0});
+        attributeDescriptions.push_back({2, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertex, normal)});
+        attributeDescriptions.push_back({3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, uv)});
+        attributeDescriptions.push_back({4, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertex, tangent)});
+        attributeDescriptions.push_back({5, 0, VK_FORMAT_R8G8B8A8_UINT, offsetof(PackedVertex, jointIndices)});
+        attributeDescriptions.push_back({6, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(PackedVertex, jointWeights)});
         return attributeDescriptions;
     }
     
-    std::unique_ptr<VeModel> VeModel::createModelFromFile(VeDevice& device, AAssetManager *assetManager, VeDescriptorPool& descriptorPool, const std::string& filePath){
+    std::unique_ptr<VeModel> VeModel::createModelFromFile(VeDevice& device, AAssetManager *assetManager, VeDescriptorPool& descriptorPool, const std::string& filePath,
+                                                        const AnimationImportSettings& animationSettings){
         Builder builder{};
         std::string extension = filePath.substr(filePath.find_last_of(".") + 1);
         if (extension == "gltf" || extension == "glb") {
             builder.loadModelGLTF(filePath, assetManager);
+            builder.sortSkinJoints();
         }
         
         auto model = std::make_unique<VeModel>(device, builder);
+        if(builder.model.skins.empty()){
+            model->keepCollisionGeometry(builder);
+        }else{
+            if(builder.jointOrder.size() > vertexPacking::INVALID_JOINT){
+                LOGE("Skin of %s has %zu joints, PackedVertex addresses %d, the rest keep the bind pose", filePath.c_str(),
+                     builder.jointOrder.size(), vertexPacking::INVALID_JOINT);
+            }
+        }
         if(extension == "gltf" || extension == "glb"){
-            model->loadSkeleton(builder.model);
-            model->loadAnimations(builder.model);
+            model->loadSkeleton(builder.model, builder.jointOrder);
+            if(model->skeleton && !animationSettings.lodMaskJoints.empty()){
+                size_t masked = model->skeleton->setLodMask(animationSettings.lodMaskJoints);
+                LOGI("Skeleton %s: %zu joints masked for animation LOD", model->skeleton->name.c_str(), masked);
+            }
+            if(model->skeleton){
+                model->skeletonDefinition = SkeletonDefinition::create(*model->skeleton);
+            }
+            model->loadAnimations(builder.model, animationSettings);
         }
         MaterialComponent mat{};
         std::filesystem::path path(filePath);
@@ -176,7 +273,31 @@ namespace ve{
     std::unique_ptr<VeModel> VeModel::createQuad(VeDevice& device){
         Builder builder{};
         builder.loadQuad();
-        return std::make_unique<VeModel>(device, builder);
+        auto model = std::make_unique<VeModel>(device, builder);
+        model->keepCollisionGeometry(builder);
+        return model;
+    }
+    void VeModel::keepCollisionGeometry(const Builder& builder){
+        collisionPositions.resize(builder.vertices.size());
+        for(size_t i = 0; i < builder.vertices.size(); i++){
+            collisionPositions[i] = builder.vertices[i].position;
+        }
+        if(builder.indices.empty()){
+            //non indexed meshes draw the vertices in order
+            collisionIndices.resize(builder.vertices.size());
+            for(size_t i = 0; i < collisionIndices.size(); i++){
+                collisionIndices[i] = static_cast<uint32_t>(i);
+            }
+        }else{
+            collisionIndices = builder.indices;
+        }
+    }
+    void VeModel::buildSkinningVertices(const PackedVertex* packed){
+        //kept in floats so CPU skinning does not decode the directions every frame
+        skinningVertices.resize(vertexCount);
+        for(uint32_t i = 0; i < vertexCount; i++){
+            skinningVertices[i] = SkinningVertex::of(packed[i]);
+        }
     }
 //    void VeModel::Builder::loadModel(const std::string& filePath, AAssetManager *assetManager){
 //        tinyobj::attrib_t attrib;
@@ -262,6 +383,69 @@ namespace ve{
 //        }
 //    }
 //
+    void VeModel::Builder::sortSkinJoints(){
+        jointOrder.clear();
+        if(model.skins.empty())
+            return;
+        const auto& skinJoints = model.skins[0].joints;
+        size_t numJoints = skinJoints.size();
+        std::unordered_map<int, int> skinIndexOfNode;
+        for(size_t i = 0; i < numJoints; i++){
+            skinIndexOfNode[skinJoints[i]] = static_cast<int>(i);
+        }
+        std::vector<uint8_t> hasParent(numJoints, 0);
+        for(size_t i = 0; i < numJoints; i++){
+            for(int child : model.nodes[skinJoints[i]].children){
+                auto it = skinIndexOfNode.find(child);
+                if(it != skinIndexOfNode.end())
+                    hasParent[it->second] = 1;
+            }
+        }
+        //preorder walk from every root in skin order
+        std::vector<uint8_t> visited(numJoints, 0);
+        std::vector<int> pending;
+        for(size_t root = 0; root < numJoints; root++){
+            if(hasParent[root])
+                continue;
+            pending.push_back(static_cast<int>(root));
+            while(!pending.empty()){
+                int skinIndex = pending.back();
+                pending.pop_back();
+                if(visited[skinIndex])
+                    continue;
+                visited[skinIndex] = 1;
+                jointOrder.push_back(skinIndex);
+                const auto& children = model.nodes[skinJoints[skinIndex]].children;
+                for(auto child = children.rbegin(); child != children.rend(); ++child){
+                    auto it = skinIndexOfNode.find(*child);
+                    if(it != skinIndexOfNode.end())
+                        pending.push_back(it->second);
+                }
+            }
+        }
+        //joints on a cycle are not reachable from any root, keep them so indices stay valid
+        for(size_t i = 0; i < numJoints; i++){
+            if(!visited[i])
+                jointOrder.push_back(static_cast<int>(i));
+        }
+
+        std::vector<int> jointOfSkinIndex(numJoints);
+        bool isIdentity = true;
+        for(size_t joint = 0; joint < numJoints; joint++){
+            jointOfSkinIndex[jointOrder[joint]] = static_cast<int>(joint);
+            isIdentity = isIdentity && jointOrder[joint] == static_cast<int>(joint);
+        }
+        if(isIdentity)
+            return;
+        for(auto& vertex : vertices){
+            for(int c = 0; c < 4; c++){
+                int skinIndex = vertex.jointIndices[c];
+                if(skinIndex >= 0 && static_cast<size_t>(skinIndex) < numJoints)
+                    vertex.jointIndices[c] = jointOfSkinIndex[skinIndex];
+            }
+        }
+        LOGI("Skin %s: %zu joints reordered parents first", model.skins[0].name.c_str(), numJoints);
+    }
     void VeModel::Builder::loadModelGLTF(const std::string& filePath, AAssetManager *assetManager){
         tinygltf::TinyGLTF loader;
         std::string err;
@@ -707,7 +891,7 @@ namespace ve{
         }
         indices = { 2, 3, 1, 2, 1, 0 };
     }
-    void VeModel::loadSkeleton(const tinygltf::Model& model){
+    void VeModel::loadSkeleton(const tinygltf::Model& model, const std::vector<int>& jointOrder){
         size_t numSkeletons = model.skins.size();
         if(!numSkeletons)
             return;
@@ -735,15 +919,16 @@ namespace ve{
             const glm::mat4* inverseBindMatricesData = reinterpret_cast<const glm::mat4*>(
                 &invBuffer.data[invBufferView.byteOffset + invAccessor.byteOffset]);
             
-            // Process each joint
+            // Process each joint, skeleton joint i is skin joint jointOrder[i]
             for (size_t i = 0; i < numJoints; i++) {
-                int jointNodeIdx = skin.joints[i];
+                size_t skinIndex = jointOrder.size() == numJoints ? jointOrder[i] : i;
+                int jointNodeIdx = skin.joints[skinIndex];
                 
                 // Setup joint data
                 joints[i].name = model.nodes[jointNodeIdx].name;
                 skeleton->nodeJointMap[jointNodeIdx] = i;
                 //  inverse bind matrix
-                joints[i].inverseBindMatrix = inverseBindMatricesData[i];
+                joints[i].inverseBindMatrix = inverseBindMatricesData[skinIndex];
                  // local world magtrix
                 // extractNodeTransform(model.nodes[jointNodeIdx], joints[i]);
                 // joints[i].jointWorldMatrix = calculateLocalTransform(joints[i]);
@@ -766,29 +951,24 @@ namespace ve{
                 }else{
                     joints[i].jointWorldMatrix = glm::mat4(1.0f);
                 }
-                skeleton->nodeJointMap[jointNodeIdx] = i;
+                joints[i].parentIndex = NO_PARENT;
             }
-            int rootJoint = skin.joints[0];
-            loadJoints(rootJoint, -1, model);
+            //hierarchy between joints only, child nodes that are not joints (meshes, attachments) are skipped
+            for (size_t i = 0; i < numJoints; i++) {
+                for(int childNode : model.nodes[skin.joints[jointOrder.size() == numJoints ? jointOrder[i] : i]].children){
+                    auto child = skeleton->nodeJointMap.find(childNode);
+                    if(child == skeleton->nodeJointMap.end())
+                        continue;
+                    joints[i].childrenIndices.push_back(child->second);
+                    joints[child->second].parentIndex = static_cast<int>(i);
+                }
+            }
+            skeleton->buildHierarchy();
             // updateJointHierarchy(model);
         }
         
     }
-    void VeModel::loadJoints(int nodeIndex, int parentIndex, const tinygltf::Model& model){
-        int currentJoint = skeleton->nodeJointMap[nodeIndex];
-        auto& joint = skeleton->joints[currentJoint];
-        joint.parentIndex = parentIndex;
-        size_t numChildren = model.nodes[nodeIndex].children.size();
-        if(numChildren>0){
-            joint.childrenIndices.resize(numChildren);
-            for(size_t i = 0; i < numChildren; i++){
-                int childNodeIndex = model.nodes[nodeIndex].children[i];
-                joint.childrenIndices[i] = skeleton->nodeJointMap[childNodeIndex];
-                loadJoints(childNodeIndex, currentJoint, model);
-            }
-        }
-    }
-    void VeModel::loadAnimations(const tinygltf::Model& model){
+    void VeModel::loadAnimations(const tinygltf::Model& model, const AnimationImportSettings& settings){
         if(!skeleton){
             LOGE("Error: Skeleton not loaded");
             return;
@@ -799,9 +979,22 @@ namespace ve{
             return;
         }
         animationManager = std::make_shared<AnimationManager>();
+        size_t dedupSamplers = 0;
+        size_t dedupHits = 0;
+        size_t dedupBytesSaved = 0;
         for(size_t i = 0; i < numAnimations; i++){
             const tinygltf::Animation& animation = model.animations[i];
             std::string name = animation.name.empty() ? "animation" + std::to_string(i) : animation.name;
+            //clips of the set another model already loaded skip the accessor parsing entirely
+            bool shareClips = settings.clipLibrary && !settings.clipSet.empty();
+            if(shareClips){
+                if(auto shared = settings.clipLibrary->instantiate(settings.clipSet, name, *skeleton)){
+                    shared->getBinding(*skeleton);
+                    animationManager->push(shared);
+                    LOGI("Animation loaded from library: %s", name.c_str());
+                    continue;
+                }
+            }
             std::shared_ptr<Animation> anim = std::make_shared<Animation>(name);
             //samplers
             size_t numSamplers = animation.samplers.size();
@@ -915,10 +1108,45 @@ namespace ve{
                     LOGE("Unknown channel target path: %s", gltfChannel.target_path.c_str());
                 }
             }
+            const ClipImportSettings& clipSettings = settings.forClip(name);
+            if(clipSettings.reduceKeys){
+                //baking resamples every key back onto a uniform rate, reducing first would only add error
+                if(clipSettings.bakeRate > 0.0f)
+                    LOGI("Animation %s: key reduction skipped, clip is baked at %.1f Hz", name.c_str(), clipSettings.bakeRate);
+                else
+                    anim->reduceKeys(*skeleton, clipSettings.reduction);
+            }
+            if(clipSettings.bakeRate > 0.0f){
+                anim->bake(clipSettings.bakeRate, clipSettings.maxRotationError, clipSettings.maxLinearError);
+            }
+            if(clipSettings.compress){
+                anim->compress();
+            }
+            if(clipSettings.deduplicate){
+                //identical curves of other clips and models end up sharing one immutable key set
+                for(auto& sampler : anim->samplers){
+                    if(sampler.compressed)
+                        continue;
+                    size_t saved = sampler.share();
+                    dedupSamplers++;
+                    dedupHits += saved ? 1 : 0;
+                    dedupBytesSaved += saved;
+                }
+            }
+            if(shareClips){
+                settings.clipLibrary->add(settings.clipSet, anim, *skeleton);
+            }
+            //resolve channel targets once, this also reports channels outside the skin
+            anim->getBinding(*skeleton);
             animationManager->push(anim);
-            LOGI("Animation loaded: %s", anim->getName().c_str());
+            LOGI("Animation loaded: %s (%zu bytes)", anim->getName().c_str(), anim->getMemoryUsage());
         }
         this->hasAnimation = (animationManager->size()) ? true : false;
+        if(dedupSamplers){
+            auto stats = SamplerStore::global().getStats();
+            LOGI("Sampler dedup: %zu of %zu samplers shared, %zu bytes saved (all models: %zu hits, %zu bytes saved, %zu unique key sets / %zu bytes)",
+                 dedupHits, dedupSamplers, dedupBytesSaved, stats.hits, stats.bytesSaved, stats.uniqueSamplers, stats.uniqueBytes);
+        }
     }
     // Extract translation, rotation, and scale from a node
     void VeModel::extractNodeTransform(const tinygltf::Node& node, Joint& joint) {
@@ -168,8 +168,8 @@ namespace ve{
         configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
         configInfo.dynamicStateInfo.flags = 0;
 
-        configInfo.vertexBindingDescriptions = VeModel::Vertex::getBindingDescriptions();
-        configInfo.vertexAttributeDescriptions = VeModel::Vertex::getAttributeDescriptions();
+        configInfo.vertexBindingDescriptions = VeModel::getBindingDescriptions();
+        configInfo.vertexAttributeDescriptions = VeModel::getAttributeDescriptions();
     }
     void VePipeline::enableAlphaBlending(PipelineConfigInfo& configInfo){
         //enable blending
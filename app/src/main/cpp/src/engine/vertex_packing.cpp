@@ -0,0 +1,90 @@
+#include "vertex_packing.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ve::vertexPacking{
+    namespace{
+        glm::vec2 signNotZero(const glm::vec2& v){
+            return {v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f};
+        }
+
+        //glm::packSnorm2x16 for one component of [-1, 1]: rounds half away from zero without a libm call or a
+        //branch on the sign, which skinned normals flip unpredictably. CpuSkinning encodes two per vertex and frame
+        uint32_t snorm16(float value){
+            float scaled = value * 32767.0f;
+            auto quantized = static_cast<int32_t>(scaled + std::copysign(0.5f, scaled));
+            return static_cast<uint16_t>(static_cast<int16_t>(quantized));
+        }
+    }
+
+    uint32_t packOctahedral(const glm::vec3& v){
+        float ax = std::abs(v.x);
+        float ay = std::abs(v.y);
+        float l1 = ax + ay + std::abs(v.z);
+        if(l1 == 0.0f){
+            //decodes to +z, like a missing tangent the shaders never read
+            return 0;
+        }
+        //|e.x| + |e.y| <= 1, no clamp needed
+        float inverse = 1.0f / l1;
+        float ex = v.x * inverse;
+        float ey = v.y * inverse;
+        //lower hemisphere folds over the diagonals, selected rather than branched on for the same reason.
+        //copysign gives -0 a negative side, both sides decode to x = 0 there
+        bool lower = v.z < 0.0f;
+        float fx = (1.0f - ay * inverse) * std::copysign(1.0f, v.x);
+        float fy = (1.0f - ax * inverse) * std::copysign(1.0f, v.y);
+        return snorm16(lower ? fx : ex) | (snorm16(lower ? fy : ey) << 16);
+    }
+
+    glm::vec3 unpackOctahedral(uint32_t packed){
+        glm::vec2 e = glm::unpackSnorm2x16(packed);
+        glm::vec3 v(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        if(v.z < 0.0f){
+            glm::vec2 folded = (1.0f - glm::abs(glm::vec2(v.y, v.x))) * signNotZero(glm::vec2(v.x, v.y));
+            v.x = folded.x;
+            v.y = folded.y;
+        }
+        return glm::normalize(v);
+    }
+
+    uint32_t packHalf2(const glm::vec2& v){
+        return glm::packHalf2x16(v);
+    }
+
+    glm::vec2 unpackHalf2(uint32_t packed){
+        return glm::unpackHalf2x16(packed);
+    }
+
+    uint32_t packJoints(const glm::ivec4& joints){
+        uint32_t packed = 0;
+        for(int i = 0; i < 4; i++){
+            int joint = joints[i] >= 0 && joints[i] < INVALID_JOINT ? joints[i] : INVALID_JOINT;
+            packed |= static_cast<uint32_t>(joint) << (8 * i);
+        }
+        return packed;
+    }
+
+    glm::ivec4 unpackJoints(uint32_t packed){
+        return {static_cast<int>(packed & 0xFFu), static_cast<int>((packed >> 8) & 0xFFu),
+                static_cast<int>((packed >> 16) & 0xFFu), static_cast<int>(packed >> 24)};
+    }
+
+    void packWeights(const glm::vec4& weights, uint16_t packed[4]){
+        for(int i = 0; i < 4; i++)
+            packed[i] = static_cast<uint16_t>(std::lround(std::clamp(weights[i], 0.0f, 1.0f) * 65535.0f));
+    }
+
+    glm::vec4 unpackWeights(const uint16_t packed[4]){
+        return glm::vec4(packed[0], packed[1], packed[2], packed[3]) * (1.0f / 65535.0f);
+    }
+
+    bool isWhite(const glm::vec3& color){
+        return glm::all(glm::greaterThanEqual(color, glm::vec3(1.0f - 0.5f / 255.0f)));
+    }
+
+    uint32_t packColor(const glm::vec3& color){
+        return glm::packUnorm4x8(glm::vec4(color, 1.0f));
+    }
+}
@@ -97,7 +97,8 @@ namespace ve {
                     sizeof(SimplePushConstantData),
                     &push
                 );
-                obj.model->bind(frameInfo.commandBuffer);
+                //the outline shader does not skin, pre-skinned vertices give animated objects a posed outline
+                obj.bindModel(frameInfo.commandBuffer, frameInfo.frameIndex);
                 obj.model->draw(frameInfo.commandBuffer);
             }
         }
@@ -15,6 +15,10 @@ namespace ve {
         float smoothness{0.0f};
 //        glm::vec3 baseColor{1.0f};
         bool isAnimated{false};
+        VkBool32 dualQuaternion{VK_FALSE};
+        //the object's palette in the joint palette ring (set 1), in vec4s
+        uint32_t jointBase{0};
+        uint32_t jointCount{0};
     };
 
     PbrRenderSystem::PbrRenderSystem(
@@ -61,11 +65,19 @@ namespace ve {
             "shaders/pbr_shader.vert.spv",
             "shaders/pbr_shader.frag.spv",
             pipelineConfig);
+        pipelineConfig.vertexBindingDescriptions = VeModel::getBindingDescriptions(true);
+        vertexColorPipeline = std::make_unique<VePipeline>(
+            veDevice,
+            assetManager,
+            "shaders/pbr_shader.vert.spv",
+            "shaders/pbr_shader.frag.spv",
+            pipelineConfig);
     }
     
     
     void PbrRenderSystem::renderGameObjects(FrameInfo& frameInfo, const std::vector<VkDescriptorSet>& descriptorSets) {
-        vePipeline->bind(frameInfo.commandBuffer);
+        VePipeline* boundPipeline = vePipeline.get();
+        boundPipeline->bind(frameInfo.commandBuffer);
         vkCmdBindDescriptorSets(
             frameInfo.commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -79,17 +91,22 @@ namespace ve {
         for(auto& key_value : frameInfo.gameObjects){
             auto& obj = key_value.second;
             if(obj.lightComponent == nullptr && obj.cubeMapComponent == nullptr){
+                //both pipelines share the layout, the bound descriptor sets stay valid
+                VePipeline* pipeline = obj.model->hasVertexColors() ? vertexColorPipeline.get() : vePipeline.get();
+                if(pipeline != boundPipeline){
+                    boundPipeline = pipeline;
+                    boundPipeline->bind(frameInfo.commandBuffer);
+                }
                 PbrPushConstantData push{};
                 push.modelMatrix =  obj.transform.mat4();
                 push.textureIndex = obj.getTextureIndex();
                 push.smoothness = obj.getSmoothness();
-                if(obj.model->hasAnimationData()){
-                    push.isAnimated = true;
-                    
-                }else{
-//                    LOGI("Object is not animated, object: %s", obj.getTitle());
-                    push.isAnimated = false;
-                }
+                //pre-skinned vertices are drawn as static geometry
+                push.isAnimated = obj.bindModel(frameInfo.commandBuffer, frameInfo.frameIndex);
+                push.dualQuaternion = obj.model->skinningMethod == SkinningMethod::DualQuaternion;
+                auto palette = obj.getJointPalette(frameInfo.frameIndex);
+                push.jointBase = palette.base;
+                push.jointCount = palette.jointCount;
                 vkCmdPushConstants(
                     frameInfo.commandBuffer,
                     pipelineLayout,
@@ -98,7 +115,6 @@ namespace ve {
                     sizeof(PbrPushConstantData),
                     &push
                 );
-                obj.model->bind(frameInfo.commandBuffer);
                 obj.model->draw(frameInfo.commandBuffer);
             }
         }
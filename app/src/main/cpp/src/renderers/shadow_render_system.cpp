@@ -94,10 +94,12 @@ namespace ve{
             ShadowPushConstants push{};
             push.mvpMatrix = viewProjMatrix * obj.transform.mat4();
             push.lightPos = lightPos;
-            if(obj.model->hasAnimationData())
-                push.isAnimated=true;
-            else
-                push.isAnimated=false;
+            //skinned once per frame by SkinningSystem instead of once per face
+            push.isAnimated = obj.bindModel(commandBuffer, frameInfo.frameIndex);
+            push.dualQuaternion = obj.model->skinningMethod == SkinningMethod::DualQuaternion;
+            auto palette = obj.getJointPalette(frameInfo.frameIndex);
+            push.jointBase = palette.base;
+            push.jointCount = palette.jointCount;
 
             vkCmdPushConstants(
                     commandBuffer,
@@ -108,7 +110,6 @@ namespace ve{
                     &push
             );
 
-            obj.model->bind(commandBuffer);
             obj.model->draw(commandBuffer);
         }
     }
@@ -0,0 +1,257 @@
+#include "skinning_system.hpp"
+#include "utility.hpp"
+#include "debug.hpp"
+
+#include <stdexcept>
+#include <cassert>
+namespace ve {
+    struct SkinningPushConstantData {
+        uint32_t vertexCount{0};
+        uint32_t dualQuaternion{0};
+        //the object's palette in the joint palette ring, in vec4s
+        uint32_t jointBase{0};
+        uint32_t jointCount{0};
+    };
+
+    SkinningSystem::SkinningSystem(VeDevice& device, AAssetManager *assetManager, VkDescriptorSetLayout jointPaletteSetLayout): veDevice{device} {
+        if(assetManager==nullptr)
+            throw std::runtime_error("SkinningSystem::SkinningSystem: assetManager is nullptr");
+        createDescriptorSetLayout();
+        createPipelineLayout(jointPaletteSetLayout);
+        createPipeline(assetManager);
+    }
+    SkinningSystem::~SkinningSystem() {
+        vkDestroyPipeline(veDevice.device(), pipeline, nullptr);
+        vkDestroyPipelineLayout(veDevice.device(), pipelineLayout, nullptr);
+    }
+
+    void SkinningSystem::createDescriptorSetLayout() {
+        skinningSetLayout = VeDescriptorSetLayout::Builder(veDevice)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .build();
+    }
+    void SkinningSystem::createPipelineLayout(VkDescriptorSetLayout jointPaletteSetLayout) {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(SkinningPushConstantData);
+
+        //per object vertices, then the frame's joint palettes shared by every object
+        VkDescriptorSetLayout setLayouts[2] = {skinningSetLayout->getDescriptorSetLayout(), jointPaletteSetLayout};
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 2;
+        pipelineLayoutInfo.pSetLayouts = setLayouts;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(veDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create skinning pipeline layout!");
+        }
+    }
+    void SkinningSystem::createPipeline(AAssetManager *assetManager) {
+        assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+        auto code = loadBinaryFileToVector("shaders/skinning.comp.spv", assetManager);
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size();
+        moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+        VkShaderModule shaderModule;
+        if (vkCreateShaderModule(veDevice.device(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create skinning shader module!");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+        VkResult result = vkCreateComputePipelines(veDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+        //the pipeline keeps what it needs from the module
+        vkDestroyShaderModule(veDevice.device(), shaderModule, nullptr);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create skinning pipeline!");
+        }
+    }
+
+    bool SkinningSystem::prepare(VeGameObject& obj, int frameIndex, VeDescriptorPool& descriptorPool) {
+        auto& component = *obj.animationComponent;
+        auto& skinned = component.skinnedVertices[frameIndex];
+        //a model whose float bind pose was released is decoded again from a fresh copy
+        bool bindPoseReady = mode != Mode::Cpu || obj.model->getSkinningVertices().size() == obj.model->getVertexCount();
+        if (skinned.model == obj.model && skinned.hostVisible == (mode == Mode::Cpu) && bindPoseReady) {
+            return true;
+        }
+        //beginFrame waited for this frame's last submission, nothing reads the old buffer anymore
+        skinned.model.reset();
+        if (mode == Mode::Cpu) {
+            return prepareHostVisible(obj, frameIndex);
+        }
+        uint32_t vertexCount = obj.model->getVertexCount();
+        auto vertexSize = static_cast<uint32_t>(sizeof(PackedVertex));
+        VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexSize) * vertexCount;
+        if (!skinned.buffer || skinned.hostVisible || skinned.buffer->getBufferSize() != bufferSize) {
+            skinned.hostVisible = false;
+            skinned.buffer = std::make_unique<VeBuffer>(veDevice, vertexSize, vertexCount,
+                                                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+        //uv, joints and weights never change, the compute pass only rewrites position, normal and tangent
+        veDevice.copyBuffer(obj.model->getVertexBuffer(), skinned.buffer->getBuffer(), bufferSize);
+
+        VkDescriptorBufferInfo sourceInfo{obj.model->getVertexBuffer(), 0, bufferSize};
+        auto skinnedInfo = skinned.buffer->descriptorInfo();
+        VeDescriptorWriter writer(*skinningSetLayout, descriptorPool);
+        writer.writeBuffer(0, &sourceInfo)
+              .writeBuffer(1, &skinnedInfo);
+        if (skinned.descriptorSet == VK_NULL_HANDLE) {
+            if (!writer.build(skinned.descriptorSet)) {
+                LOGE("Object %d: no descriptor set for skinning, drawn with shader skinning", obj.getId());
+                skinned.model.reset();
+                return false;
+            }
+        } else {
+            writer.overwrite(skinned.descriptorSet);
+        }
+        skinned.model = obj.model;
+        return true;
+    }
+    bool SkinningSystem::prepareHostVisible(VeGameObject& obj, int frameIndex) {
+        auto& skinned = obj.animationComponent->skinnedVertices[frameIndex];
+        auto vertexSize = static_cast<uint32_t>(sizeof(PackedVertex));
+        uint32_t vertexCount = obj.model->getVertexCount();
+        VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexSize) * vertexCount;
+        if (!skinned.buffer || !skinned.hostVisible || skinned.buffer->getBufferSize() != bufferSize) {
+            skinned.buffer = std::make_unique<VeBuffer>(veDevice, vertexSize, vertexCount,
+                                                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            skinned.buffer->map();
+            skinned.hostVisible = true;
+        }
+        //static attributes once from the packed model buffer, every frame rewrites position, normal and tangent only
+        veDevice.copyBuffer(obj.model->getVertexBuffer(), skinned.buffer->getBuffer(), bufferSize);
+        if (obj.model->getSkinningVertices().size() != vertexCount) {
+            //the first Cpu mode frame of this model decodes its bind pose from the copy that just arrived
+            skinned.buffer->invalidate();
+            obj.model->buildSkinningVertices(static_cast<const PackedVertex*>(skinned.buffer->getMappedMemory()));
+        }
+        skinned.model = obj.model;
+        return true;
+    }
+    void SkinningSystem::skinOnCpu(VeGameObject& obj, int frameIndex) {
+        auto& component = *obj.animationComponent;
+        auto& skinned = component.skinnedVertices[frameIndex];
+        if (!cpuSkinning) {
+            cpuSkinning = std::make_unique<CpuSkinning>();
+            LOGI("CPU skinning on %u threads", cpuSkinning->getThreadCount());
+        }
+        //the pose the joint buffer was written from
+        const glm::mat4* palette = obj.model->skeleton->jointMatrices.data();
+        size_t jointCount = obj.model->skeleton->jointMatrices.size();
+        if (component.skeletonInstance) {
+            palette = component.skeletonInstance->palette;
+            jointCount = component.skeletonInstance->getJointCount();
+        }
+        const auto& vertices = obj.model->getSkinningVertices();
+        if (obj.model->skinningMethod == SkinningMethod::DualQuaternion) {
+            //converted when the joint buffer was written, only a pose that was never written is converted here
+            auto& dualQuaternions = component.dualQuaternionPalette;
+            if (dualQuaternions.empty()) {
+                dualQuaternions.resize(jointCount);
+                dualQuaternion::fromMatrices(palette, jointCount, dualQuaternions.data());
+            }
+            cpuStats = cpuSkinning->skin(vertices.data(), SkinningLayout::of<SkinningVertex>(), skinned.buffer->getMappedMemory(), vertices.size(),
+                                         SkinningLayout::of<PackedVertex>(), dualQuaternions.data(), dualQuaternions.size());
+        } else {
+            cpuStats = cpuSkinning->skin(vertices.data(), SkinningLayout::of<SkinningVertex>(), skinned.buffer->getMappedMemory(), vertices.size(),
+                                         SkinningLayout::of<PackedVertex>(), palette, jointCount);
+        }
+        skinned.buffer->flush();
+    }
+
+    size_t SkinningSystem::skinGameObjects(FrameInfo& frameInfo, VeDescriptorPool& descriptorPool) {
+        size_t skinnedObjects = 0;
+        size_t dispatches = 0;
+        for (auto& [id, obj] : frameInfo.gameObjects) {
+            if (!obj.model || !obj.animationComponent || !obj.model->hasAnimationData()) {
+                continue;
+            }
+            //not updated this frame, drawn in the bind pose
+            auto palette = obj.getJointPalette(frameInfo.frameIndex);
+            if (palette.jointCount == 0) {
+                continue;
+            }
+            if (mode != Mode::Cpu && !obj.model->getSkinningVertices().empty()) {
+                //left Cpu mode, only skinOnCpu reads the float bind pose
+                obj.model->releaseSkinningVertices();
+            }
+            if (!prepare(obj, frameInfo.frameIndex, descriptorPool)) {
+                continue;
+            }
+            skinnedObjects++;
+            if (mode == Mode::Cpu) {
+                //host writes are visible to the submission, no barrier
+                skinOnCpu(obj, frameInfo.frameIndex);
+                continue;
+            }
+            if (dispatches == 0) {
+                vkCmdBindPipeline(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+                vkCmdBindDescriptorSets(
+                    frameInfo.commandBuffer,
+                    VK_PIPELINE_BIND_POINT_COMPUTE,
+                    pipelineLayout,
+                    1,
+                    1,
+                    &frameInfo.animatedDescriptorSet,
+                    0,
+                    nullptr
+                );
+            }
+            auto& skinned = obj.animationComponent->skinnedVertices[frameInfo.frameIndex];
+            vkCmdBindDescriptorSets(
+                frameInfo.commandBuffer,
+                VK_PIPELINE_BIND_POINT_COMPUTE,
+                pipelineLayout,
+                0,
+                1,
+                &skinned.descriptorSet,
+                0,
+                nullptr
+            );
+            SkinningPushConstantData push{};
+            push.vertexCount = obj.model->getVertexCount();
+            push.dualQuaternion = obj.model->skinningMethod == SkinningMethod::DualQuaternion;
+            push.jointBase = palette.base;
+            push.jointCount = palette.jointCount;
+            vkCmdPushConstants(
+                frameInfo.commandBuffer,
+                pipelineLayout,
+                VK_SHADER_STAGE_COMPUTE_BIT,
+                0,
+                sizeof(SkinningPushConstantData),
+                &push
+            );
+            vkCmdDispatch(frameInfo.commandBuffer, (push.vertexCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+            dispatches++;
+        }
+        if (dispatches > 0) {
+            //one barrier for every dispatch: the skinned vertices are read as vertex attributes from here on
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+            vkCmdPipelineBarrier(
+                frameInfo.commandBuffer,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                0,
+                1, &barrier,
+                0, nullptr,
+                0, nullptr
+            );
+        }
+        return skinnedObjects;
+    }
+}
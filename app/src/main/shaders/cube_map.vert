@@ -1,10 +1,10 @@
 #version 450
 layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 color;
-layout(location = 2) in vec3 normal;
+layout(location = 1) in vec4 color;      //binding 1, white for models without vertex colors
+layout(location = 2) in vec2 normalOct;  //octahedral, see vertex_packing.hpp
 layout(location = 3) in vec2 uv;
-layout(location = 4) in vec3 tangent;
-layout(location = 5) in ivec4 joints;
+layout(location = 4) in vec2 tangentOct;
+layout(location = 5) in uvec4 joints;
 layout(location = 6) in vec4 weights;
 layout(location = 0) out vec3 fragUVW;
 
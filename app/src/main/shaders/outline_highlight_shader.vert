@@ -1,10 +1,11 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 color;
-layout(location = 2) in vec3 normal;
+layout(location = 1) in vec4 color;      //binding 1, white for models without vertex colors
+layout(location = 2) in vec2 normalOct;  //octahedral, see vertex_packing.hpp
 layout(location = 3) in vec2 uv;
-layout(location = 4) in vec3 tangent;
-layout(location = 5) in ivec4 joints;
+layout(location = 4) in vec2 tangentOct;
+layout(location = 5) in uvec4 joints;
 layout(location = 6) in vec4 weights;
 layout(location = 0) out vec3 fragColor;
 
@@ -34,7 +35,10 @@ layout(push_constant) uniform Push {
 
 float outline_thickness = 0.1;
 vec3 outline_color = vec3(1.0, 1.0, 0.3);
+#include "vertex_packing.glsl"
+
 void main(){
+    vec3 normal = octDecode(normalOct);
     vec4 positionWorld = vec4(position - normal * outline_thickness , 1.0);
     positionWorld = push.modelMatrix * positionWorld;
     gl_Position = ubo.projectionMatrix * (ubo.viewMatrix * positionWorld);
@@ -23,9 +23,9 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
     int selectedLight;
     float time;
 } ubo;
-layout(set = 1, binding = 0) uniform JointMatrixBufferObject {
-    mat4 jointMatrices[200];
-} jmbo;
+layout(set = 1, binding = 0) readonly buffer JointPalettes {
+    vec4 jointData[];
+} palettes;
 layout(set = 2, binding = 0) uniform sampler2D albedoSampler;
 layout(set = 3, binding = 0) uniform samplerCubeShadow shadowCubeMaps[2];
 
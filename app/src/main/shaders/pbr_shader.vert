@@ -1,11 +1,12 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 //vertex input
 layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 color;
-layout(location = 2) in vec3 normal;
+layout(location = 1) in vec4 color;      //binding 1, white for models without vertex colors
+layout(location = 2) in vec2 normalOct;  //octahedral, see vertex_packing.hpp
 layout(location = 3) in vec2 uv;
-layout(location = 4) in vec3 tangent;
-layout(location = 5) in ivec4 joints;
+layout(location = 4) in vec2 tangentOct;
+layout(location = 5) in uvec4 joints;
 layout(location = 6) in vec4 weights;
 
 //outputs to fragment shader
@@ -33,9 +34,10 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
 } ubo;
 
 
-layout(set = 1, binding = 0) uniform JointMatrixBufferObject {
-    mat4 jointMatrices[200];
-} jmbo;
+//JointPaletteRing: every animated object's palette, this one's starts at push.jointBase
+layout(set = 1, binding = 0) readonly buffer JointPalettes {
+    vec4 jointData[];
+} palettes;
 layout(set = 2, binding = 0) uniform sampler2D albedoSampler;
 layout(set = 3, binding = 0) uniform samplerCubeShadow shadowCubeMaps[2];
 
@@ -45,53 +47,41 @@ layout(push_constant) uniform Push {
     float smoothness;
 //    vec3 baseColor;
     bool isAnimated;
+    bool dualQuaternion;
+    uint jointBase;
+    uint jointCount;
 } push;
 
+#include "skinning.glsl"
+#include "vertex_packing.glsl"
+
 void main() {
+    vec3 normal = octDecode(normalOct);
     mat4 skinMatrix = mat4(1.0);
     vec4 skinnedPosition = vec4(position, 1.0);
     vec3 skinnedNormal = normal;
 
-    fragColor = color;
+    fragColor = color.rgb;
 
     // Apply skinning if needed
-    if (push.isAnimated) {
-        skinMatrix = mat4(0.0);
-        skinnedPosition = vec4(0.0);
-        skinnedNormal = vec3(0.0);
-
-        float totalWeight = 0.0;
-        for (int i = 0; i < 4; i++) {
-            if (weights[i] == 0.0) continue;
-            if (joints[i] >= 200) {
-                // Invalid joint, use identity
-                skinMatrix = mat4(1.0);
-                skinnedPosition = vec4(position, 1.0);
-                skinnedNormal = normal;
-                break;
-            }
-
-            totalWeight += weights[i];
-
-            // Check for problematic joint matrices
-            if (determinant(mat3(jmbo.jointMatrices[joints[i]])) < 0.0) {
-                // Debug: color problematic joints red
+    if (push.isAnimated && push.dualQuaternion) {
+        //rigid per vertex, skinMatrix stays identity for the normal matrix
+        vec4 real, dual;
+        if (blendDualQuaternions(joints, weights, real, dual)) {
+            skinnedPosition = vec4(dqTransform(real, dual, position), 1.0);
+            skinnedNormal = dqRotate(real, normal);
+        }
+    } else if (push.isAnimated) {
+        //an invalid joint or no weight keeps the bind pose with an identity skinMatrix
+        mat4 blended;
+        if (blendJointMatrices(joints, weights, blended)) {
+            skinMatrix = blended;
+            skinnedPosition = skinMatrix * vec4(position, 1.0);
+            skinnedNormal = normalize(mat3(skinMatrix) * normal);
+            // Debug: color mirrored skin matrices red
+            if (determinant(mat3(skinMatrix)) < 0.0) {
                 fragColor = vec3(1.0, 0.0, 0.0);
             }
-
-            // Blend position and normal
-            vec4 localPosition = jmbo.jointMatrices[joints[i]] * vec4(position, 1.0);
-            vec3 localNormal = mat3(jmbo.jointMatrices[joints[i]]) * normal;
-
-            skinnedPosition += localPosition * weights[i];
-            skinnedNormal += localNormal * weights[i];
-            skinMatrix += jmbo.jointMatrices[joints[i]] * weights[i];
-        }
-
-        // Normalize if we have valid weights
-        if (totalWeight > 0.0) {
-            skinnedPosition /= totalWeight;
-            skinnedNormal = normalize(skinnedNormal);
         }
     }
 
@@ -1,26 +1,33 @@
 // shadow shader vert
 #version 450
+#extension GL_GOOGLE_include_directive : require
 //shadow depth vert
 layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 color;
-layout(location = 2) in vec3 normal;
+layout(location = 1) in vec4 color;      //binding 1, white for models without vertex colors
+layout(location = 2) in vec2 normalOct;  //octahedral, see vertex_packing.hpp
 layout(location = 3) in vec2 uv;
-layout(location = 4) in vec3 tangent;
-layout(location = 5) in ivec4 joints;
+layout(location = 4) in vec2 tangentOct;
+layout(location = 5) in uvec4 joints;
 layout(location = 6) in vec4 weights;
 
 // Add joint matrices for animation
-layout(set = 0, binding = 0) uniform JointMatrixBufferObject {
-    mat4 jointMatrices[200];
-} jmbo;
+//JointPaletteRing: every animated object's palette, this one's starts at push.jointBase
+layout(set = 0, binding = 0) readonly buffer JointPalettes {
+    vec4 jointData[];
+} palettes;
 
 // Push constants for shadow pass
 layout(push_constant) uniform Push {
     mat4 mvpMatrix;     // Model-View-Projection from light's perspective
     vec3 lightPos;      // Light position in world space
     bool isAnimated;    // Whether this object is animated
+    bool dualQuaternion; // Joint buffer holds dual quaternions instead of matrices
+    uint jointBase;     // First vec4 of this object's palette
+    uint jointCount;
 } push;
 
+#include "skinning.glsl"
+
 // Output to fragment shader
 layout(location = 0) out vec3 fragWorldPos;
 layout(location = 1) out vec3 fragLightPos;
@@ -31,28 +38,15 @@ void main() {
     float lightRadius = 30.0;
 
     // Apply skinning if needed (same logic as PBR shader)
-    if (push.isAnimated) {
-        skinnedPosition = vec4(0.0);
-
-        float totalWeight = 0.0;
-        for (int i = 0; i < 4; i++) {
-            if (weights[i] == 0.0) continue;
-            if (joints[i] >= 200) {
-                // Invalid joint, use original position
-                skinnedPosition = vec4(position, 1.0);
-                break;
-            }
-
-            totalWeight += weights[i];
-
-            // Blend position
-            vec4 localPosition = jmbo.jointMatrices[joints[i]] * vec4(position, 1.0);
-            skinnedPosition += localPosition * weights[i];
+    if (push.isAnimated && push.dualQuaternion) {
+        vec4 real, dual;
+        if (blendDualQuaternions(joints, weights, real, dual)) {
+            skinnedPosition = vec4(dqTransform(real, dual, position), 1.0);
         }
-
-        // Normalize if we have valid weights
-        if (totalWeight > 0.0) {
-            skinnedPosition /= totalWeight;
+    } else if (push.isAnimated) {
+        mat4 skinMatrix;
+        if (blendJointMatrices(joints, weights, skinMatrix)) {
+            skinnedPosition = skinMatrix * vec4(position, 1.0);
         }
     }
 
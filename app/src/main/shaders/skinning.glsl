@@ -0,0 +1,58 @@
+//joint palette access and the LBS / dual quaternion blends shared by the vertex shaders and skinning.comp.
+//Include after declaring the JointPalettes buffer as palettes and a push block with jointBase and jointCount.
+
+//joint matrix of the object's palette, four vec4 columns
+mat4 jointMatrix(uint joint) {
+    uint base = push.jointBase + joint * 4u;
+    return mat4(palettes.jointData[base], palettes.jointData[base + 1u], palettes.jointData[base + 2u], palettes.jointData[base + 3u]);
+}
+//SkinningMethod::DualQuaternion palettes hold two vec4s (real, dual) per joint
+vec4 jointReal(uint joint) {
+    return palettes.jointData[push.jointBase + joint * 2u];
+}
+vec4 jointDual(uint joint) {
+    return palettes.jointData[push.jointBase + joint * 2u + 1u];
+}
+vec3 dqRotate(vec4 real, vec3 v) {
+    return v + 2.0 * cross(real.xyz, cross(real.xyz, v) + real.w * v);
+}
+vec3 dqTransform(vec4 real, vec4 dual, vec3 p) {
+    return dqRotate(real, p) + 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+}
+//weighted sum of the vertex's joint matrices divided by the total weight, false to keep the bind pose
+bool blendJointMatrices(uvec4 vertexJoints, vec4 vertexWeights, out mat4 skinMatrix) {
+    skinMatrix = mat4(0.0);
+    float totalWeight = 0.0;
+    for (int i = 0; i < 4; i++) {
+        if (vertexWeights[i] == 0.0) continue;
+        if (vertexJoints[i] >= push.jointCount) return false;
+        skinMatrix += jointMatrix(vertexJoints[i]) * vertexWeights[i];
+        totalWeight += vertexWeights[i];
+    }
+    if (totalWeight <= 0.0) return false;
+    skinMatrix /= totalWeight;
+    return true;
+}
+//normalized weighted sum of the vertex's joints, false to keep the bind pose
+bool blendDualQuaternions(uvec4 vertexJoints, vec4 vertexWeights, out vec4 real, out vec4 dual) {
+    real = vec4(0.0);
+    dual = vec4(0.0);
+    vec4 pivot = vec4(0.0);
+    float totalWeight = 0.0;
+    for (int i = 0; i < 4; i++) {
+        if (vertexWeights[i] == 0.0) continue;
+        if (vertexJoints[i] >= push.jointCount) return false;
+        vec4 jr = jointReal(vertexJoints[i]);
+        //q and -q are the same rotation, blend every joint on the first one's side
+        if (totalWeight == 0.0) pivot = jr;
+        float w = dot(jr, pivot) < 0.0 ? -vertexWeights[i] : vertexWeights[i];
+        real += jr * w;
+        dual += jointDual(vertexJoints[i]) * w;
+        totalWeight += vertexWeights[i];
+    }
+    float len = length(real);
+    if (totalWeight <= 0.0 || len == 0.0) return false;
+    real /= len;
+    dual /= len;
+    return true;
+}
@@ -0,0 +1,16 @@
+//PackedVertex decoding shared by the vertex shaders and the skinning pass, see vertex_packing.hpp
+
+//vertexPacking::unpackOctahedral, e is the R16G16_SNORM pair
+vec3 octDecode(vec2 e) {
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
+//vertexPacking::packOctahedral
+uint octEncode(vec3 v) {
+    float l1 = abs(v.x) + abs(v.y) + abs(v.z);
+    if (l1 == 0.0) return 0u;
+    vec2 e = v.xy / l1;
+    if (v.z < 0.0) e = (1.0 - abs(e.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+    return packSnorm2x16(e);
+}